@@ -0,0 +1,23 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// shader.frag over the bindless texture array, used in its place where descriptor indexing is enabled
+//  Only slots in use are written (the array is partially bound), up to VkResourceManager::textureCapacity
+layout(binding = 1) uniform sampler2D textures[];
+
+// Feature bits, specialized per pipeline (see ShaderFeature); branches on them are folded away by the driver
+layout(constant_id = 0) const bool untextured = false;
+
+layout(location = 0) in vec4 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+// Read per draw from the draw and material buffers; one indirect call runs many draws, so the index may differ within an invocation group
+layout(location = 2) flat in uint fragTextureIndex;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+    outColor = fragColor;
+    if (!untextured)
+        outColor *= texture(textures[nonuniformEXT(fragTextureIndex)], fragTexCoord);
+}
@@ -1,10 +1,20 @@
 #version 450
 
-layout(location = 0) in vec3 fragColor;
+// Must match VkResourceManager::maxTextures; see bindless.frag for the array used with descriptor indexing
+layout(binding = 1) uniform sampler2D textures[16];
+
+// Feature bits, specialized per pipeline (see ShaderFeature); branches on them are folded away by the driver
+layout(constant_id = 0) const bool untextured = false;
+
+layout(location = 0) in vec4 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) flat in uint fragTextureIndex;     // Uniform within a draw; indirect calls never cover several draws with this shader
 
 layout(location = 0) out vec4 outColor;
 
 void main()
 {
-    outColor = vec4(fragColor, 1.0);
-}
\ No newline at end of file
+    outColor = fragColor;
+    if (!untextured)
+        outColor *= texture(textures[fragTextureIndex], fragTexCoord);
+}
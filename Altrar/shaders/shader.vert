@@ -9,11 +9,47 @@ layout(binding = 0) uniform UniformBufferObject {
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec3 inColor;
+layout(location = 3) in vec2 inTexCoord;
 
-layout(location = 0) out vec3 fragColor;
+// Per instance from here on, must match InstanceData and VkResourceManager::instanceInputLocation
+layout(location = 4) in mat4 instanceTransform;
+layout(location = 8) in vec4 instanceColor;
+layout(location = 9) in uint instanceDraw;
+
+// Must match DrawData, indexed by the draw every instance belongs to
+struct DrawData {
+    vec4 bounds;
+    uint textureIndex;
+    uint command;
+    uint material;
+};
+
+layout(std430, binding = 2) readonly buffer DrawDataBuffer {
+    DrawData draws[];
+};
+
+// Must match MaterialData, indexed by the draw's material
+struct MaterialData {
+    vec4 color;
+    uint textureIndex;
+};
+
+layout(std430, binding = 3) readonly buffer MaterialBuffer {
+    MaterialData materials[];
+};
+
+const uint drawTexture = 0xFFFFFFFFu;     // Keeps the texture of the draw
+
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) flat out uint fragTextureIndex;
 
 void main()
 {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
-    fragColor = inColor;
-}
\ No newline at end of file
+    gl_Position = ubo.proj * ubo.view * ubo.model * instanceTransform * vec4(inPosition, 1.0);
+    const DrawData draw = draws[instanceDraw];
+    const MaterialData material = materials[draw.material];
+    fragColor = vec4(inColor, 1.0) * instanceColor * material.color;
+    fragTexCoord = inTexCoord;
+    fragTextureIndex = material.textureIndex == drawTexture ? draw.textureIndex : material.textureIndex;
+}
@@ -0,0 +1,367 @@
+#include "atrpch.h"
+
+#include "ATRAsyncIO.h"
+
+#if defined __linux__ && __has_include(<linux/io_uring.h>)
+#define ATR_IO_URING
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace ATR
+{
+    struct AsyncFileReader::Operation
+    {
+        FileRead read;
+        size_t completed = 0;
+        int descriptor = -1;
+    };
+
+#if defined ATR_IO_URING
+
+    // Submission and completion rings shared with the kernel; only touched by the completion thread
+    struct AsyncFileReader::Ring
+    {
+        int descriptor = -1;
+        int wakeDescriptor = -1;                // eventfd with a read always in flight, so that new submissions interrupt the wait
+        uint64_t wakeValue = 0;
+
+        void* sqRing = MAP_FAILED;
+        void* cqRing = MAP_FAILED;
+        io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+        size_t sqRingSize = 0, cqRingSize = 0, sqesSize = 0;
+
+        unsigned* sqTail = nullptr;
+        unsigned* sqArray = nullptr;
+        unsigned sqMask = 0;
+        unsigned* cqHead = nullptr;
+        unsigned* cqTail = nullptr;
+        unsigned cqMask = 0;
+        io_uring_cqe* cqes = nullptr;
+
+        unsigned entries = 0;
+        unsigned queued = 0;                    // Written to the submission ring, not yet handed to the kernel
+        UInt inFlight = 0;                      // File reads only; the wake read is always in flight on top
+
+        static inline constexpr uint64_t wakeTag = 0;           // Operations are tagged with their address instead
+
+        static std::unique_ptr<Ring> Create(UInt queueDepth)
+        {
+            io_uring_params params = {};
+            std::unique_ptr<Ring> ring = std::make_unique<Ring>();
+            ring->descriptor = static_cast<int>(syscall(__NR_io_uring_setup, queueDepth, &params));
+            if (ring->descriptor < 0)
+                return nullptr;
+
+            // IORING_OP_READ arrived in 5.6, one release before FAST_POLL; older kernels take the fallback
+            if (!(params.features & IORING_FEAT_FAST_POLL))
+                return nullptr;
+
+            ring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            ring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            if (params.features & IORING_FEAT_SINGLE_MMAP)
+                ring->sqRingSize = ring->cqRingSize = std::max(ring->sqRingSize, ring->cqRingSize);
+
+            ring->sqRing = mmap(nullptr, ring->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->descriptor, IORING_OFF_SQ_RING);
+            if (ring->sqRing == MAP_FAILED)
+                return nullptr;
+            if (params.features & IORING_FEAT_SINGLE_MMAP)
+                ring->cqRing = ring->sqRing;
+            else if ((ring->cqRing = mmap(nullptr, ring->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->descriptor, IORING_OFF_CQ_RING)) == MAP_FAILED)
+                return nullptr;
+
+            ring->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+            ring->sqes = static_cast<io_uring_sqe*>(mmap(nullptr, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->descriptor, IORING_OFF_SQES));
+            if (ring->sqes == MAP_FAILED)
+                return nullptr;
+
+            uint8_t* sq = static_cast<uint8_t*>(ring->sqRing);
+            uint8_t* cq = static_cast<uint8_t*>(ring->cqRing);
+            ring->sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+            ring->sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+            ring->sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+            ring->cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+            ring->cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+            ring->cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+            ring->cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+            ring->entries = params.sq_entries;
+
+            ring->wakeDescriptor = eventfd(0, EFD_CLOEXEC);
+            if (ring->wakeDescriptor < 0)
+                return nullptr;
+
+            return ring;
+        }
+
+        ~Ring()
+        {
+            if (this->sqes != MAP_FAILED)
+                munmap(this->sqes, this->sqesSize);
+            if (this->cqRing != MAP_FAILED && this->cqRing != this->sqRing)
+                munmap(this->cqRing, this->cqRingSize);
+            if (this->sqRing != MAP_FAILED)
+                munmap(this->sqRing, this->sqRingSize);
+            if (this->wakeDescriptor >= 0)
+                close(this->wakeDescriptor);
+            if (this->descriptor >= 0)
+                close(this->descriptor);
+        }
+
+        // Callers keep at most `entries` submissions queued between two calls to Enter
+        io_uring_sqe& NextEntry()
+        {
+            const unsigned tail = *this->sqTail;
+            const unsigned index = tail & this->sqMask;
+            io_uring_sqe& entry = this->sqes[index];
+            memset(&entry, 0, sizeof(entry));
+            this->sqArray[index] = index;
+            std::atomic_ref<unsigned>(*this->sqTail).store(tail + 1, std::memory_order_release);
+            ++this->queued;
+            return entry;
+        }
+
+        // Reads are capped to 1 GiB per submission and continued on short reads
+        void PrepareRead(Operation& operation)
+        {
+            io_uring_sqe& entry = this->NextEntry();
+            entry.opcode = IORING_OP_READ;
+            entry.fd = operation.descriptor;
+            entry.addr = reinterpret_cast<uint64_t>(operation.read.destination + operation.completed);
+            entry.len = static_cast<unsigned>(std::min<size_t>(operation.read.size - operation.completed, size_t(1) << 30));
+            entry.off = operation.read.offset + operation.completed;
+            entry.user_data = reinterpret_cast<uint64_t>(&operation);
+        }
+
+        void ArmWake()
+        {
+            io_uring_sqe& entry = this->NextEntry();
+            entry.opcode = IORING_OP_READ;
+            entry.fd = this->wakeDescriptor;
+            entry.addr = reinterpret_cast<uint64_t>(&this->wakeValue);
+            entry.len = sizeof(this->wakeValue);
+            entry.user_data = Ring::wakeTag;
+        }
+
+        // Submits everything queued and blocks until at least one completion is available
+        void Enter()
+        {
+            while (true)
+            {
+                const long submitted = syscall(__NR_io_uring_enter, this->descriptor, this->queued, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+                if (submitted >= 0)
+                {
+                    this->queued -= static_cast<unsigned>(submitted);
+                    return;
+                }
+                if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+                    throw Exception("io_uring_enter failed: " + String(strerror(errno)), ExceptionType::LOAD_ASSET);
+            }
+        }
+
+        void Wake()
+        {
+            const uint64_t one = 1;
+            [[maybe_unused]] ssize_t written = write(this->wakeDescriptor, &one, sizeof(one));
+        }
+    };
+
+#else
+
+    struct AsyncFileReader::Ring
+    {
+    };
+
+#endif
+
+    AsyncFileReader::AsyncFileReader(UInt queueDepth, UInt fallbackThreads)
+    {
+#if defined ATR_IO_URING
+        this->ring = Ring::Create(queueDepth);
+        if (this->ring)
+        {
+            this->ringThread = std::thread(&AsyncFileReader::RingLoop, this);
+            return;
+        }
+        ATR_LOG_VERBOSE("io_uring unavailable, file reads fall back to blocking threads")
+#endif
+        this->fallbackPool = std::make_unique<ThreadPool>(fallbackThreads);
+    }
+
+    AsyncFileReader::~AsyncFileReader()
+    {
+        this->WaitIdle();
+        if (this->ringThread.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->stopping = true;
+            }
+#if defined ATR_IO_URING
+            this->ring->Wake();
+#endif
+            this->ringThread.join();
+        }
+    }
+
+    void AsyncFileReader::Submit(FileRead read)
+    {
+        std::vector<FileRead> reads;
+        reads.push_back(std::move(read));
+        this->Submit(std::move(reads));
+    }
+
+    void AsyncFileReader::Submit(std::vector<FileRead> reads)
+    {
+        if (reads.empty())
+            return;
+
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->outstanding += reads.size();
+            if (this->ring)
+                for (FileRead& read : reads)
+                    this->pending.push_back(std::make_unique<Operation>(Operation{ .read = std::move(read) }));
+        }
+
+        if (!this->ring)
+        {
+            for (FileRead& read : reads)
+                this->fallbackPool->Submit([this, read = std::move(read)]() { this->ReadBlocking(read); });
+            return;
+        }
+#if defined ATR_IO_URING
+        this->ring->Wake();
+#endif
+    }
+
+    void AsyncFileReader::WaitIdle()
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->idle.wait(lock, [this]() { return this->outstanding == 0; });
+    }
+
+    void AsyncFileReader::RingLoop()
+    {
+#if defined ATR_IO_URING
+        Ring& ring = *this->ring;
+        ring.ArmWake();
+
+        std::vector<std::unique_ptr<Operation>> batch;
+        while (true)
+        {
+            // One submission slot stays reserved for re-arming the wake read, so the completion ring can never overflow
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                while (!this->pending.empty() && ring.inFlight + batch.size() + 1 < ring.entries)
+                {
+                    batch.push_back(std::move(this->pending.front()));
+                    this->pending.pop_front();
+                }
+                if (this->stopping && this->pending.empty() && batch.empty() && ring.inFlight == 0)
+                    break;
+            }
+
+            for (std::unique_ptr<Operation>& operation : batch)
+            {
+                if (operation->read.size == 0)
+                {
+                    this->Complete(operation->read, nullptr);
+                    continue;
+                }
+
+                operation->descriptor = open(operation->read.path.c_str(), O_RDONLY | O_CLOEXEC);
+                if (operation->descriptor < 0)
+                {
+                    this->Complete(operation->read, std::make_exception_ptr(Exception("Failed to open file: " + operation->read.path, ExceptionType::LOAD_ASSET)));
+                    continue;
+                }
+                ring.PrepareRead(*operation.release());
+                ++ring.inFlight;
+            }
+            batch.clear();
+
+            ring.Enter();
+
+            unsigned head = *ring.cqHead;
+            const unsigned tail = std::atomic_ref<unsigned>(*ring.cqTail).load(std::memory_order_acquire);
+            for (; head != tail; ++head)
+            {
+                const io_uring_cqe completion = ring.cqes[head & ring.cqMask];
+                if (completion.user_data == Ring::wakeTag)
+                {
+                    ring.ArmWake();
+                    continue;
+                }
+
+                Operation* operation = reinterpret_cast<Operation*>(completion.user_data);
+                if (completion.res == -EINTR || completion.res == -EAGAIN)
+                {
+                    ring.PrepareRead(*operation);
+                    continue;
+                }
+                if (completion.res > 0)
+                {
+                    operation->completed += static_cast<size_t>(completion.res);
+                    if (operation->completed < operation->read.size)
+                    {
+                        ring.PrepareRead(*operation);
+                        continue;
+                    }
+                }
+
+                std::exception_ptr error;
+                if (completion.res < 0)
+                    error = std::make_exception_ptr(Exception("Failed to read " + operation->read.path + ": " + strerror(-completion.res), ExceptionType::LOAD_ASSET));
+                else if (completion.res == 0)
+                    error = std::make_exception_ptr(Exception("Unexpected end of file: " + operation->read.path, ExceptionType::LOAD_ASSET));
+
+                close(operation->descriptor);
+                --ring.inFlight;
+                this->Complete(operation->read, error);
+                delete operation;
+            }
+            std::atomic_ref<unsigned>(*ring.cqHead).store(head, std::memory_order_release);
+        }
+#endif
+    }
+
+    void AsyncFileReader::ReadBlocking(const FileRead& read)
+    {
+        std::exception_ptr error;
+        std::ifstream file(read.path, std::ios::binary);
+        if (!file.is_open())
+            error = std::make_exception_ptr(Exception("Failed to open file: " + read.path, ExceptionType::LOAD_ASSET));
+        else if (read.size != 0 && (!file.seekg(static_cast<std::streamoff>(read.offset)) || !file.read(reinterpret_cast<char*>(read.destination), static_cast<std::streamsize>(read.size))))
+            error = std::make_exception_ptr(Exception("Unexpected end of file: " + read.path, ExceptionType::LOAD_ASSET));
+        this->Complete(read, error);
+    }
+
+    void AsyncFileReader::Complete(const FileRead& read, std::exception_ptr error)
+    {
+        // A throwing callback must not take the I/O thread down with it
+        try
+        {
+            if (read.onComplete)
+                read.onComplete(error);
+        }
+        catch (const Exception& e)
+        {
+            ATR_ERROR(e.What())
+        }
+        catch (const std::exception& e)
+        {
+            ATR_ERROR(e.what())
+        }
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (--this->outstanding == 0)
+            this->idle.notify_all();
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "ATRType.h"
+#include "ATRThreadPool.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace ATR
+{
+    // One read of `size` bytes at `offset` of `path` into memory owned by the caller (e.g. a mapped staging buffer)
+    struct FileRead
+    {
+        String path;
+        LUInt offset = 0;
+        size_t size = 0;
+        uint8_t* destination = nullptr;
+        std::function<void(std::exception_ptr)> onComplete;        // Null error once every byte arrived; runs on an I/O thread, so keep it short
+    };
+
+    // Asynchronous file reads, batched so that many requests are in flight at once
+    //  On Linux the reads go through an io_uring driven by one completion thread (raw syscalls, no liburing);
+    //  elsewhere, or where the kernel refuses io_uring, blocking reads run on a small thread pool instead
+    class AsyncFileReader
+    {
+    public:
+        explicit AsyncFileReader(UInt queueDepth = 256, UInt fallbackThreads = 4);
+        ~AsyncFileReader();                     // Completes every submitted read first
+
+        AsyncFileReader(const AsyncFileReader&) = delete;
+        AsyncFileReader& operator=(const AsyncFileReader&) = delete;
+
+        void Submit(FileRead read);
+        void Submit(std::vector<FileRead> reads);
+
+        // Blocks until every submitted read has completed and its callback returned
+        void WaitIdle();
+
+        inline Bool UsesIoUring() const { return this->ring != nullptr; }
+
+    private:
+        struct Ring;                            // io_uring state, only defined where it is supported
+        struct Operation;
+
+        void RingLoop();
+        void ReadBlocking(const FileRead& read);
+        void Complete(const FileRead& read, std::exception_ptr error);
+
+        std::unique_ptr<Ring> ring;
+        std::thread ringThread;
+        std::deque<std::unique_ptr<Operation>> pending;            // Submitted, waiting for a free submission slot
+        std::unique_ptr<ThreadPool> fallbackPool;
+
+        std::mutex mutex;
+        std::condition_variable idle;
+        size_t outstanding = 0;
+        Bool stopping = false;
+    };
+}
@@ -9,7 +9,8 @@ namespace ATR
         INIT_RENDERER,
         INIT_GLFW, INIT_VULKAN,
         INIT_SHADER, INIT_PIPELINE, INIT_BUFFER,
-        UPDATE_RENDER, UPDATE_MEMORY
+        UPDATE_RENDER, UPDATE_MEMORY,
+        LOAD_ASSET
     };
 
     class Exception
@@ -48,6 +49,9 @@ namespace ATR
             case ExceptionType::UPDATE_MEMORY:
                 typeStr += "[UPDATE] (Memory Allocation)";
                 break;
+            case ExceptionType::LOAD_ASSET:
+                typeStr += "[LOAD] (Asset)";
+                break;
             }
 
             return typeStr + " " + this->msg;
@@ -0,0 +1,102 @@
+#include "atrpch.h"
+
+#include "ATRFileWatcher.h"
+
+#if defined __linux__
+#define ATR_INOTIFY
+
+#include <cerrno>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace ATR
+{
+    FileWatcher::FileWatcher(const String& directory)
+        : directory(directory)
+    {
+        if (!std::filesystem::is_directory(directory))
+            throw Exception("Not a directory to watch: " + directory, ExceptionType::INIT_RENDERER);
+
+#if defined ATR_INOTIFY
+        // Editors either rewrite the file in place (close after write) or write a copy and rename it over the original (moved to)
+        this->descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (this->descriptor >= 0 && inotify_add_watch(this->descriptor, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+        {
+            close(this->descriptor);
+            this->descriptor = -1;
+        }
+        if (this->descriptor >= 0)
+            return;
+#endif
+        this->PollWriteTimes();
+    }
+
+    FileWatcher::~FileWatcher()
+    {
+#if defined ATR_INOTIFY
+        if (this->descriptor >= 0)
+            close(this->descriptor);
+#endif
+    }
+
+    std::vector<String> FileWatcher::Poll()
+    {
+        if (this->descriptor < 0)
+            return this->PollWriteTimes();
+
+        std::vector<String> changed;
+#if defined ATR_INOTIFY
+        alignas(inotify_event) char buffer[4096];
+        for (;;)
+        {
+            const ssize_t length = read(this->descriptor, buffer, sizeof(buffer));
+            if (length < 0 && errno == EINTR)
+                continue;
+            if (length <= 0)
+                break;                          // EAGAIN: nothing more queued
+
+            for (ssize_t offset = 0; offset < length; )
+            {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                if (event->len != 0 && !(event->mask & IN_ISDIR))
+                {
+                    String path = (std::filesystem::path(this->directory) / event->name).generic_string();
+                    if (std::find(changed.begin(), changed.end(), path) == changed.end())
+                        changed.push_back(std::move(path));
+                }
+                offset += sizeof(inotify_event) + event->len;
+            }
+        }
+#endif
+        return changed;
+    }
+
+    std::vector<String> FileWatcher::PollWriteTimes()
+    {
+        // The first pass only records the times; files appearing later count as changed
+        const Bool first = !this->scanned;
+        this->scanned = true;
+        std::vector<String> changed;
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(this->directory, error))
+        {
+            if (!entry.is_regular_file(error))
+                continue;
+
+            const auto writeTime = entry.last_write_time(error);
+            if (error)
+                continue;
+            String path = entry.path().generic_string();
+            auto [recorded, inserted] = this->writeTimes.try_emplace(path, writeTime);
+            if (!inserted && recorded->second != writeTime)
+            {
+                recorded->second = writeTime;
+                changed.push_back(std::move(path));
+            }
+            else if (inserted && !first)
+                changed.push_back(std::move(path));
+        }
+        return changed;
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "ATRType.h"
+
+#include <filesystem>
+#include <unordered_map>
+#include <vector>
+
+namespace ATR
+{
+    // Reports the files of one directory (not its subdirectories) written since the last poll
+    //  On Linux a non-blocking inotify descriptor collects the writes; elsewhere, or where inotify is refused,
+    //  the modification times of the directory's files are compared on every poll instead
+    class FileWatcher
+    {
+    public:
+        explicit FileWatcher(const String& directory);
+        ~FileWatcher();
+
+        FileWatcher(const FileWatcher&) = delete;
+        FileWatcher& operator=(const FileWatcher&) = delete;
+
+        // Paths of the changed files, each once; never blocks
+        std::vector<String> Poll();
+
+        inline const String& Directory() const { return this->directory; }
+
+    private:
+        std::vector<String> PollWriteTimes();
+
+        String directory;
+        int descriptor = -1;                    // inotify instance, -1 when polling write times
+        std::unordered_map<String, std::filesystem::file_time_type> writeTimes;
+        Bool scanned = false;
+    };
+}
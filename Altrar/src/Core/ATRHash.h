@@ -0,0 +1,33 @@
+#pragma once
+
+#include "ATRType.h"
+
+#include <cstddef>
+
+namespace ATR
+{
+    // 64-bit FNV-1a; used for cache keys, not for anything adversarial
+    inline constexpr LUInt hashSeed = 14695981039346656037ull;
+
+    inline LUInt HashBytes(const void* data, size_t size, LUInt hash = hashSeed)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i != size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    inline LUInt HashString(const String& str, LUInt hash = hashSeed)
+    {
+        return HashBytes(str.data(), str.size(), hash);
+    }
+
+    template <typename T>
+    inline LUInt HashValue(const T& value, LUInt hash = hashSeed)
+    {
+        return HashBytes(&value, sizeof(T), hash);
+    }
+}
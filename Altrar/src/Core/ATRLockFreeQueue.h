@@ -0,0 +1,64 @@
+#pragma once
+
+#include "ATRType.h"
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+namespace ATR
+{
+    // Unbounded multi-producer single-consumer queue; pushing never blocks and never takes a lock
+    //  Nodes are linked through `head` by producers and unlinked from `tail` by the single consumer
+    //  A push is visible once its producer has linked the node, so a consumer may briefly see an in-progress push as absent
+    template <typename T>
+    class LockFreeQueue
+    {
+    public:
+        LockFreeQueue() : head(new Node), tail(head.load(std::memory_order_relaxed)) { }
+        ~LockFreeQueue()
+        {
+            while (this->TryPop())
+                ;
+            delete this->tail;
+        }
+
+        LockFreeQueue(const LockFreeQueue&) = delete;
+        LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+        // Any thread
+        void Push(T value)
+        {
+            Node* node = new Node;
+            node->value.emplace(std::move(value));
+
+            Node* previous = this->head.exchange(node, std::memory_order_acq_rel);
+            previous->next.store(node, std::memory_order_release);
+        }
+
+        // Consumer thread only
+        std::optional<T> TryPop()
+        {
+            Node* next = this->tail->next.load(std::memory_order_acquire);
+            if (next == nullptr)
+                return std::nullopt;
+
+            // `next` becomes the new stub; its value moves out, the old stub is released
+            std::optional<T> value = std::move(next->value);
+            next->value.reset();
+            delete this->tail;
+            this->tail = next;
+            return value;
+        }
+
+    private:
+        struct Node
+        {
+            std::atomic<Node*> next = nullptr;
+            std::optional<T> value;
+        };
+
+        std::atomic<Node*> head;
+        Node* tail;
+    };
+}
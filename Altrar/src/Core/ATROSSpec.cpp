@@ -4,6 +4,13 @@
 
 #include <algorithm>
 
+#if !defined _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace ATR
 {
 
@@ -23,15 +30,92 @@ namespace ATR
 
 #endif
 
-    void OS::Execute(String cmd)
+    Int OS::Execute(const String& cmd)
     {
-#if defined _WIN32
-        // Since Windows requires "\" for file systems, and it needs to be escaped, first insert \\ for every "\"
         ATR_LOG_ACTION(("Executing Command: " + cmd))
-        //std::replace(cmd.begin(), cmd.end(), '/', '\\');
-        system(cmd.c_str());
+#if defined _WIN32
+        // cmd.exe strips the outermost quotes of a command line, which would break a quoted executable path
+        const Int status = system(("\"" + cmd + "\"").c_str());
+#else
+        const Int status = system(cmd.c_str());
+#endif
         ATR_LOG_ACTION_END
+        return status;
+    }
+
+    MappedFile OS::MapFile(const String& path)
+    {
+        MappedFile mapped;
+#if defined _WIN32
+        const ATR_WINAPI::HANDLE invalidHandle = reinterpret_cast<ATR_WINAPI::HANDLE>(static_cast<intptr_t>(-1));
+        ATR_WINAPI::HANDLE file = ATR_WINAPI::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == invalidHandle)
+            throw Exception("Failed to open file for mapping: " + path, ExceptionType::LOAD_ASSET);
+
+        ATR_WINAPI::LARGE_INTEGER size;
+        if (!ATR_WINAPI::GetFileSizeEx(file, &size))
+        {
+            ATR_WINAPI::CloseHandle(file);
+            throw Exception("Failed to query file size: " + path, ExceptionType::LOAD_ASSET);
+        }
+        mapped.size = static_cast<size_t>(size.QuadPart);
+
+        // Empty files cannot be mapped; the view simply stays null
+        if (mapped.size != 0)
+        {
+            ATR_WINAPI::HANDLE mapping = ATR_WINAPI::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping != nullptr)
+                mapped.data = static_cast<const uint8_t*>(ATR_WINAPI::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            if (mapped.data == nullptr)
+            {
+                if (mapping != nullptr)
+                    ATR_WINAPI::CloseHandle(mapping);
+                ATR_WINAPI::CloseHandle(file);
+                throw Exception("Failed to map file: " + path, ExceptionType::LOAD_ASSET);
+            }
+            mapped.mapping = mapping;
+        }
+        ATR_WINAPI::CloseHandle(file);          // The mapping keeps the file open
+#else
+        int descriptor = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (descriptor < 0)
+            throw Exception("Failed to open file for mapping: " + path, ExceptionType::LOAD_ASSET);
+
+        struct stat status;
+        if (fstat(descriptor, &status) != 0)
+        {
+            close(descriptor);
+            throw Exception("Failed to query file size: " + path, ExceptionType::LOAD_ASSET);
+        }
+        mapped.size = static_cast<size_t>(status.st_size);
+
+        if (mapped.size != 0)
+        {
+            void* view = mmap(nullptr, mapped.size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            if (view == MAP_FAILED)
+            {
+                close(descriptor);
+                throw Exception("Failed to map file: " + path, ExceptionType::LOAD_ASSET);
+            }
+            mapped.data = static_cast<const uint8_t*>(view);
+        }
+        close(descriptor);                      // The mapping keeps the file open
+#endif
+        return mapped;
+    }
+
+    void OS::UnmapFile(MappedFile& file)
+    {
+        if (file.data != nullptr)
+        {
+#if defined _WIN32
+            ATR_WINAPI::UnmapViewOfFile(file.data);
+            ATR_WINAPI::CloseHandle(static_cast<ATR_WINAPI::HANDLE>(file.mapping));
+#else
+            munmap(const_cast<uint8_t*>(file.data), file.size);
 #endif
+        }
+        file = MappedFile();
     }
 
-}
\ No newline at end of file
+}
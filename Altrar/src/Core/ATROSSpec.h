@@ -4,9 +4,21 @@ namespace ATR
 {
     void OS_ChangeConsoleColor(unsigned int color);
 
+    // Read-only view of a whole file, kept mapped until UnmapFile
+    struct MappedFile
+    {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        void* mapping = nullptr;                // OS mapping object, where the platform needs one besides the view
+    };
+
     class OS
     {
     public:
-        static void Execute(String);
+        // Runs a shell command and returns its exit status; 0 on success
+        static Int Execute(const String& cmd);
+
+        static MappedFile MapFile(const String& path);
+        static void UnmapFile(MappedFile& file);
     };
 }
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "ATRType.h"
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <optional>
+
+namespace ATR
+{
+    // First-fit sub-allocator over [0, capacity), handing out element ranges of one large buffer
+    //  Free ranges are kept sorted by offset and merged with their neighbours on release
+    class RangeAllocator
+    {
+    public:
+        explicit RangeAllocator(UInt capacity = 0) : capacity(capacity)
+        {
+            if (capacity != 0)
+                this->freeRanges.emplace(0, capacity);
+        }
+
+        std::optional<UInt> Allocate(UInt size)
+        {
+            if (size == 0)
+                return 0;
+
+            for (auto iter = this->freeRanges.begin(); iter != this->freeRanges.end(); ++iter)
+            {
+                if (iter->second < size)
+                    continue;
+
+                const UInt offset = iter->first, remaining = iter->second - size;
+                this->freeRanges.erase(iter);
+                if (remaining != 0)
+                    this->freeRanges.emplace(offset + size, remaining);
+                return offset;
+            }
+            return std::nullopt;
+        }
+
+        void Free(UInt offset, UInt size)
+        {
+            if (size == 0)
+                return;
+
+            auto next = this->freeRanges.lower_bound(offset);
+            if (next != this->freeRanges.begin())
+            {
+                auto previous = std::prev(next);
+                if (previous->first + previous->second == offset)
+                {
+                    offset = previous->first;
+                    size += previous->second;
+                    this->freeRanges.erase(previous);
+                }
+            }
+            if (next != this->freeRanges.end() && offset + size == next->first)
+            {
+                size += next->second;
+                this->freeRanges.erase(next);
+            }
+            this->freeRanges.emplace(offset, size);
+        }
+
+        // Extends the range; existing allocations keep their offsets
+        void Grow(UInt newCapacity)
+        {
+            if (newCapacity > this->capacity)
+                this->Free(this->capacity, newCapacity - this->capacity);
+            this->capacity = std::max(this->capacity, newCapacity);
+        }
+
+        inline UInt Capacity() const { return this->capacity; }
+
+    private:
+        UInt capacity;
+        std::map<UInt, UInt> freeRanges;            // Offset -> size
+    };
+}
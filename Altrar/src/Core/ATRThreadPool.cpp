@@ -0,0 +1,64 @@
+#include "atrpch.h"
+
+#include "ATRThreadPool.h"
+
+namespace ATR
+{
+    ThreadPool::ThreadPool(UInt threadCount)
+    {
+        if (threadCount == 0)
+        {
+            UInt hardwareThreads = std::thread::hardware_concurrency();
+            threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+        }
+
+        this->workers.reserve(threadCount);
+        for (UInt i = 0; i != threadCount; ++i)
+            this->workers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->jobMutex);
+            this->stopping = true;
+        }
+        this->jobAvailable.notify_all();
+
+        // Remaining jobs are drained before the workers exit, so no future is left unsatisfied
+        for (auto& worker : this->workers)
+            worker.join();
+    }
+
+    void ThreadPool::WaitIdle()
+    {
+        std::unique_lock<std::mutex> lock(this->jobMutex);
+        this->jobsFinished.wait(lock, [this]() { return this->jobs.empty() && this->runningJobs == 0; });
+    }
+
+    void ThreadPool::WorkerLoop()
+    {
+        while (true)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(this->jobMutex);
+                this->jobAvailable.wait(lock, [this]() { return this->stopping || !this->jobs.empty(); });
+
+                if (this->jobs.empty())
+                    return;
+
+                job = std::move(this->jobs.front());
+                this->jobs.pop();
+                ++this->runningJobs;
+            }
+            job();
+
+            {
+                std::lock_guard<std::mutex> lock(this->jobMutex);
+                --this->runningJobs;
+            }
+            this->jobsFinished.notify_all();
+        }
+    }
+}
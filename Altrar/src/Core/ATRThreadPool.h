@@ -0,0 +1,62 @@
+#pragma once
+
+#include "ATRType.h"
+
+#include <vector>
+#include <queue>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <type_traits>
+
+namespace ATR
+{
+    // A fixed-size pool of worker threads consuming a FIFO of jobs
+    // Used for all work that must stay off the render thread (decoding, parsing, staging)
+    class ThreadPool
+    {
+    public:
+        // threadCount of 0 picks hardware concurrency - 1 (at least 1), leaving a core for the render thread
+        explicit ThreadPool(UInt threadCount = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        template <typename F>
+        auto Submit(F&& job) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+        {
+            using ResultType = std::invoke_result_t<std::decay_t<F>>;
+
+            // std::function requires copyable callables, hence the packaged_task is shared
+            auto task = std::make_shared<std::packaged_task<ResultType()>>(std::forward<F>(job));
+            std::future<ResultType> result = task->get_future();
+            {
+                std::lock_guard<std::mutex> lock(this->jobMutex);
+                this->jobs.emplace([task]() { (*task)(); });
+            }
+            this->jobAvailable.notify_one();
+            return result;
+        }
+
+        inline UInt ThreadCount() const { return static_cast<UInt>(this->workers.size()); }
+
+        // Blocks until the queue is empty and no job is running
+        void WaitIdle();
+
+    private:
+        void WorkerLoop();
+
+        std::vector<std::thread> workers;
+        std::queue<std::function<void()>> jobs;
+
+        std::mutex jobMutex;
+        std::condition_variable jobAvailable;
+        std::condition_variable jobsFinished;
+        UInt runningJobs = 0;
+        Bool stopping = false;
+    };
+}
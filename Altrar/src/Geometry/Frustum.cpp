@@ -0,0 +1,28 @@
+#include "atrpch.h"
+
+#include "Frustum.h"
+
+namespace ATR
+{
+    Frustum Frustum::FromMatrix(const Mat4& transform)
+    {
+        // A point is inside where -w <= x, y <= w and 0 <= z <= w in clip space; each inequality is a plane over the matrix rows
+        const Mat4 rows = glm::transpose(transform);
+        Frustum frustum = { .planes = {
+            rows[3] + rows[0], rows[3] - rows[0],
+            rows[3] + rows[1], rows[3] - rows[1],
+            rows[2], rows[3] - rows[2]
+        } };
+        for (Vec4& plane : frustum.planes)
+            plane /= glm::length(Vec3(plane));
+        return frustum;
+    }
+
+    Bool Frustum::IntersectsSphere(const Vec3& center, Float radius) const
+    {
+        for (const Vec4& plane : this->planes)
+            if (glm::dot(Vec3(plane), center) + plane.w < -radius)
+                return false;
+        return true;
+    }
+}
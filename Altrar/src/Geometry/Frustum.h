@@ -0,0 +1,18 @@
+#pragma once
+
+#include "atrfwd.h"
+
+namespace ATR
+{
+    // The six planes bounding what a transform maps into the clip volume (depth zero to one), as (normal, distance) with normals pointing inwards
+    //  Planes are normalized, so that signed distances compare directly against bounding sphere radii
+    struct Frustum
+    {
+        std::array<Vec4, 6> planes;                 // Left, right, bottom, top, near, far
+
+        // From a projection * view (* model) matrix: bounds transformed by the rest of the chain are tested in the space it starts from
+        static Frustum FromMatrix(const Mat4& transform);
+
+        Bool IntersectsSphere(const Vec3& center, Float radius) const;
+    };
+}
@@ -2,3 +2,5 @@
 
 #include "Vertex.h"
 #include "Mesh.h"
+#include "Frustum.h"
+#include "SphereSet.h"
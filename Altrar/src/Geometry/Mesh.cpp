@@ -29,4 +29,23 @@ namespace ATR
         this->indices = mesh.GetIndices();
         this->vertices = mesh.GetVertices();
     }
+
+    Vec4 Mesh::BoundingSphere() const
+    {
+        if (this->vertices.empty())
+            return Vec4(0.f);
+
+        Vec3 lower = this->vertices.front().pos, upper = lower;
+        for (const Vertex& vertex : this->vertices)
+        {
+            lower = glm::min(lower, vertex.pos);
+            upper = glm::max(upper, vertex.pos);
+        }
+
+        const Vec3 center = 0.5f * (lower + upper);
+        Float radius = 0.f;
+        for (const Vertex& vertex : this->vertices)
+            radius = std::max(radius, glm::distance(center, vertex.pos));
+        return Vec4(center, radius);
+    }
 }
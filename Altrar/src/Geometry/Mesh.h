@@ -9,6 +9,9 @@ namespace ATR
     class Mesh
     {
     public:
+        Mesh() = default;
+        Mesh(std::vector<Vertex> vertices, std::vector<UInt> indices) : indices(std::move(indices)), vertices(std::move(vertices)) { }
+
         void AddTriangle(std::array<Vertex, 3> vertices);
 
         inline const std::vector<UInt>& GetIndices() const { return this->indices; }
@@ -16,6 +19,9 @@ namespace ATR
 
         inline void UpdateVertexPos(UInt index, Vec3 pos) { this->vertices[index].pos = pos; }
 
+        // Center (xyz) and radius (w) of a sphere enclosing every vertex, around the center of their bounding box
+        Vec4 BoundingSphere() const;
+
         inline void Clear() { this->indices.clear(); this->vertices.clear(); }
 
         void UpdateMesh(const Mesh& mesh);
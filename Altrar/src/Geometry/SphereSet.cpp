@@ -0,0 +1,79 @@
+#include "atrpch.h"
+
+#include "SphereSet.h"
+
+#if defined __AVX512F__ || defined __AVX__
+#include <immintrin.h>
+#elif defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#endif
+
+namespace ATR
+{
+    void SphereSet::Resize(UInt count)
+    {
+        this->count = count;
+        const size_t padded = (static_cast<size_t>(count) + SphereSet::laneCount - 1) / SphereSet::laneCount * SphereSet::laneCount;
+        for (std::vector<Float>* values : { &this->x, &this->y, &this->z, &this->radius })
+            values->resize(padded, 0.f);
+    }
+
+    void SphereSet::Set(UInt index, const Vec3& center, Float radius)
+    {
+        this->x[index] = center.x;
+        this->y[index] = center.y;
+        this->z[index] = center.z;
+        this->radius[index] = radius;
+    }
+
+    void SphereSet::Cull(const Frustum& frustum, UInt begin, UInt end, uint8_t* visible) const
+    {
+        // A sphere is outside once its center lies deeper than its radius behind any plane; planes are broadcast, spheres loaded side by side
+        //  Plain multiplies and adds, since AVX does not imply FMA
+        for (UInt first = begin; first < end; first += SphereSet::laneCount)
+        {
+#if defined __AVX512F__
+            const __m512 x = _mm512_loadu_ps(&this->x[first]), y = _mm512_loadu_ps(&this->y[first]), z = _mm512_loadu_ps(&this->z[first]);
+            const __m512 negativeRadius = _mm512_sub_ps(_mm512_setzero_ps(), _mm512_loadu_ps(&this->radius[first]));
+            __mmask16 inside = 0xFFFF;
+            for (const Vec4& plane : frustum.planes)
+            {
+                const __m512 distance = _mm512_add_ps(
+                    _mm512_add_ps(_mm512_mul_ps(x, _mm512_set1_ps(plane.x)), _mm512_mul_ps(y, _mm512_set1_ps(plane.y))),
+                    _mm512_add_ps(_mm512_mul_ps(z, _mm512_set1_ps(plane.z)), _mm512_set1_ps(plane.w)));
+                inside &= _mm512_cmp_ps_mask(distance, negativeRadius, _CMP_GE_OQ);
+            }
+            const UInt mask = inside;
+#elif defined __AVX__
+            const __m256 x = _mm256_loadu_ps(&this->x[first]), y = _mm256_loadu_ps(&this->y[first]), z = _mm256_loadu_ps(&this->z[first]);
+            const __m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(&this->radius[first]));
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (const Vec4& plane : frustum.planes)
+            {
+                const __m256 distance = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(plane.x)), _mm256_mul_ps(y, _mm256_set1_ps(plane.y))),
+                    _mm256_add_ps(_mm256_mul_ps(z, _mm256_set1_ps(plane.z)), _mm256_set1_ps(plane.w)));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+            }
+            const UInt mask = static_cast<UInt>(_mm256_movemask_ps(inside));
+#elif defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+            const __m128 x = _mm_loadu_ps(&this->x[first]), y = _mm_loadu_ps(&this->y[first]), z = _mm_loadu_ps(&this->z[first]);
+            const __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&this->radius[first]));
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (const Vec4& plane : frustum.planes)
+            {
+                const __m128 distance = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)), _mm_mul_ps(y, _mm_set1_ps(plane.y))),
+                    _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+            }
+            const UInt mask = static_cast<UInt>(_mm_movemask_ps(inside));
+#else
+            const UInt mask = frustum.IntersectsSphere(Vec3(this->x[first], this->y[first], this->z[first]), this->radius[first]) ? 1 : 0;
+#endif
+            const UInt lanes = std::min(SphereSet::laneCount, end - first);
+            for (UInt lane = 0; lane != lanes; ++lane)
+                visible[first + lane] = static_cast<uint8_t>((mask >> lane) & 1);
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "atrfwd.h"
+
+#include "Frustum.h"
+
+namespace ATR
+{
+    // Bounding spheres of many objects as a structure of arrays, so that frustum tests take a SIMD register of objects at a time
+    //  The width follows the instruction set the build targets (premake --simd): 16 with AVX-512, 8 with AVX, 4 with SSE2, else 1
+    class SphereSet
+    {
+    public:
+#if defined __AVX512F__
+        static inline constexpr UInt laneCount = 16;
+#elif defined __AVX__
+        static inline constexpr UInt laneCount = 8;
+#elif defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+        static inline constexpr UInt laneCount = 4;
+#else
+        static inline constexpr UInt laneCount = 1;
+#endif
+
+        // Arrays are padded to whole registers; the padding is never reported
+        void Resize(UInt count);
+        inline UInt Size() const { return this->count; }
+        void Set(UInt index, const Vec3& center, Float radius);
+
+        // Sets visible[i] to 1 for each sphere i in [begin, end) intersecting the frustum, 0 otherwise
+        //  Disjoint ranges may be tested concurrently; `begin` has to be a multiple of laneCount
+        void Cull(const Frustum& frustum, UInt begin, UInt end, uint8_t* visible) const;
+
+    private:
+        UInt count = 0;
+        std::vector<Float> x, y, z, radius;
+    };
+}
@@ -7,14 +7,12 @@ namespace ATR
     struct Vertex
     {
     public:
-        Vertex(Vec3 pos, Vec3 normal, Vec3 color) : pos(pos), normal(normal), color(color) {  }
+        Vertex(Vec3 pos, Vec3 normal, Vec3 color, Vec2 texCoord = Vec2(0.f)) : pos(pos), normal(normal), color(color), texCoord(texCoord) {  }
 
         Vec3 pos;
         Vec3 normal;
         Vec3 color;
-
-        static VkVertexInputBindingDescription bindingDescription;
-        static std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions;
+        Vec2 texCoord;
     };
 
     bool operator==(const Vertex& lhs, const Vertex& rhs);
@@ -0,0 +1,56 @@
+#pragma once
+#include "atrfwd.h"
+
+#include "ATRHash.h"
+
+namespace ATR
+{
+    // On-disk layout of .atrpak archives, shared by the AssetPacker tool and the runtime reader
+    //  [ArchiveHeader][ArchiveEntry x entryCount, sorted by (hash, name)][names][payloads, each page-aligned]
+    //  All integers are little-endian; offsets are from the start of the file
+
+    enum class ArchiveCompression : UInt
+    {
+        NONE = 0,
+        LZ4 = 1,
+    };
+
+    struct ArchiveHeader
+    {
+        char magic[8];
+        UInt version;
+        UInt entryCount;
+        LUInt indexOffset;
+        LUInt namesOffset, namesSize;
+    };
+    static_assert(sizeof(ArchiveHeader) == 40, "ArchiveHeader must not be padded");
+
+    struct ArchiveEntry
+    {
+        LUInt hash;                             // ArchiveHash of the normalized name
+        LUInt offset;
+        LUInt storedSize, size;                 // Bytes in the file, and after decompression
+        UInt nameOffset, nameLength;            // Into the names block, to tell colliding hashes apart
+        ArchiveCompression compression;
+        UInt reserved;
+    };
+    static_assert(sizeof(ArchiveEntry) == 48, "ArchiveEntry must not be padded");
+
+    inline constexpr char archiveMagic[8] = { 'A', 'T', 'R', 'P', 'A', 'K', '\0', '\0' };
+    inline constexpr UInt archiveVersion = 1;
+    inline constexpr LUInt archivePageSize = 4096;          // Payloads start on page boundaries, so mapped reads never straddle a neighbour's first page
+
+    // Archive names use forward slashes and no leading "./", so that lookups match regardless of how a path was spelled
+    inline String NormalizeArchiveName(String name)
+    {
+        std::replace(name.begin(), name.end(), '\\', '/');
+        while (name.size() >= 2 && name[0] == '.' && name[1] == '/')
+            name.erase(0, 2);
+        return name;
+    }
+
+    inline LUInt ArchiveHash(const String& normalizedName)
+    {
+        return HashString(normalizedName);
+    }
+}
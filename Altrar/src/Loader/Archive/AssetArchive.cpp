@@ -0,0 +1,98 @@
+#include "atrpch.h"
+
+#include "AssetArchive.h"
+#include "LZ4.h"
+
+#include <cstring>
+
+namespace ATR
+{
+    AssetArchive::AssetArchive(const String& path)
+        : path(path), file(OS::MapFile(path))
+    {
+        try
+        {
+            if (this->file.size < sizeof(ArchiveHeader))
+                throw Exception("Truncated archive: " + path, ExceptionType::LOAD_ASSET);
+
+            ArchiveHeader header;
+            memcpy(&header, this->file.data, sizeof(header));
+            if (!std::equal(std::begin(archiveMagic), std::end(archiveMagic), header.magic))
+                throw Exception("Not an asset archive: " + path, ExceptionType::LOAD_ASSET);
+            if (header.version != archiveVersion)
+                throw Exception("Unsupported archive version " + std::to_string(header.version) + ": " + path, ExceptionType::LOAD_ASSET);
+
+            const LUInt indexSize = static_cast<LUInt>(header.entryCount) * sizeof(ArchiveEntry);
+            if (header.indexOffset % alignof(ArchiveEntry) != 0 || header.indexOffset + indexSize > this->file.size
+                || header.namesOffset + header.namesSize > this->file.size)
+                throw Exception("Corrupted archive index: " + path, ExceptionType::LOAD_ASSET);
+
+            // The mapping is page-aligned and the index offset is checked above, so entries are read in place
+            this->entries = reinterpret_cast<const ArchiveEntry*>(this->file.data + header.indexOffset);
+            this->entryCount = header.entryCount;
+            this->names = reinterpret_cast<const char*>(this->file.data + header.namesOffset);
+
+            for (UInt i = 0; i != this->entryCount; ++i)
+            {
+                const ArchiveEntry& entry = this->entries[i];
+                if (entry.offset + entry.storedSize > this->file.size || static_cast<LUInt>(entry.nameOffset) + entry.nameLength > header.namesSize
+                    || (entry.compression == ArchiveCompression::NONE && entry.storedSize != entry.size) || entry.compression > ArchiveCompression::LZ4)
+                    throw Exception("Corrupted archive entry " + std::to_string(i) + ": " + path, ExceptionType::LOAD_ASSET);
+            }
+        }
+        catch (...)
+        {
+            OS::UnmapFile(this->file);
+            throw;
+        }
+
+        ATR_LOG("Mounted archive " + path + " with " + std::to_string(this->entryCount) + " entries")
+    }
+
+    AssetArchive::~AssetArchive()
+    {
+        OS::UnmapFile(this->file);
+    }
+
+    const ArchiveEntry* AssetArchive::Find(const String& name) const
+    {
+        const String normalized = NormalizeArchiveName(name);
+        const LUInt hash = ArchiveHash(normalized);
+
+        const ArchiveEntry* end = this->entries + this->entryCount;
+        const ArchiveEntry* entry = std::lower_bound(this->entries, end, hash, [](const ArchiveEntry& e, LUInt h) { return e.hash < h; });
+        for (; entry != end && entry->hash == hash; ++entry)
+            if (normalized.compare(0, String::npos, this->names + entry->nameOffset, entry->nameLength) == 0)
+                return entry;
+        return nullptr;
+    }
+
+    void AssetArchive::ReadInto(const ArchiveEntry& entry, uint8_t* destination) const
+    {
+        const uint8_t* source = this->file.data + entry.offset;
+        if (entry.compression == ArchiveCompression::LZ4)
+            LZ4::Decompress(source, entry.storedSize, destination, entry.size);
+        else
+            memcpy(destination, source, entry.size);
+    }
+
+    std::vector<uint8_t> AssetArchive::Read(const String& name) const
+    {
+        const ArchiveEntry* entry = this->Find(name);
+        if (entry == nullptr)
+            throw Exception("Asset " + name + " not found in archive " + this->path, ExceptionType::LOAD_ASSET);
+
+        std::vector<uint8_t> data(entry->size);
+        this->ReadInto(*entry, data.data());
+        return data;
+    }
+
+    std::vector<std::future<void>> AssetArchive::ReadInto(ThreadPool& pool, const std::vector<ReadRequest>& requests) const
+    {
+        std::vector<std::future<void>> reads;
+        reads.reserve(requests.size());
+        for (const ReadRequest& request : requests)
+            reads.push_back(pool.Submit([this, request]() { this->ReadInto(*request.entry, request.destination); }));
+        return reads;
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "atrfwd.h"
+
+#include "ArchiveFormat.h"
+#include "MemoryStream.h"
+#include "ATROSSpec.h"
+#include "ATRThreadPool.h"
+
+#include <future>
+
+namespace ATR
+{
+    // Read-only view of a packed .atrpak archive
+    //  The whole file is memory-mapped once; lookups binary-search the sorted hash index and entries decompress straight from the mapping
+    //  into caller memory (e.g. a mapped staging buffer), so no file handles are opened per asset. All const members are thread-safe
+    class AssetArchive
+    {
+    public:
+        explicit AssetArchive(const String& path);
+        ~AssetArchive();
+
+        AssetArchive(const AssetArchive&) = delete;
+        AssetArchive& operator=(const AssetArchive&) = delete;
+
+        const ArchiveEntry* Find(const String& name) const;
+        inline Bool Contains(const String& name) const { return this->Find(name) != nullptr; }
+
+        // Writes exactly entry.size bytes to destination
+        void ReadInto(const ArchiveEntry& entry, uint8_t* destination) const;
+        std::vector<uint8_t> Read(const String& name) const;
+
+        // Calls parse(std::istream&) over the contents of `name`; stored (uncompressed) entries are parsed straight from the mapping
+        template <typename F>
+        auto Parse(const String& name, F&& parse) const
+        {
+            const ArchiveEntry* entry = this->Find(name);
+            if (entry == nullptr)
+                throw Exception("Asset " + name + " not found in archive " + this->path, ExceptionType::LOAD_ASSET);
+
+            std::vector<uint8_t> decompressed;
+            const uint8_t* data = this->file.data + entry->offset;
+            if (entry->compression != ArchiveCompression::NONE)
+            {
+                decompressed.resize(entry->size);
+                this->ReadInto(*entry, decompressed.data());
+                data = decompressed.data();
+            }
+
+            MemoryStream stream(data, entry->size);
+            return parse(static_cast<std::istream&>(stream));
+        }
+
+        struct ReadRequest
+        {
+            const ArchiveEntry* entry;
+            uint8_t* destination;
+        };
+
+        // Decompresses a batch of entries in parallel; destinations must stay valid until the futures are ready
+        std::vector<std::future<void>> ReadInto(ThreadPool& pool, const std::vector<ReadRequest>& requests) const;
+
+        inline const String& Path() const { return this->path; }
+        inline UInt EntryCount() const { return this->entryCount; }
+
+    private:
+        String path;
+        MappedFile file;
+
+        const ArchiveEntry* entries = nullptr;
+        UInt entryCount = 0;
+        const char* names = nullptr;
+    };
+}
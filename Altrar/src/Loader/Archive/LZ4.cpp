@@ -0,0 +1,165 @@
+#include "atrpch.h"
+
+#include "LZ4.h"
+
+#include <cstring>
+
+namespace ATR
+{
+    namespace
+    {
+        inline UInt Read32(const uint8_t* p)
+        {
+            UInt value;
+            memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        // Length fields continue in bytes of 255 once the 4-bit nibble saturates
+        inline uint8_t* WriteLength(uint8_t* op, size_t length)
+        {
+            for (; length >= 255; length -= 255)
+                *op++ = 255;
+            *op++ = static_cast<uint8_t>(length);
+            return op;
+        }
+    }
+
+    size_t LZ4::Compress(const uint8_t* source, size_t size, uint8_t* destination, size_t capacity)
+    {
+        const uint8_t* const end = source + size;
+        uint8_t* op = destination;
+        uint8_t* const opEnd = destination + capacity;
+
+        const uint8_t* anchor = source;
+        auto emitSequence = [&](const uint8_t* literalEnd, size_t offset, size_t matchLength) -> Bool {
+            const size_t literalLength = static_cast<size_t>(literalEnd - anchor);
+            if (static_cast<size_t>(opEnd - op) < 1 + literalLength + literalLength / 255 + 1 + 2 + matchLength / 255 + 1)
+                return false;
+
+            uint8_t* token = op++;
+            *token = static_cast<uint8_t>(std::min<size_t>(literalLength, 15) << 4);
+            if (literalLength >= 15)
+                op = WriteLength(op, literalLength - 15);
+            if (literalLength != 0)
+                memcpy(op, anchor, literalLength);
+            op += literalLength;
+
+            if (matchLength == 0)
+                return true;                        // Final literal-only sequence
+
+            *op++ = static_cast<uint8_t>(offset);
+            *op++ = static_cast<uint8_t>(offset >> 8);
+            const size_t lengthCode = matchLength - LZ4::minMatch;
+            *token |= static_cast<uint8_t>(std::min<size_t>(lengthCode, 15));
+            if (lengthCode >= 15)
+                op = WriteLength(op, lengthCode - 15);
+            return true;
+        };
+
+        if (size > LZ4::matchStartLimit)
+        {
+            // Positions are stored plus one, so that 0 marks an empty bucket
+            std::vector<UInt> table(static_cast<size_t>(1) << LZ4::hashLog, 0);
+            const uint8_t* const matchLimit = end - LZ4::lastLiterals;
+            const uint8_t* const startLimit = end - LZ4::matchStartLimit;
+
+            const uint8_t* ip = source;
+            UInt misses = 0;
+            while (ip < startLimit)
+            {
+                const UInt sequence = Read32(ip);
+                const UInt hash = (sequence * 2654435761u) >> (32 - LZ4::hashLog);
+                const UInt candidate = table[hash];
+                table[hash] = static_cast<UInt>(ip - source) + 1;
+
+                const uint8_t* match = source + candidate - 1;
+                if (candidate == 0 || static_cast<size_t>(ip - match) > LZ4::maxOffset || Read32(match) != sequence)
+                {
+                    ip += 1 + (misses++ >> 6);      // Skip faster through incompressible data
+                    continue;
+                }
+
+                // Extend the match backwards over pending literals, then forwards up to the literal tail
+                while (ip > anchor && match > source && ip[-1] == match[-1])
+                {
+                    --ip;
+                    --match;
+                }
+                size_t length = LZ4::minMatch;
+                while (ip + length < matchLimit && ip[length] == match[length])
+                    ++length;
+
+                if (!emitSequence(ip, static_cast<size_t>(ip - match), length))
+                    return 0;
+
+                ip += length;
+                anchor = ip;
+                misses = 0;
+            }
+        }
+
+        if (!emitSequence(end, 0, 0))
+            return 0;
+        return static_cast<size_t>(op - destination);
+    }
+
+    void LZ4::Decompress(const uint8_t* source, size_t compressedSize, uint8_t* destination, size_t size)
+    {
+        const uint8_t* ip = source;
+        const uint8_t* const ipEnd = source + compressedSize;
+        uint8_t* op = destination;
+        uint8_t* const opEnd = destination + size;
+
+        auto readLength = [&](size_t length) {
+            if (length != 15)
+                return length;
+            uint8_t byte;
+            do
+            {
+                if (ip == ipEnd)
+                    throw Exception("Truncated LZ4 length", ExceptionType::LOAD_ASSET);
+                byte = *ip++;
+                length += byte;
+            } while (byte == 255);
+            return length;
+        };
+
+        while (ip != ipEnd)
+        {
+            const uint8_t token = *ip++;
+
+            const size_t literalLength = readLength(token >> 4);
+            if (literalLength > static_cast<size_t>(ipEnd - ip) || literalLength > static_cast<size_t>(opEnd - op))
+                throw Exception("LZ4 literals out of bounds", ExceptionType::LOAD_ASSET);
+            if (literalLength != 0)
+                memcpy(op, ip, literalLength);
+            ip += literalLength;
+            op += literalLength;
+
+            if (ip == ipEnd)
+                break;                              // The last sequence carries no match
+
+            if (ipEnd - ip < 2)
+                throw Exception("Truncated LZ4 offset", ExceptionType::LOAD_ASSET);
+            const size_t offset = ip[0] | (ip[1] << 8);
+            ip += 2;
+
+            const size_t matchLength = readLength(token & 15) + LZ4::minMatch;
+            if (offset == 0 || offset > static_cast<size_t>(op - destination) || matchLength > static_cast<size_t>(opEnd - op))
+                throw Exception("LZ4 match out of bounds", ExceptionType::LOAD_ASSET);
+
+            // Overlapping matches replicate the preceding bytes, so they are copied forward byte by byte
+            const uint8_t* match = op - offset;
+            if (offset >= matchLength)
+                memcpy(op, match, matchLength);
+            else
+                for (size_t i = 0; i != matchLength; ++i)
+                    op[i] = match[i];
+            op += matchLength;
+        }
+
+        if (op != opEnd)
+            throw Exception("LZ4 data does not match the expected size", ExceptionType::LOAD_ASSET);
+    }
+}
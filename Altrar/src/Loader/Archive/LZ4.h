@@ -0,0 +1,26 @@
+#pragma once
+#include "atrfwd.h"
+
+namespace ATR
+{
+    // LZ4 block format (no frame), compatible with the reference implementation's LZ4_compress_default/LZ4_decompress_safe
+    //  Greedy single-probe matching: fast, at a somewhat lower ratio than the reference high-compression modes
+    class LZ4
+    {
+    public:
+        static inline size_t CompressBound(size_t size) { return size + size / 255 + 16; }
+
+        // Returns the compressed size, or 0 if the output does not fit in `capacity`
+        static size_t Compress(const uint8_t* source, size_t size, uint8_t* destination, size_t capacity);
+
+        // Decodes exactly `size` bytes; malformed or truncated input throws
+        static void Decompress(const uint8_t* source, size_t compressedSize, uint8_t* destination, size_t size);
+
+    private:
+        static inline constexpr size_t minMatch = 4;
+        static inline constexpr size_t lastLiterals = 5;            // The last 5 bytes of a block are always literals
+        static inline constexpr size_t matchStartLimit = 12;        // ...and the last match starts at least 12 bytes before the end
+        static inline constexpr size_t maxOffset = 65535;
+        static inline constexpr UInt hashLog = 16;
+    };
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "atrfwd.h"
+
+#include <istream>
+#include <streambuf>
+
+namespace ATR
+{
+    // Seekable std::istream over memory the caller keeps alive, so that stream-based loaders can decode archive entries without copies
+    class MemoryStreamBuffer : public std::streambuf
+    {
+    public:
+        MemoryStreamBuffer(const uint8_t* data, size_t size)
+        {
+            char* begin = const_cast<char*>(reinterpret_cast<const char*>(data));
+            this->setg(begin, begin, begin + size);
+        }
+
+    protected:
+        pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode) override
+        {
+            off_type base = direction == std::ios_base::beg ? 0 : direction == std::ios_base::cur ? this->gptr() - this->eback() : this->egptr() - this->eback();
+            off_type target = base + offset;
+            if (target < 0 || target > this->egptr() - this->eback())
+                return pos_type(off_type(-1));
+            this->setg(this->eback(), this->eback() + target, this->egptr());
+            return pos_type(target);
+        }
+
+        pos_type seekpos(pos_type position, std::ios_base::openmode mode) override
+        {
+            return this->seekoff(off_type(position), std::ios_base::beg, mode);
+        }
+    };
+
+    class MemoryStream : public std::istream
+    {
+    public:
+        MemoryStream(const uint8_t* data, size_t size)
+            : std::istream(nullptr), buffer(data, size)
+        {
+            this->rdbuf(&this->buffer);
+        }
+
+    private:
+        MemoryStreamBuffer buffer;
+    };
+}
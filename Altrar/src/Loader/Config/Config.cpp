@@ -45,7 +45,20 @@ namespace ATR
         width(800), height(600),
         enableValidation(true),
         location(""),
-        validationLayers({"VK_LAYER_KHRONOS_validation"})
+        validationLayers({"VK_LAYER_KHRONOS_validation"}),
+        textureBudget(0),
+        archive(""),
+        pipelineCache("pipeline.cache"),
+        shaderDirectory(""),
+        shaderCache("shader-cache"),
+        dynamicRendering(false),
+        extendedDynamicState(false),
+        gpuCulling(false),
+        cpuCulling(false),
+        occlusionCulling(false),
+        twoPhaseOcclusion(false),
+        bindless(false),
+        parallelRecording(false)
     {
         const String configPath = "config.yaml";
         std::ifstream ifs(configPath);
@@ -63,6 +76,19 @@ namespace ATR
             LOAD_DATA_FROM_YAML_NOERROR(this->height, root, height, UInt);
             LOAD_DATA_FROM_YAML_NOERROR(this->enableValidation, root, validation, Bool);
             LOAD_DATA_FROM_YAML_NOERROR(this->location, root, location, String);
+            LOAD_DATA_FROM_YAML_NOERROR(this->textureBudget, root, texture-budget, UInt);
+            LOAD_DATA_FROM_YAML_NOERROR(this->archive, root, archive, String);
+            LOAD_DATA_FROM_YAML_NOERROR(this->pipelineCache, root, pipeline-cache, String);
+            LOAD_DATA_FROM_YAML_NOERROR(this->shaderDirectory, root, shader-directory, String);
+            LOAD_DATA_FROM_YAML_NOERROR(this->shaderCache, root, shader-cache, String);
+            LOAD_DATA_FROM_YAML_NOERROR(this->dynamicRendering, root, dynamic-rendering, Bool);
+            LOAD_DATA_FROM_YAML_NOERROR(this->extendedDynamicState, root, extended-dynamic-state, Bool);
+            LOAD_DATA_FROM_YAML_NOERROR(this->gpuCulling, root, gpu-culling, Bool);
+            LOAD_DATA_FROM_YAML_NOERROR(this->cpuCulling, root, cpu-culling, Bool);
+            LOAD_DATA_FROM_YAML_NOERROR(this->occlusionCulling, root, occlusion-culling, Bool);
+            LOAD_DATA_FROM_YAML_NOERROR(this->twoPhaseOcclusion, root, two-phase-occlusion, Bool);
+            LOAD_DATA_FROM_YAML_NOERROR(this->bindless, root, bindless-textures, Bool);
+            LOAD_DATA_FROM_YAML_NOERROR(this->parallelRecording, root, parallel-recording, Bool);
             if (this->enableValidation)
             {
                 LOAD_NODE_FROM_YAML_NOERROR(validationLayerNode, root, validation-layers);
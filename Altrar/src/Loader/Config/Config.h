@@ -9,6 +9,19 @@ namespace ATR
         Bool enableValidation;
         String location;
         std::vector<String> validationLayers;
+        UInt textureBudget;                         // In MiB; 0 keeps every texture fully resident
+        String archive;                             // Packed asset archive searched before loose files; empty for none
+        String pipelineCache;                       // Pipeline cache file kept across launches; empty disables it
+        String shaderDirectory;                     // Shader sources watched and reloaded on change; empty disables hot reload
+        String shaderCache;                         // Directory of SPIR-V compiled at runtime, keyed by source; empty disables it
+        Bool dynamicRendering;                      // Render without render pass and framebuffer objects where the device allows
+        Bool extendedDynamicState;                  // Set cull mode, front face, topology and depth state per draw instead of per pipeline
+        Bool gpuCulling;                            // Frustum cull instances in a compute pass that writes the indirect draws
+        Bool cpuCulling;                            // Frustum cull instances on the CPU instead, over SIMD registers on several threads
+        Bool occlusionCulling;                      // Also cull instances hidden behind the previous frame's depth; needs GPU culling
+        Bool twoPhaseOcclusion;                     // Test occluded instances again against this frame's depth, drawing what they reveal
+        Bool bindless;                              // Index thousands of textures through one partially bound array where descriptor indexing allows
+        Bool parallelRecording;                     // Record the draws of large frames into secondary command buffers on several threads
 
         Config();
         Config(const Config&) = default;
@@ -28,6 +41,18 @@ namespace ATR
 #endif
                 Format::item << "Width: " << config.width << ", " << "Height: " << config.height << "\n" <<
                 Format::item << "Enable Validation: " << config.enableValidation << "\n" <<
+                Format::item << "Texture Budget: " << config.textureBudget << " MiB\n" <<
+                Format::item << "Asset Archive: " << (config.archive.empty() ? "none" : config.archive) << "\n" <<
+                Format::item << "Pipeline Cache: " << (config.pipelineCache.empty() ? "none" : config.pipelineCache) << "\n" <<
+                Format::item << "Shader Hot Reload: " << (config.shaderDirectory.empty() ? "off" : config.shaderDirectory) << "\n" <<
+                Format::item << "Shader Cache: " << (config.shaderCache.empty() ? "none" : config.shaderCache) << "\n" <<
+                Format::item << "Dynamic Rendering: " << (config.dynamicRendering ? "on" : "off") << "\n" <<
+                Format::item << "Extended Dynamic State: " << (config.extendedDynamicState ? "on" : "off") << "\n" <<
+                Format::item << "GPU Culling: " << (config.gpuCulling ? "on" : "off") << "\n" <<
+                Format::item << "CPU Culling: " << (config.cpuCulling ? "on" : "off") << "\n" <<
+                Format::item << "Occlusion Culling: " << (config.occlusionCulling ? (config.twoPhaseOcclusion ? "two-phase" : "on") : "off") << "\n" <<
+                Format::item << "Bindless Textures: " << (config.bindless ? "on" : "off") << "\n" <<
+                Format::item << "Parallel Recording: " << (config.parallelRecording ? "on" : "off") << "\n" <<
                 Format::item << "Validation Layers: \n" << Format::subitem << layerStr;
         }
     };
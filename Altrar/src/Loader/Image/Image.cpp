@@ -0,0 +1,316 @@
+#include "atrpch.h"
+
+#include "Image.h"
+
+namespace ATR
+{
+    ImageData ImageLoader::Load(const String& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open())
+            throw Exception("Failed to open image: " + path, ExceptionType::LOAD_ASSET);
+
+        return Load(path, file);
+    }
+
+    ImageData ImageLoader::Load(const String& path, std::istream& file)
+    {
+        String extension = path.substr(path.find_last_of('.') + 1);
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::tolower(c)); });
+
+        if (extension == "tga")
+            return LoadTGA(file, path);
+        else if (extension == "ppm" || extension == "pgm")
+            return LoadPPM(file, path);
+        else if (extension == "ktx2")
+            return LoadKTX2(file, path);
+
+        throw Exception("Unsupported image format: " + path, ExceptionType::LOAD_ASSET);
+    }
+
+    ImageData ImageLoader::LoadTGA(std::istream& file, const String& path)
+    {
+        uint8_t header[18];
+        if (!file.read(reinterpret_cast<char*>(header), sizeof(header)))
+            throw Exception("Truncated TGA header: " + path, ExceptionType::LOAD_ASSET);
+
+        const uint8_t idLength = header[0];
+        const uint8_t colorMapType = header[1];
+        const uint8_t imageType = header[2];
+        const UInt width = header[12] | (header[13] << 8);
+        const UInt height = header[14] | (header[15] << 8);
+        const UInt bytesPerPixel = header[16] / 8;
+        const Bool topLeftOrigin = header[17] & 0x20;
+
+        // Only true-color (2) and grayscale (3) images are supported, optionally run-length encoded (+8)
+        const Bool rle = imageType == 10 || imageType == 11;
+        const Bool grayscale = imageType == 3 || imageType == 11;
+        if (colorMapType != 0 || (imageType != 2 && imageType != 3 && !rle))
+            throw Exception("Unsupported TGA image type: " + path, ExceptionType::LOAD_ASSET);
+        if ((grayscale && bytesPerPixel != 1) || (!grayscale && bytesPerPixel != 3 && bytesPerPixel != 4))
+            throw Exception("Unsupported TGA pixel depth: " + path, ExceptionType::LOAD_ASSET);
+
+        file.seekg(idLength, std::ios::cur);
+
+        const size_t pixelCount = static_cast<size_t>(width) * height;
+        std::vector<uint8_t> raw(pixelCount * bytesPerPixel);
+        if (!rle)
+            file.read(reinterpret_cast<char*>(raw.data()), raw.size());
+        else
+        {
+            // Each packet is a header byte followed by either one repeated pixel or a run of literal pixels
+            size_t written = 0;
+            while (written < raw.size() && file)
+            {
+                uint8_t packet = static_cast<uint8_t>(file.get());
+                size_t count = (packet & 0x7F) + 1;
+                if (written + count * bytesPerPixel > raw.size())
+                    break;
+
+                if (packet & 0x80)
+                {
+                    uint8_t pixel[4];
+                    file.read(reinterpret_cast<char*>(pixel), bytesPerPixel);
+                    for (size_t i = 0; i != count; ++i, written += bytesPerPixel)
+                        std::copy(pixel, pixel + bytesPerPixel, raw.begin() + written);
+                }
+                else
+                {
+                    file.read(reinterpret_cast<char*>(raw.data() + written), count * bytesPerPixel);
+                    written += count * bytesPerPixel;
+                }
+            }
+        }
+
+        if (!file)
+            throw Exception("Truncated TGA pixel data: " + path, ExceptionType::LOAD_ASSET);
+
+        ImageData image = CreateRGBA(width, height);
+
+        // TGA stores BGR(A), bottom row first unless the origin bit is set; Vulkan samples the first row as the top
+        for (UInt y = 0; y != height; ++y)
+        {
+            const UInt srcRow = topLeftOrigin ? y : height - 1 - y;
+            const uint8_t* src = raw.data() + static_cast<size_t>(srcRow) * width * bytesPerPixel;
+            uint8_t* dst = image.pixels.data() + static_cast<size_t>(y) * width * ImageData::channels;
+
+            for (UInt x = 0; x != width; ++x, src += bytesPerPixel, dst += ImageData::channels)
+            {
+                if (grayscale)
+                {
+                    dst[0] = dst[1] = dst[2] = src[0];
+                    dst[3] = 255;
+                }
+                else
+                {
+                    dst[0] = src[2];
+                    dst[1] = src[1];
+                    dst[2] = src[0];
+                    dst[3] = bytesPerPixel == 4 ? src[3] : 255;
+                }
+            }
+        }
+
+        return image;
+    }
+
+    ImageData ImageLoader::LoadPPM(std::istream& file, const String& path)
+    {
+        // Header tokens are whitespace separated and may be interleaved with '#' comments
+        auto nextToken = [&file]() -> String {
+            String token;
+            while (file >> token)
+            {
+                if (token[0] != '#')
+                    return token;
+                file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            }
+            return "";
+        };
+
+        const String magic = nextToken();
+        if (magic != "P6" && magic != "P5")
+            throw Exception("Only binary PPM/PGM images are supported: " + path, ExceptionType::LOAD_ASSET);
+
+        const Bool grayscale = magic == "P5";
+        UInt width = 0, height = 0, maxValue = 0;
+        try
+        {
+            width = std::stoul(nextToken());
+            height = std::stoul(nextToken());
+            maxValue = std::stoul(nextToken());
+        }
+        catch (const std::exception&)
+        {
+            throw Exception("Malformed PPM header: " + path, ExceptionType::LOAD_ASSET);
+        }
+
+        if (maxValue == 0 || maxValue > 255)
+            throw Exception("Only 8-bit PPM images are supported: " + path, ExceptionType::LOAD_ASSET);
+
+        file.get();                     // Single whitespace separating the header from the raster
+
+        const UInt bytesPerPixel = grayscale ? 1 : 3;
+        const size_t pixelCount = static_cast<size_t>(width) * height;
+        std::vector<uint8_t> raw(pixelCount * bytesPerPixel);
+        if (!file.read(reinterpret_cast<char*>(raw.data()), raw.size()))
+            throw Exception("Truncated PPM pixel data: " + path, ExceptionType::LOAD_ASSET);
+
+        ImageData image = CreateRGBA(width, height);
+
+        for (size_t i = 0; i != pixelCount; ++i)
+        {
+            const uint8_t* src = raw.data() + i * bytesPerPixel;
+            uint8_t* dst = image.pixels.data() + i * ImageData::channels;
+            for (UInt c = 0; c != 3; ++c)
+                dst[c] = static_cast<uint8_t>(src[grayscale ? 0 : c] * 255 / maxValue);
+            dst[3] = 255;
+        }
+
+        return image;
+    }
+
+    ImageData ImageLoader::LoadKTX2(std::istream& file, const String& path)
+    {
+        static constexpr uint8_t identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+        // Fixed-size part of the KTX2 header, followed by the level index
+        struct
+        {
+            uint8_t identifier[12];
+            UInt vkFormat, typeSize;
+            UInt pixelWidth, pixelHeight, pixelDepth;
+            UInt layerCount, faceCount, levelCount;
+            UInt supercompressionScheme;
+            UInt dfdByteOffset, dfdByteLength, kvdByteOffset, kvdByteLength;
+            LUInt sgdByteOffset, sgdByteLength;
+        } header;
+        static_assert(sizeof(header) == 80, "KTX2 header must not be padded");
+
+        struct LevelIndex
+        {
+            LUInt byteOffset, byteLength, uncompressedByteLength;
+        };
+
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || !std::equal(std::begin(identifier), std::end(identifier), header.identifier))
+            throw Exception("Not a KTX2 file: " + path, ExceptionType::LOAD_ASSET);
+
+        if (header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1)
+            throw Exception("Only 2D KTX2 textures are supported: " + path, ExceptionType::LOAD_ASSET);
+        if (header.supercompressionScheme != 0)
+            throw Exception("Supercompressed KTX2 textures are not supported: " + path, ExceptionType::LOAD_ASSET);
+
+        VkFormat format = static_cast<VkFormat>(header.vkFormat);
+        if (!ImageData::RGBA8(format) && !ImageData::BlockCompressed(format))
+            throw Exception("Unsupported KTX2 format " + std::to_string(header.vkFormat) + ": " + path, ExceptionType::LOAD_ASSET);
+
+        // A level count of 0 asks the loader to generate the mip chain
+        const UInt levelCount = std::max(header.levelCount, 1u);
+        std::vector<LevelIndex> levelIndices(levelCount);
+        if (!file.read(reinterpret_cast<char*>(levelIndices.data()), levelCount * sizeof(LevelIndex)))
+            throw Exception("Truncated KTX2 level index: " + path, ExceptionType::LOAD_ASSET);
+
+        ImageData image;
+        image.width = header.pixelWidth;
+        image.height = header.pixelHeight;
+        image.format = format;
+
+        size_t totalSize = 0;
+        for (UInt level = 0; level != levelCount; ++level)
+        {
+            const ImageLevel imageLevel = {
+                .width = std::max(image.width >> level, 1u),
+                .height = std::max(image.height >> level, 1u),
+                .offset = totalSize,
+                .size = static_cast<size_t>(levelIndices[level].byteLength)
+            };
+            image.levels.push_back(imageLevel);
+            totalSize += (imageLevel.size + ImageData::levelAlignment - 1) / ImageData::levelAlignment * ImageData::levelAlignment;
+        }
+
+        image.pixels.resize(totalSize);
+        for (UInt level = 0; level != levelCount; ++level)
+        {
+            file.seekg(static_cast<std::streamoff>(levelIndices[level].byteOffset));
+            if (!file.read(reinterpret_cast<char*>(image.pixels.data() + image.levels[level].offset), image.levels[level].size))
+                throw Exception("Truncated KTX2 level " + std::to_string(level) + ": " + path, ExceptionType::LOAD_ASSET);
+        }
+
+        if (!image.Valid())
+            throw Exception("Malformed KTX2 file: " + path, ExceptionType::LOAD_ASSET);
+
+        return image;
+    }
+
+    void ImageLoader::GenerateMips(ImageData& image)
+    {
+        if (image.MipLevels() != 1 || !image.RGBA8())
+            return;
+
+        // Filtering happens in linear space; sRGB texels are converted through a lookup table on the way in
+        const Bool srgb = image.format == VK_FORMAT_R8G8B8A8_SRGB;
+        std::array<Float, 256> toLinear;
+        for (UInt i = 0; i != 256; ++i)
+        {
+            Float c = i / 255.f;
+            toLinear[i] = srgb ? (c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f)) : c;
+        }
+        auto fromLinear = [srgb](Float c) -> uint8_t {
+            c = srgb ? (c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.f / 2.4f) - 0.055f) : c;
+            return static_cast<uint8_t>(std::clamp(c, 0.f, 1.f) * 255.f + 0.5f);
+        };
+
+        const UInt levelCount = ImageData::FullMipCount(image.width, image.height);
+        size_t totalSize = image.levels[0].size;
+        for (UInt level = 1; level != levelCount; ++level)
+        {
+            const ImageLevel imageLevel = {
+                .width = std::max(image.width >> level, 1u),
+                .height = std::max(image.height >> level, 1u),
+                .offset = totalSize,
+                .size = static_cast<size_t>(std::max(image.width >> level, 1u)) * std::max(image.height >> level, 1u) * ImageData::channels
+            };
+            image.levels.push_back(imageLevel);
+            totalSize += imageLevel.size;
+        }
+        image.pixels.resize(totalSize);
+
+        for (UInt level = 1; level != levelCount; ++level)
+        {
+            const ImageLevel& src = image.levels[level - 1];
+            const ImageLevel& dst = image.levels[level];
+            const uint8_t* srcPixels = image.pixels.data() + src.offset;
+            uint8_t* dstPixels = image.pixels.data() + dst.offset;
+
+            // 2x2 box filter; odd source dimensions clamp the second tap onto the edge
+            for (UInt y = 0; y != dst.height; ++y)
+                for (UInt x = 0; x != dst.width; ++x)
+                {
+                    const UInt x0 = std::min(2 * x, src.width - 1), x1 = std::min(2 * x + 1, src.width - 1);
+                    const UInt y0 = std::min(2 * y, src.height - 1), y1 = std::min(2 * y + 1, src.height - 1);
+                    const uint8_t* taps[4] = {
+                        srcPixels + (static_cast<size_t>(y0) * src.width + x0) * ImageData::channels,
+                        srcPixels + (static_cast<size_t>(y0) * src.width + x1) * ImageData::channels,
+                        srcPixels + (static_cast<size_t>(y1) * src.width + x0) * ImageData::channels,
+                        srcPixels + (static_cast<size_t>(y1) * src.width + x1) * ImageData::channels
+                    };
+
+                    uint8_t* out = dstPixels + (static_cast<size_t>(y) * dst.width + x) * ImageData::channels;
+                    for (UInt c = 0; c != 3; ++c)
+                        out[c] = fromLinear((toLinear[taps[0][c]] + toLinear[taps[1][c]] + toLinear[taps[2][c]] + toLinear[taps[3][c]]) * 0.25f);
+                    out[3] = static_cast<uint8_t>((taps[0][3] + taps[1][3] + taps[2][3] + taps[3][3] + 2) / 4);         // Alpha is always linear
+                }
+        }
+    }
+
+    ImageData ImageLoader::CreateRGBA(UInt width, UInt height)
+    {
+        ImageData image;
+        image.width = width;
+        image.height = height;
+        image.format = VK_FORMAT_R8G8B8A8_SRGB;
+        image.pixels.resize(static_cast<size_t>(width) * height * ImageData::channels);
+        image.levels.push_back({ .width = width, .height = height, .offset = 0, .size = image.pixels.size() });
+        return image;
+    }
+}
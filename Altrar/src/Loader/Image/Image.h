@@ -0,0 +1,54 @@
+#pragma once
+#include "atrfwd.h"
+
+namespace ATR
+{
+    // Location of one mip level inside ImageData::pixels
+    struct ImageLevel
+    {
+        UInt width, height;
+        size_t offset, size;
+    };
+
+    // Decoded image; levels are stored back to back, largest first
+    //  Plain images are expanded to 8-bit RGBA and carry a single level, container formats may carry a cooked mip chain
+    struct ImageData
+    {
+        UInt width = 0, height = 0;
+        VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+        std::vector<uint8_t> pixels;
+        std::vector<ImageLevel> levels;
+
+        static inline constexpr UInt channels = 4;
+        static inline constexpr size_t levelAlignment = 16;         // Satisfies the buffer offset alignment of every texel block size
+
+        inline Bool Valid() const { return width != 0 && height != 0 && !levels.empty() && levels.back().offset + levels.back().size <= pixels.size(); }
+        inline size_t Size() const { return pixels.size(); }
+        inline UInt MipLevels() const { return static_cast<UInt>(levels.size()); }
+        inline Bool RGBA8() const { return ImageData::RGBA8(this->format); }
+
+        static inline Bool RGBA8(VkFormat format) { return format == VK_FORMAT_R8G8B8A8_SRGB || format == VK_FORMAT_R8G8B8A8_UNORM; }
+        static inline Bool BlockCompressed(VkFormat format) { return format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_BC7_SRGB_BLOCK; }
+
+        static inline UInt FullMipCount(UInt width, UInt height) { return static_cast<UInt>(std::floor(std::log2(std::max(width, height)))) + 1; }
+    };
+
+    // CPU-side image decoding; thread-safe, intended to be run on worker threads
+    class ImageLoader
+    {
+    public:
+        static ImageData Load(const String& path);
+        // Decodes from an already open stream, e.g. an archive entry; the format is still taken from the path's extension
+        static ImageData Load(const String& path, std::istream& stream);
+
+        // Box-filters the full mip chain of a single-level RGBA8 image, for devices that cannot blit the format linearly
+        static void GenerateMips(ImageData& image);
+
+    private:
+        static ImageData LoadTGA(std::istream& file, const String& path);
+        static ImageData LoadPPM(std::istream& file, const String& path);
+        static ImageData LoadKTX2(std::istream& file, const String& path);
+
+        static ImageData CreateRGBA(UInt width, UInt height);
+    };
+}
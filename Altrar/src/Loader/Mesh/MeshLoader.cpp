@@ -0,0 +1,116 @@
+#include "atrpch.h"
+
+#include "MeshLoader.h"
+
+#include <sstream>
+#include <unordered_map>
+
+namespace ATR
+{
+    Mesh MeshLoader::Load(const String& path)
+    {
+        std::ifstream file(path);
+        if (!file.is_open())
+            throw Exception("Failed to open mesh: " + path, ExceptionType::LOAD_ASSET);
+
+        return Load(path, file);
+    }
+
+    Mesh MeshLoader::Load(const String& path, std::istream& file)
+    {
+        String extension = path.substr(path.find_last_of('.') + 1);
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::tolower(c)); });
+
+        if (extension == "obj")
+            return LoadOBJ(file, path);
+
+        throw Exception("Unsupported mesh format: " + path, ExceptionType::LOAD_ASSET);
+    }
+
+    Mesh MeshLoader::LoadOBJ(std::istream& file, const String& path)
+    {
+        std::vector<Vec3> positions, normals;
+        std::vector<Vec2> texCoords;
+
+        std::vector<Vertex> vertices;
+        std::vector<UInt> indices;
+
+        // Corners sharing position, texture coordinate and normal become one vertex; keys are the packed 1-based OBJ indices
+        struct CornerHash
+        {
+            size_t operator()(const glm::uvec3& corner) const { return (corner.x * 73856093u) ^ (corner.y * 19349663u) ^ (corner.z * 83492791u); }
+        };
+        std::unordered_map<glm::uvec3, UInt, CornerHash> cornerIndices;
+
+        // OBJ indices are 1-based, negative ones count back from the latest element; 0 marks an absent attribute
+        auto resolve = [](Int index, size_t count) -> UInt {
+            return index < 0 ? static_cast<UInt>(static_cast<Int>(count) + index + 1) : static_cast<UInt>(index);
+        };
+
+        String line;
+        UInt lineNumber = 0;
+        while (std::getline(file, line))
+        {
+            ++lineNumber;
+            std::istringstream stream(line);
+            String keyword;
+            stream >> keyword;
+
+            if (keyword == "v")
+            {
+                Vec3 position;
+                stream >> position.x >> position.y >> position.z;
+                positions.push_back(position);
+            }
+            else if (keyword == "vt")
+            {
+                Vec2 texCoord;
+                stream >> texCoord.x >> texCoord.y;
+                texCoords.push_back({ texCoord.x, 1.f - texCoord.y });      // OBJ puts the texture origin at the bottom left
+            }
+            else if (keyword == "vn")
+            {
+                Vec3 normal;
+                stream >> normal.x >> normal.y >> normal.z;
+                normals.push_back(normal);
+            }
+            else if (keyword == "f")
+            {
+                std::vector<UInt> face;
+                String cornerStr;
+                while (stream >> cornerStr)
+                {
+                    Int v = 0, vt = 0, vn = 0;
+                    if (std::sscanf(cornerStr.c_str(), "%d/%d/%d", &v, &vt, &vn) != 3 &&
+                        std::sscanf(cornerStr.c_str(), "%d//%d", &v, &vn) != 2 &&
+                        std::sscanf(cornerStr.c_str(), "%d/%d", &v, &vt) != 2 &&
+                        std::sscanf(cornerStr.c_str(), "%d", &v) != 1)
+                        throw Exception("Malformed face at line " + std::to_string(lineNumber) + ": " + path, ExceptionType::LOAD_ASSET);
+
+                    const glm::uvec3 corner = { resolve(v, positions.size()), vt ? resolve(vt, texCoords.size()) : 0, vn ? resolve(vn, normals.size()) : 0 };
+                    if (corner.x == 0 || corner.x > positions.size() || corner.y > texCoords.size() || corner.z > normals.size())
+                        throw Exception("Face index out of range at line " + std::to_string(lineNumber) + ": " + path, ExceptionType::LOAD_ASSET);
+
+                    auto [iter, inserted] = cornerIndices.try_emplace(corner, static_cast<UInt>(vertices.size()));
+                    if (inserted)
+                        vertices.emplace_back(
+                            positions[corner.x - 1],
+                            corner.z ? normals[corner.z - 1] : Vec3(0.f, 0.f, 1.f),
+                            Vec3(1.f),
+                            corner.y ? texCoords[corner.y - 1] : Vec2(0.f)
+                        );
+                    face.push_back(iter->second);
+                }
+
+                // Polygons are triangulated as a fan around their first corner
+                for (size_t i = 2; i < face.size(); ++i)
+                    indices.insert(indices.end(), { face[0], face[i - 1], face[i] });
+            }
+        }
+
+        if (indices.empty())
+            throw Exception("Mesh has no faces: " + path, ExceptionType::LOAD_ASSET);
+
+        return Mesh(std::move(vertices), std::move(indices));
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include "atrfwd.h"
+
+#include "Geometry/Mesh.h"
+
+namespace ATR
+{
+    // CPU-side mesh parsing; thread-safe, intended to be run on loader threads
+    class MeshLoader
+    {
+    public:
+        static Mesh Load(const String& path);
+        // Parses an already open stream, e.g. an archive entry; the format is still taken from the path's extension
+        static Mesh Load(const String& path, std::istream& stream);
+
+    private:
+        static Mesh LoadOBJ(std::istream& file, const String& path);
+    };
+}
@@ -30,6 +30,47 @@ namespace ATR
         inline void AddTriangle(std::array<Vertex, 3> vertices) { this->vkResources.AddTriangle(vertices); }
         inline void UpdateMesh(const Mesh& mesh) { this->vkResources.UpdateMesh(mesh); }
 
+        // Proxy: asynchronous meshes; parsing and staging run on loader threads, the mesh is drawn from the frame it is published on
+        //  Identical meshes (same unchanged file, or same contents) share one GPU copy
+        inline MeshHandle LoadMesh(const String& path) { return this->vkResources.LoadMesh(path); }
+        inline MeshHandle LoadMesh(Mesh mesh) { return this->vkResources.LoadMesh(std::move(mesh)); }
+
+        // Proxy: textures; decoding starts immediately, the returned slot shows a white texture until uploaded
+        //  Loading the same unchanged file again shares the slot, which is freed once every handle is dropped
+        inline TextureHandle LoadTexture(const String& path) { return this->vkResources.LoadTexture(path); }
+        inline TextureHandle LoadTexture(const std::vector<String>& candidatePaths) { return this->vkResources.LoadTexture(candidatePaths); }
+        inline void BindTexture(const TextureHandle& texture) { this->vkResources.BindTexture(texture); }
+        // Draws the mesh with its own texture rather than the bound one
+        inline void SetMeshTexture(const MeshHandle& mesh, const TextureHandle& texture) { this->vkResources.SetMeshTexture(mesh, texture); }
+
+        // Proxy: materials; a color over the draw's texture, or over a texture of their own, drawn through the material buffer
+        //  Materials are never released; the texture of one stays loaded
+        inline UInt CreateMaterial(const Vec4& color) { return this->vkResources.CreateMaterial(color); }
+        inline UInt CreateMaterial(const Vec4& color, const TextureHandle& texture) { return this->vkResources.CreateMaterial(color, texture); }
+        inline void SetMeshMaterial(const MeshHandle& mesh, UInt material) { this->vkResources.SetMeshMaterial(mesh, material); }
+
+        // Proxy: archives; paths packed into a mounted .atrpak (see Tools/AssetPacker) are read from it before the file system
+        inline void MountArchive(const String& path) { this->vkResources.MountArchive(path); }
+
+        // Proxy: pipelines; equal states share one handle, and the pipeline compiles in the background while meshes using it draw with the default one
+        //  Programs must declare the same descriptor set as the embedded shaders (bindless.frag's with bindless textures); the pipeline applies to every handle of the mesh
+        inline UInt RegisterShaderProgram(std::vector<UInt> vertexCode, std::vector<UInt> fragmentCode) { return this->vkResources.RegisterShaderProgram(std::move(vertexCode), std::move(fragmentCode)); }
+        // Compiled from GLSL at runtime (cached on disk by source, includes and defines), and hot reloaded when edited
+        //  Compilation runs in the background; until it succeeds the program's pipelines draw with the embedded shaders
+        inline UInt LoadShaderProgram(const String& vertexPath, const String& fragmentPath, const std::vector<String>& defines = {}) { return this->vkResources.LoadShaderProgram(vertexPath, fragmentPath, defines); }
+        inline PipelineHandle GetPipeline(const PipelineState& state) { return this->vkResources.GetPipeline(state); }
+        inline void SetMeshPipeline(const MeshHandle& mesh, const PipelineHandle& pipeline) { this->vkResources.SetMeshPipeline(mesh, pipeline); }
+
+        // Proxy: instances; all instances of a mesh are drawn in one call, a mesh without any is drawn once untransformed
+        //  An instance keeps its mesh loaded until it is removed
+        inline InstanceHandle AddInstance(const MeshHandle& mesh, const Mat4& transform, const Vec4& color = Vec4(1.f)) { return this->vkResources.AddInstance(mesh, transform, color); }
+        inline void UpdateInstance(const InstanceHandle& instance, const Mat4& transform, const Vec4& color = Vec4(1.f)) { this->vkResources.UpdateInstance(instance, transform, color); }
+        inline void RemoveInstance(const InstanceHandle& instance) { this->vkResources.RemoveInstance(instance); }
+
+        // Proxy: camera; drives the view, the projection and culling; its width and height are kept at the window's
+        inline void SetCamera(const Camera& camera) { this->vkResources.SetCamera(camera); }
+        inline const Camera& GetCamera() const { return this->vkResources.GetCamera(); }
+
     private:
         Config config;
         VkResourceManager vkResources;
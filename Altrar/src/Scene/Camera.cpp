@@ -1,6 +1,25 @@
 #include "atrpch.h"
 
+#include "Camera.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+
 namespace ATR
 {
+    Mat4 Camera::View() const
+    {
+        return glm::lookAt(this->pos, this->lookAt, this->up);
+    }
+
+    Mat4 Camera::Projection() const
+    {
+        Mat4 projection = glm::perspective(this->fieldOfView, this->width / this->height, this->nearClip, this->farClip);
+        projection[1][1] *= -1;             // Vulkan designates the origin of an image to be the upper-left vertex
+        return projection;
+    }
 
+    Frustum Camera::ViewFrustum() const
+    {
+        return Frustum::FromMatrix(this->Projection() * this->View());
+    }
 }
@@ -2,19 +2,28 @@
 
 #include "atrfwd.h"
 
+#include "Geometry/Frustum.h"
+
 namespace ATR
 {
     struct Camera
     {
-        Vec3 pos;
-        Vec3 lookAt;
-        Vec3 up;
+        Vec3 pos = Vec3(2.f, 2.f, 2.f);
+        Vec3 lookAt = Vec3(0.f);
+        Vec3 up = Vec3(0.f, 0.f, 1.f);
+
+        Float width = 1.f;                  // Of the viewport, only their ratio matters; kept at the swapchain extent by the renderer
+        Float height = 1.f;
 
-        Float width;
-        Float height;
+        Float nearClip = 0.1f;
+        Float farClip = 10.f;
+        Float fieldOfView = glm::radians(45.f);    // Vertical, in radians
 
-        Float nearClip;
-        Float farClip;
+        Mat4 View() const;
+        // Depth zero to one, and y pointing down the image as Vulkan has it
+        Mat4 Projection() const;
+        // Of world space, seen through View() and Projection()
+        Frustum ViewFrustum() const;
     };
 
-}
\ No newline at end of file
+}
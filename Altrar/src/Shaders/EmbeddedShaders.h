@@ -0,0 +1,30 @@
+#pragma once
+#include "atrfwd.h"
+
+namespace ATR
+{
+    // SPIR-V of Altrar/shaders, compiled at build time by the premake build step (glslc -mfmt=num, one comma-separated word list per stage)
+    //  The generated .inc files live in the object directory, which is on the include path
+    namespace EmbeddedShaders
+    {
+        inline constexpr UInt vertex[] = {
+#include "shader.vert.inc"
+        };
+
+        inline constexpr UInt fragment[] = {
+#include "shader.frag.inc"
+        };
+
+        inline constexpr UInt bindlessFragment[] = {
+#include "bindless.frag.inc"
+        };
+
+        inline constexpr UInt cull[] = {
+#include "cull.comp.inc"
+        };
+
+        inline constexpr UInt depthPyramid[] = {
+#include "pyramid.comp.inc"
+        };
+    }
+}
@@ -0,0 +1,276 @@
+#include "atrpch.h"
+
+#include "ShaderCompiler.h"
+
+#include "ATRHash.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <set>
+#include <sstream>
+
+#if defined ATR_WITH_SHADERC
+#include <shaderc/shaderc.hpp>
+#endif
+
+namespace ATR
+{
+    namespace
+    {
+        constexpr UInt spirvMagic = 0x07230203;
+
+#if defined ATR_WITH_SHADERC
+        constexpr const char* compilerName = "shaderc";
+#else
+        constexpr const char* compilerName = "glslc";
+#endif
+
+        // Bumped whenever the compile options change, so that stale SPIR-V in existing caches is never used
+        constexpr UInt cacheVersion = 1;
+
+        // Every compilation gets its own temporary files, so that concurrent compiles of one source never share them
+        std::atomic<UInt> compilationCount = 0;
+
+        String ReadText(const std::filesystem::path& path)
+        {
+            std::ifstream file(path, std::ios::binary);
+            if (!file)
+                throw Exception("Failed to open shader source " + path.generic_string(), ExceptionType::INIT_SHADER);
+            std::stringstream contents;
+            contents << file.rdbuf();
+            return contents.str();
+        }
+
+        // Target of an `#include "..."` or `#include <...>` line, empty for any other line
+        String IncludeTarget(const String& line)
+        {
+            const size_t directive = line.find_first_not_of(" \t");
+            if (directive == String::npos || line.compare(directive, 8, "#include") != 0)
+                return "";
+            const size_t open = line.find_first_of("\"<", directive + 8);
+            if (open == String::npos)
+                return "";
+            const size_t close = line.find(line[open] == '"' ? '"' : '>', open + 1);
+            return close == String::npos ? "" : line.substr(open + 1, close - open - 1);
+        }
+
+        // Includes resolve against the including file's directory, as glslc and the includer below both do
+        void HashIncludes(const std::filesystem::path& path, const String& source, std::set<std::filesystem::path>& visited, LUInt& hash)
+        {
+            std::istringstream lines(source);
+            for (String line; std::getline(lines, line); )
+            {
+                const String target = IncludeTarget(line);
+                if (target.empty())
+                    continue;
+
+                const std::filesystem::path included = (path.parent_path() / target).lexically_normal();
+                hash = HashString(included.generic_string(), hash);
+                if (!visited.insert(included).second)
+                    continue;
+
+                std::error_code error;
+                if (!std::filesystem::is_regular_file(included, error))
+                    continue;                   // Left for the compiler to report
+                const String contents = ReadText(included);
+                hash = HashString(contents, hash);
+                HashIncludes(included, contents, visited, hash);
+            }
+        }
+
+        std::vector<UInt> ReadSpirv(const std::filesystem::path& path)
+        {
+            std::ifstream file(path, std::ios::binary | std::ios::ate);
+            if (!file)
+                return {};
+            const std::streamsize size = static_cast<std::streamsize>(file.tellg());
+            if (size <= 0 || size % sizeof(UInt) != 0)
+                return {};
+            std::vector<UInt> code(static_cast<size_t>(size) / sizeof(UInt));
+            file.seekg(0);
+            file.read(reinterpret_cast<char*>(code.data()), size);
+            if (!file || code[0] != spirvMagic)
+                return {};
+            return code;
+        }
+
+#if defined ATR_WITH_SHADERC
+        shaderc_shader_kind KindOf(const std::filesystem::path& path)
+        {
+            const String extension = path.extension().string();
+            if (extension == ".vert") return shaderc_vertex_shader;
+            if (extension == ".frag") return shaderc_fragment_shader;
+            if (extension == ".comp") return shaderc_compute_shader;
+            if (extension == ".geom") return shaderc_geometry_shader;
+            if (extension == ".tesc") return shaderc_tess_control_shader;
+            if (extension == ".tese") return shaderc_tess_evaluation_shader;
+            throw Exception("Unknown shader stage for " + path.generic_string(), ExceptionType::INIT_SHADER);
+        }
+
+        // Resolves includes relative to the including file; results are owned here until shaderc releases them
+        class Includer : public shaderc::CompileOptions::IncluderInterface
+        {
+        public:
+            shaderc_include_result* GetInclude(const char* requested, shaderc_include_type, const char* requesting, size_t) override
+            {
+                auto include = std::make_unique<Include>();
+                include->name = (std::filesystem::path(requesting).parent_path() / requested).lexically_normal().generic_string();
+                try { include->contents = ReadText(include->name); }
+                catch (const Exception& e)
+                {
+                    include->contents = e.What();
+                    include->name.clear();      // An empty name reports the contents as the error
+                }
+                include->result = { include->name.c_str(), include->name.size(), include->contents.c_str(), include->contents.size(), nullptr };
+
+                shaderc_include_result* result = &include->result;
+                result->user_data = include.release();
+                return result;
+            }
+
+            void ReleaseInclude(shaderc_include_result* result) override
+            {
+                delete static_cast<Include*>(result->user_data);
+            }
+
+        private:
+            struct Include
+            {
+                String name, contents;
+                shaderc_include_result result;
+            };
+        };
+#else
+        String GlslcPath()
+        {
+            if (const char* sdk = std::getenv("VULKAN_SDK"))
+#if defined _WIN32
+                return (std::filesystem::path(sdk) / "Bin" / "glslc.exe").string();
+#else
+                return (std::filesystem::path(sdk) / "bin" / "glslc").string();
+#endif
+            return "glslc";
+        }
+#endif
+    }
+
+    ShaderCompiler::ShaderCompiler(String cacheDirectory)
+        : cacheDirectory(std::move(cacheDirectory))
+    {
+    }
+
+    std::vector<UInt> ShaderCompiler::Compile(const String& path, const std::vector<String>& defines) const
+    {
+        const String source = ReadText(path);
+        const LUInt key = ShaderCompiler::CacheKey(path, source, defines);
+        if (std::vector<UInt> cached = this->ReadCached(key); !cached.empty())
+            return cached;
+
+        std::vector<UInt> code = ShaderCompiler::CompileSource(path, source, defines);
+        this->WriteCached(key, code);
+        return code;
+    }
+
+    LUInt ShaderCompiler::CacheKey(const String& path, const String& source, const std::vector<String>& defines)
+    {
+        // The path's extension decides the stage, so it is part of the key along with the contents
+        LUInt hash = HashValue(cacheVersion);
+        hash = HashString(compilerName, hash);
+        hash = HashString(std::filesystem::path(path).extension().string(), hash);
+        hash = HashString(source, hash);
+
+        std::set<std::filesystem::path> visited;
+        HashIncludes(std::filesystem::path(path), source, visited, hash);
+
+        hash = HashValue(defines.size(), hash);
+        for (const String& define : defines)
+            hash = HashString(define, HashValue(define.size(), hash));
+        return hash;
+    }
+
+    std::vector<UInt> ShaderCompiler::CompileSource(const String& path, [[maybe_unused]] const String& source, const std::vector<String>& defines)
+    {
+#if defined ATR_WITH_SHADERC
+        shaderc::CompileOptions options;
+        options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_0);
+        options.SetIncluder(std::make_unique<Includer>());
+        for (const String& define : defines)
+        {
+            const size_t equals = define.find('=');
+            if (equals == String::npos)
+                options.AddMacroDefinition(define);
+            else
+                options.AddMacroDefinition(define.substr(0, equals), define.substr(equals + 1));
+        }
+
+        // One compiler per calling thread, kept for the thread's lifetime
+        thread_local shaderc::Compiler compiler;
+        const shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(source, KindOf(path), path.c_str(), options);
+        if (result.GetCompilationStatus() != shaderc_compilation_status_success)
+            throw Exception("Failed to compile shader " + path + ":\n" + result.GetErrorMessage(), ExceptionType::INIT_SHADER);
+        return std::vector<UInt>(result.cbegin(), result.cend());
+#else
+        const std::filesystem::path output = std::filesystem::temp_directory_path() /
+            ("atr-shader-" + std::to_string(HashString(path)) + "-" + std::to_string(compilationCount++) + ".spv");
+
+        String command = "\"" + GlslcPath() + "\"";
+        for (const String& define : defines)
+            command += " \"-D" + define + "\"";
+        command += " -o \"" + output.string() + "\" \"" + path + "\"";
+
+        const Int status = OS::Execute(command);
+        std::vector<UInt> code = status == 0 ? ReadSpirv(output) : std::vector<UInt>();
+        std::error_code error;
+        std::filesystem::remove(output, error);
+
+        if (status != 0)
+            throw Exception("Failed to compile shader " + path + " (exit status " + std::to_string(status) + ")", ExceptionType::INIT_SHADER);
+        if (code.empty())
+            throw Exception("Compiling " + path + " produced no valid SPIR-V", ExceptionType::INIT_SHADER);
+        return code;
+#endif
+    }
+
+    std::vector<UInt> ShaderCompiler::ReadCached(LUInt key) const
+    {
+        if (this->cacheDirectory.empty())
+            return {};
+
+        std::ostringstream name;
+        name << std::hex << std::setw(16) << std::setfill('0') << key << ".spv";
+        return ReadSpirv(std::filesystem::path(this->cacheDirectory) / name.str());
+    }
+
+    void ShaderCompiler::WriteCached(LUInt key, const std::vector<UInt>& code) const
+    {
+        if (this->cacheDirectory.empty())
+            return;
+
+        // Written aside and renamed over, so that readers never see a partial module; a failure only costs the next compile
+        std::ostringstream name;
+        name << std::hex << std::setw(16) << std::setfill('0') << key << ".spv";
+        const std::filesystem::path directory = this->cacheDirectory;
+        const std::filesystem::path target = directory / name.str();
+        const std::filesystem::path temporary = directory / (name.str() + "." + std::to_string(compilationCount++) + ".tmp");
+
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(code.data()), static_cast<std::streamsize>(sizeof(UInt) * code.size()));
+            if (!file)
+            {
+                file.close();
+                std::filesystem::remove(temporary, error);
+                return;
+            }
+        }
+        std::filesystem::rename(temporary, target, error);
+        if (error)
+            std::filesystem::remove(temporary, error);
+    }
+}
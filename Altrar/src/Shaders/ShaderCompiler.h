@@ -0,0 +1,30 @@
+#pragma once
+#include "atrfwd.h"
+
+namespace ATR
+{
+    // Runtime GLSL to SPIR-V compilation, for shaders edited or generated while the renderer runs
+    //  Build-time shaders are compiled by premake instead, see Shaders/EmbeddedShaders.h
+    //  With ATR_WITH_SHADERC (premake --with-shaderc) sources compile in process through shaderc; the default build spawns glslc per compile
+    class ShaderCompiler
+    {
+    public:
+        // Results are cached in `cacheDirectory` as <key>.spv; empty disables the cache
+        explicit ShaderCompiler(String cacheDirectory = "");
+
+        // The stage follows from the extension (.vert, .frag, ...); `defines` are NAME or NAME=VALUE
+        //  Throws with the compiler's diagnostics on failure; safe to call from several threads
+        std::vector<UInt> Compile(const String& path, const std::vector<String>& defines = {}) const;
+
+        // Hash of the source, every file it includes (transitively), the defines and the compiler used
+        static LUInt CacheKey(const String& path, const String& source, const std::vector<String>& defines);
+
+    private:
+        static std::vector<UInt> CompileSource(const String& path, const String& source, const std::vector<String>& defines);
+
+        std::vector<UInt> ReadCached(LUInt key) const;
+        void WriteCached(LUInt key, const std::vector<UInt>& code) const;
+
+        String cacheDirectory;
+    };
+}
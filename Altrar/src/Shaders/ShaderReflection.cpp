@@ -0,0 +1,454 @@
+#include "atrpch.h"
+
+#include "ShaderReflection.h"
+
+#include <unordered_map>
+
+namespace ATR
+{
+    namespace
+    {
+        // SPIR-V enumerants used below, from the unified SPIR-V specification
+        namespace Op
+        {
+            constexpr UInt EntryPoint = 15;
+            constexpr UInt TypeInt = 21, TypeFloat = 22, TypeVector = 23, TypeMatrix = 24;
+            constexpr UInt TypeImage = 25, TypeSampler = 26, TypeSampledImage = 27;
+            constexpr UInt TypeArray = 28, TypeRuntimeArray = 29, TypeStruct = 30, TypePointer = 32;
+            constexpr UInt Constant = 43, SpecConstantTrue = 48, SpecConstantFalse = 49, SpecConstant = 50, Variable = 59;
+            constexpr UInt Decorate = 71, MemberDecorate = 72;
+            constexpr UInt TypeAccelerationStructure = 5341;
+        }
+
+        namespace Decoration
+        {
+            constexpr UInt SpecId = 1, Block = 2, BufferBlock = 3, ArrayStride = 6, BuiltIn = 11;
+            constexpr UInt Location = 30, Binding = 33, DescriptorSet = 34, Offset = 35;
+        }
+
+        namespace StorageClass
+        {
+            constexpr UInt UniformConstant = 0, Input = 1, Uniform = 2, PushConstant = 9, StorageBuffer = 12;
+        }
+
+        constexpr UInt spirvMagic = 0x07230203;
+        constexpr UInt imageDimBuffer = 5, imageDimSubpassData = 6;
+
+        struct Decorations
+        {
+            std::optional<UInt> set, binding, location, specId;
+            UInt arrayStride = 0;
+            Bool builtIn = false, block = false, bufferBlock = false;
+        };
+
+        struct Variable
+        {
+            UInt id, pointerType, storageClass;
+        };
+
+        VkShaderStageFlagBits StageOf(UInt executionModel)
+        {
+            switch (executionModel)
+            {
+            case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+            case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+            case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+            case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+            case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+            case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+            default:
+                throw Exception("Unsupported shader execution model " + std::to_string(executionModel), ExceptionType::INIT_SHADER);
+            }
+        }
+
+        // Parsed module: every type, constant, decoration and variable, keyed by result id
+        struct Module
+        {
+            std::unordered_map<UInt, std::vector<UInt>> types;      // Operands after the result id
+            std::unordered_map<UInt, UInt> typeOpcodes;
+            std::unordered_map<UInt, UInt> constants;               // Specialization constants hold their default
+            std::vector<std::pair<UInt, Bool>> specConstants;       // Result id, and whether it is a boolean
+            std::unordered_map<UInt, Decorations> decorations;
+            std::unordered_map<UInt, std::vector<UInt>> memberOffsets;
+            std::vector<Variable> variables;
+            VkShaderStageFlags stage = 0;
+
+            const std::vector<UInt>& Type(UInt id) const
+            {
+                auto iter = this->types.find(id);
+                if (iter == this->types.end())
+                    throw Exception("SPIR-V references unknown type " + std::to_string(id), ExceptionType::INIT_SHADER);
+                return iter->second;
+            }
+
+            UInt Opcode(UInt id) const
+            {
+                auto iter = this->typeOpcodes.find(id);
+                if (iter == this->typeOpcodes.end())
+                    throw Exception("SPIR-V references unknown type " + std::to_string(id), ExceptionType::INIT_SHADER);
+                return iter->second;
+            }
+
+            UInt Constant(UInt id) const
+            {
+                auto iter = this->constants.find(id);
+                if (iter == this->constants.end())
+                    throw Exception("SPIR-V references unknown constant " + std::to_string(id), ExceptionType::INIT_SHADER);
+                return iter->second;
+            }
+
+            Decorations DecorationsOf(UInt id) const
+            {
+                auto iter = this->decorations.find(id);
+                return iter == this->decorations.end() ? Decorations() : iter->second;
+            }
+
+            // Size in bytes under the offsets and strides the module declares; used for push-constant blocks
+            UInt SizeOf(UInt id) const
+            {
+                const std::vector<UInt>& type = this->Type(id);
+                switch (this->Opcode(id))
+                {
+                case Op::TypeInt:
+                case Op::TypeFloat:
+                    return type[0] / 8;
+                case Op::TypeVector:
+                    return type[1] * this->SizeOf(type[0]);
+                case Op::TypeMatrix:
+                    return type[1] * this->SizeOf(type[0]);
+                case Op::TypeArray:
+                {
+                    const UInt stride = this->DecorationsOf(id).arrayStride;
+                    return this->Constant(type[1]) * (stride != 0 ? stride : this->SizeOf(type[0]));
+                }
+                case Op::TypeStruct:
+                {
+                    auto offsets = this->memberOffsets.find(id);
+                    UInt size = 0;
+                    for (size_t member = 0; member != type.size(); ++member)
+                    {
+                        const UInt offset = offsets != this->memberOffsets.end() && member < offsets->second.size() ? offsets->second[member] : size;
+                        size = std::max(size, offset + this->SizeOf(type[member]));
+                    }
+                    return size;
+                }
+                default:
+                    throw Exception("Cannot size SPIR-V type " + std::to_string(id), ExceptionType::INIT_SHADER);
+                }
+            }
+
+            VkDescriptorType DescriptorTypeOf(UInt typeId, UInt storageClass) const
+            {
+                if (storageClass == StorageClass::StorageBuffer)
+                    return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                if (storageClass == StorageClass::Uniform)
+                    return this->DecorationsOf(typeId).bufferBlock ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+
+                const std::vector<UInt>& type = this->Type(typeId);
+                switch (this->Opcode(typeId))
+                {
+                case Op::TypeSampler:
+                    return VK_DESCRIPTOR_TYPE_SAMPLER;
+                case Op::TypeSampledImage:
+                    return this->Type(type[0])[1] == imageDimBuffer ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                case Op::TypeImage:
+                    // Operands: sampled type, dim, depth, arrayed, multisampled, sampled (1 = with a sampler, 2 = storage), format
+                    if (type[1] == imageDimSubpassData)
+                        return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+                    if (type[1] == imageDimBuffer)
+                        return type[5] == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+                    return type[5] == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+                case Op::TypeAccelerationStructure:
+                    return VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+                default:
+                    throw Exception("Unsupported SPIR-V descriptor type " + std::to_string(typeId), ExceptionType::INIT_SHADER);
+                }
+            }
+
+            VkFormat FormatOf(UInt scalarId, UInt components) const
+            {
+                static constexpr VkFormat float32[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+                static constexpr VkFormat float64[] = { VK_FORMAT_R64_SFLOAT, VK_FORMAT_R64G64_SFLOAT, VK_FORMAT_R64G64B64_SFLOAT, VK_FORMAT_R64G64B64A64_SFLOAT };
+                static constexpr VkFormat sint32[] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+                static constexpr VkFormat uint32[] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+
+                const std::vector<UInt>& scalar = this->Type(scalarId);
+                if (components == 0 || components > 4)
+                    throw Exception("Unsupported vertex input width", ExceptionType::INIT_SHADER);
+                if (this->Opcode(scalarId) == Op::TypeFloat && scalar[0] == 32)
+                    return float32[components - 1];
+                if (this->Opcode(scalarId) == Op::TypeFloat && scalar[0] == 64)
+                    return float64[components - 1];
+                if (this->Opcode(scalarId) == Op::TypeInt && scalar[0] == 32)
+                    return scalar[1] ? sint32[components - 1] : uint32[components - 1];
+                throw Exception("Unsupported vertex input type", ExceptionType::INIT_SHADER);
+            }
+        };
+    }
+
+    ShaderLayout ShaderReflection::Reflect(const UInt* code, size_t codeSize)
+    {
+        const size_t wordCount = codeSize / sizeof(UInt);
+        if (wordCount < 5 || code[0] != spirvMagic)
+            throw Exception("Not a SPIR-V module", ExceptionType::INIT_SHADER);
+
+        Module module;
+        for (size_t offset = 5; offset < wordCount; )
+        {
+            const UInt length = code[offset] >> 16, opcode = code[offset] & 0xFFFF;
+            if (length == 0 || offset + length > wordCount)
+                throw Exception("Truncated SPIR-V instruction", ExceptionType::INIT_SHADER);
+            const UInt* operands = code + offset + 1;
+            const UInt operandCount = length - 1;
+
+            switch (opcode)
+            {
+            case Op::EntryPoint:
+                module.stage |= StageOf(operands[0]);
+                break;
+            case Op::TypeInt: case Op::TypeFloat: case Op::TypeVector: case Op::TypeMatrix:
+            case Op::TypeImage: case Op::TypeSampler: case Op::TypeSampledImage:
+            case Op::TypeArray: case Op::TypeRuntimeArray: case Op::TypeStruct: case Op::TypePointer:
+            case Op::TypeAccelerationStructure:
+                module.types[operands[0]] = std::vector<UInt>(operands + 1, operands + operandCount);
+                module.typeOpcodes[operands[0]] = opcode;
+                break;
+            case Op::Constant:
+                module.constants[operands[1]] = operands[2];             // Array lengths are 32-bit integers
+                break;
+            case Op::SpecConstantTrue:
+            case Op::SpecConstantFalse:
+                module.constants[operands[1]] = opcode == Op::SpecConstantTrue;
+                module.specConstants.push_back({ operands[1], true });
+                break;
+            case Op::SpecConstant:
+                module.constants[operands[1]] = operands[2];             // Array lengths sized by one use its default
+                module.specConstants.push_back({ operands[1], false });
+                break;
+            case Op::Variable:
+                module.variables.push_back({ .id = operands[1], .pointerType = operands[0], .storageClass = operands[2] });
+                break;
+            case Op::Decorate:
+            {
+                Decorations& decorations = module.decorations[operands[0]];
+                switch (operands[1])
+                {
+                case Decoration::Block:         decorations.block = true; break;
+                case Decoration::BufferBlock:   decorations.bufferBlock = true; break;
+                case Decoration::ArrayStride:   decorations.arrayStride = operands[2]; break;
+                case Decoration::BuiltIn:       decorations.builtIn = true; break;
+                case Decoration::Location:      decorations.location = operands[2]; break;
+                case Decoration::Binding:       decorations.binding = operands[2]; break;
+                case Decoration::DescriptorSet: decorations.set = operands[2]; break;
+                case Decoration::SpecId:        decorations.specId = operands[2]; break;
+                }
+                break;
+            }
+            case Op::MemberDecorate:
+                if (operands[2] == Decoration::Offset)
+                {
+                    std::vector<UInt>& offsets = module.memberOffsets[operands[0]];
+                    offsets.resize(std::max<size_t>(offsets.size(), operands[1] + 1));
+                    offsets[operands[1]] = operands[3];
+                }
+                break;
+            }
+            offset += length;
+        }
+
+        if (module.stage == 0)
+            throw Exception("SPIR-V module has no entry point", ExceptionType::INIT_SHADER);
+
+        ShaderLayout layout;
+        for (const Variable& variable : module.variables)
+        {
+            const Decorations decorations = module.DecorationsOf(variable.id);
+            UInt typeId = module.Type(variable.pointerType)[1];             // Pointer operands: storage class, pointee
+
+            switch (variable.storageClass)
+            {
+            case StorageClass::UniformConstant:
+            case StorageClass::Uniform:
+            case StorageClass::StorageBuffer:
+            {
+                if (!decorations.binding)
+                    break;
+
+                // Arrays of resources become descriptor counts
+                UInt count = 1;
+                while (module.Opcode(typeId) == Op::TypeArray || module.Opcode(typeId) == Op::TypeRuntimeArray)
+                {
+                    const std::vector<UInt>& array = module.Type(typeId);
+                    count = module.Opcode(typeId) == Op::TypeArray ? count * module.Constant(array[1]) : 0;
+                    typeId = array[0];
+                }
+
+                layout.bindings.push_back({
+                    .set = decorations.set.value_or(0),
+                    .binding = *decorations.binding,
+                    .type = module.DescriptorTypeOf(typeId, variable.storageClass),
+                    .count = count,
+                    .stages = module.stage
+                });
+                break;
+            }
+            case StorageClass::PushConstant:
+            {
+                // Ranges start at the first member, so blocks from different stages may sit side by side
+                auto offsets = module.memberOffsets.find(typeId);
+                const UInt begin = offsets == module.memberOffsets.end() || offsets->second.empty() ? 0 : *std::min_element(offsets->second.begin(), offsets->second.end());
+                layout.pushConstants.push_back({ .stageFlags = module.stage, .offset = begin, .size = module.SizeOf(typeId) - begin });
+                break;
+            }
+            case StorageClass::Input:
+            {
+                if (module.stage != VK_SHADER_STAGE_VERTEX_BIT || decorations.builtIn || !decorations.location)
+                    break;
+
+                // Matrices occupy one location per column
+                UInt columns = 1;
+                if (module.Opcode(typeId) == Op::TypeMatrix)
+                {
+                    columns = module.Type(typeId)[1];
+                    typeId = module.Type(typeId)[0];
+                }
+                UInt components = 1, scalarId = typeId;
+                if (module.Opcode(typeId) == Op::TypeVector)
+                {
+                    scalarId = module.Type(typeId)[0];
+                    components = module.Type(typeId)[1];
+                }
+
+                const VkFormat format = module.FormatOf(scalarId, components);
+                const UInt size = components * module.SizeOf(scalarId);
+                for (UInt column = 0; column != columns; ++column)
+                    layout.vertexInputs.push_back({ .location = *decorations.location + column, .format = format, .size = size });
+                break;
+            }
+            }
+        }
+
+        // Specialization constants without a SpecId are internal to the module (e.g. workgroup sizes) and cannot be set
+        for (const auto& [id, boolean] : module.specConstants)
+            if (const std::optional<UInt> specId = module.DecorationsOf(id).specId)
+                layout.specConstants.push_back({ .id = *specId, .boolean = boolean, .stages = module.stage });
+
+        // Merging with an empty layout sorts and deduplicates
+        ShaderLayout reflected;
+        reflected.Merge(layout);
+        return reflected;
+    }
+
+    void ShaderLayout::Merge(const ShaderLayout& other)
+    {
+        for (const ReflectedBinding& binding : other.bindings)
+        {
+            auto existing = std::find_if(this->bindings.begin(), this->bindings.end(), [&](const ReflectedBinding& b) { return b.set == binding.set && b.binding == binding.binding; });
+            if (existing == this->bindings.end())
+                this->bindings.push_back(binding);
+            else if (existing->type != binding.type || existing->count != binding.count)
+                throw Exception("Conflicting declarations of set " + std::to_string(binding.set) + " binding " + std::to_string(binding.binding), ExceptionType::INIT_SHADER);
+            else
+                existing->stages |= binding.stages;
+        }
+        std::sort(this->bindings.begin(), this->bindings.end(), [](const ReflectedBinding& a, const ReflectedBinding& b) {
+            return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+        });
+
+        for (const VkPushConstantRange& range : other.pushConstants)
+        {
+            auto existing = std::find_if(this->pushConstants.begin(), this->pushConstants.end(), [&](const VkPushConstantRange& r) { return r.offset == range.offset && r.size == range.size; });
+            if (existing == this->pushConstants.end())
+                this->pushConstants.push_back(range);
+            else
+                existing->stageFlags |= range.stageFlags;
+        }
+
+        for (const ReflectedVertexInput& input : other.vertexInputs)
+            if (std::none_of(this->vertexInputs.begin(), this->vertexInputs.end(), [&](const ReflectedVertexInput& i) { return i.location == input.location; }))
+                this->vertexInputs.push_back(input);
+        std::sort(this->vertexInputs.begin(), this->vertexInputs.end(), [](const ReflectedVertexInput& a, const ReflectedVertexInput& b) { return a.location < b.location; });
+
+        for (const ReflectedSpecConstant& constant : other.specConstants)
+        {
+            auto existing = std::find_if(this->specConstants.begin(), this->specConstants.end(), [&](const ReflectedSpecConstant& c) { return c.id == constant.id; });
+            if (existing == this->specConstants.end())
+                this->specConstants.push_back(constant);
+            else if (existing->boolean != constant.boolean)
+                throw Exception("Conflicting declarations of specialization constant " + std::to_string(constant.id), ExceptionType::INIT_SHADER);
+            else
+                existing->stages |= constant.stages;
+        }
+        std::sort(this->specConstants.begin(), this->specConstants.end(), [](const ReflectedSpecConstant& a, const ReflectedSpecConstant& b) { return a.id < b.id; });
+    }
+
+    UInt ShaderLayout::SetCount() const
+    {
+        return this->bindings.empty() ? 0 : this->bindings.back().set + 1;
+    }
+
+    std::vector<VkDescriptorSetLayoutBinding> ShaderLayout::SetBindings(UInt set, UInt runtimeArraySize) const
+    {
+        std::vector<VkDescriptorSetLayoutBinding> setBindings;
+        for (const ReflectedBinding& binding : this->bindings)
+            if (binding.set == set)
+                setBindings.push_back({
+                    .binding = binding.binding,
+                    .descriptorType = binding.type,
+                    .descriptorCount = binding.count != 0 ? binding.count : runtimeArraySize,
+                    .stageFlags = binding.stages,
+                    .pImmutableSamplers = nullptr
+                });
+        return setBindings;
+    }
+
+    std::vector<VkDescriptorBindingFlags> ShaderLayout::SetBindingFlags(UInt set, VkDescriptorBindingFlags runtimeArrayFlags) const
+    {
+        std::vector<VkDescriptorBindingFlags> flags;
+        for (const ReflectedBinding& binding : this->bindings)
+            if (binding.set == set)
+                flags.push_back(binding.count != 0 ? 0 : runtimeArrayFlags);
+        return flags;
+    }
+
+    VkShaderStageFlags ShaderLayout::PushConstantStages(UInt offset, UInt size) const
+    {
+        // vkCmdPushConstants must name every stage whose range overlaps the update
+        VkShaderStageFlags stages = 0;
+        for (const VkPushConstantRange& range : this->pushConstants)
+            if (range.offset < offset + size && offset < range.offset + range.size)
+                stages |= range.stageFlags;
+        return stages;
+    }
+
+    UInt ShaderLayout::PushConstantSize() const
+    {
+        UInt size = 0;
+        for (const VkPushConstantRange& range : this->pushConstants)
+            size = std::max(size, range.offset + range.size);
+        return size;
+    }
+
+    UInt ShaderLayout::FeatureMask() const
+    {
+        UInt mask = 0;
+        for (const ReflectedSpecConstant& constant : this->specConstants)
+            if (constant.boolean && constant.id < 32)
+                mask |= 1u << constant.id;
+        return mask;
+    }
+
+    std::vector<VkVertexInputAttributeDescription> ShaderLayout::VertexAttributes(UInt binding, UInt firstLocation, UInt endLocation, UInt& stride) const
+    {
+        std::vector<VkVertexInputAttributeDescription> attributes;
+        stride = 0;
+        for (const ReflectedVertexInput& input : this->vertexInputs)
+        {
+            if (input.location < firstLocation || input.location >= endLocation)
+                continue;
+            attributes.push_back({ .location = input.location, .binding = binding, .format = input.format, .offset = stride });
+            stride += input.size;
+        }
+        return attributes;
+    }
+}
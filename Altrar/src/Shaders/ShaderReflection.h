@@ -0,0 +1,61 @@
+#pragma once
+#include "atrfwd.h"
+
+namespace ATR
+{
+    struct ReflectedBinding
+    {
+        UInt set = 0, binding = 0;
+        VkDescriptorType type = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+        UInt count = 1;                         // 0 for runtime-sized arrays
+        VkShaderStageFlags stages = 0;
+    };
+
+    struct ReflectedSpecConstant
+    {
+        UInt id;                                // constant_id in GLSL
+        Bool boolean;                           // Booleans are driven by pipeline feature bits; other types keep their default
+        VkShaderStageFlags stages;
+    };
+
+    struct ReflectedVertexInput
+    {
+        UInt location;
+        VkFormat format;
+        UInt size;                              // In bytes
+    };
+
+    // Resource interface of one or more shader stages, as declared in their SPIR-V
+    struct ShaderLayout
+    {
+        std::vector<ReflectedBinding> bindings;                 // Sorted by set, then binding
+        std::vector<VkPushConstantRange> pushConstants;         // One range per distinct block, stages merged
+        std::vector<ReflectedVertexInput> vertexInputs;         // Sorted by location; vertex stage only
+        std::vector<ReflectedSpecConstant> specConstants;       // Sorted by id
+
+        // Combines the interfaces of two stages; a binding declared differently by both throws
+        void Merge(const ShaderLayout& other);
+
+        UInt SetCount() const;
+        // Runtime-sized arrays get `runtimeArraySize` descriptors
+        std::vector<VkDescriptorSetLayoutBinding> SetBindings(UInt set, UInt runtimeArraySize) const;
+        // Parallel to SetBindings: `runtimeArrayFlags` for runtime-sized arrays, none for the rest
+        std::vector<VkDescriptorBindingFlags> SetBindingFlags(UInt set, VkDescriptorBindingFlags runtimeArrayFlags) const;
+        VkShaderStageFlags PushConstantStages(UInt offset, UInt size) const;
+        // End of the furthest declared push-constant range; 0 without push constants
+        UInt PushConstantSize() const;
+        // Bit i for each boolean specialization constant with id i < 32: the feature bits pipelines over these stages may set
+        UInt FeatureMask() const;
+
+        // Inputs with locations in [firstLocation, endLocation) packed tightly in location order into a single interleaved binding
+        std::vector<VkVertexInputAttributeDescription> VertexAttributes(UInt binding, UInt firstLocation, UInt endLocation, UInt& stride) const;
+    };
+
+    // Minimal SPIR-V parser deriving descriptor bindings, push-constant ranges, vertex inputs and specialization constants
+    //  Only the subset of the module needed for pipeline layouts is decoded; anything else is skipped
+    class ShaderReflection
+    {
+    public:
+        static ShaderLayout Reflect(const UInt* code, size_t codeSize);
+    };
+}
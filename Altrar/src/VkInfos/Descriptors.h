@@ -14,5 +14,51 @@ namespace ATR
         ATR_UNIFORM_MAT4 model;
         ATR_UNIFORM_MAT4 view;
         ATR_UNIFORM_MAT4 proj;
+        ATR_UNIFORM_MAT4 previousView;              // Last frame's, which the depth pyramid tested by the early culling pass was drawn with
+        ATR_UNIFORM_MAT4 previousProj;
+    };
+
+    // Per-draw values, read from a storage buffer at the draw index every instance carries (std430: a vec4 aligns the struct to 16)
+    struct DrawData
+    {
+        ATR_UNIFORM_VEC4 bounds;                    // Bounding sphere of the mesh, in the space its instances transform from
+        UInt textureIndex;
+        UInt command;                               // Index of the mesh's command this frame, `notDrawn` when it has none
+        UInt material;                              // Index into the material buffer, see MaterialData
+
+        static inline constexpr UInt notDrawn = ~0u;
+    };
+
+    // Per-material values, read from a storage buffer at the index in the draw's DrawData (std430 like it)
+    struct MaterialData
+    {
+        ATR_UNIFORM_VEC4 color;                     // Multiplies the vertex and instance colors
+        UInt textureIndex;                          // Texture slot, or `drawTexture` for the mesh's own or the bound one
+
+        static inline constexpr UInt drawTexture = ~0u;
+    };
+
+    // Push constants of the culling pass, see shaders/cull.comp
+    struct CullConstants
+    {
+        std::array<Vec4, 6> planes;                 // Frustum planes in model space, normalized, pointing inwards
+        UInt instanceCount, commandCount, groupCount;
+        UInt phase;                                 // One of the phases below
+        UInt instanceWords, drawWord;               // Layout of InstanceData in 32-bit words
+        UInt flags;                                 // Any of the flags below
+
+        static inline constexpr UInt cullPhase = 0;             // One invocation per instance
+        static inline constexpr UInt compactPhase = 1;          // One invocation per command, appending the visible ones
+        static inline constexpr UInt writePhase = 2;            // One invocation per command, in place (without draw counts)
+
+        static inline constexpr UInt occlusionFlag = 1;         // Test against the depth pyramid as well
+        static inline constexpr UInt twoPhaseFlag = 2;          // Record what the pyramid hides, for the late pass
+        static inline constexpr UInt lateFlag = 4;              // Test again what the early pass recorded, drawing after it
+    };
+
+    // Per-draw values small enough to skip the descriptor path
+    struct PushConstantObject
+    {
+        UInt textureIndex;
     };
 }
@@ -0,0 +1,30 @@
+#pragma once
+#include "atrfwd.h"
+
+#include <memory>
+
+namespace ATR
+{
+    // Per-instance vertex inputs of the embedded shaders, in location order from VkResourceManager::instanceInputLocation
+    struct InstanceData
+    {
+        Mat4 transform = Mat4(1.f);
+        Vec4 color = Vec4(1.f);
+        UInt draw = 0;                              // The mesh slot, indexing the per-draw data; set by the renderer
+    };
+
+    // Returned by AddInstance; stays valid until the instance is removed
+    struct InstanceHandle
+    {
+        UInt id = 0;
+    };
+
+    // Where an instance id currently lives: instances are kept dense per mesh, so removals move the last one into the gap
+    //  The reference keeps the mesh loaded while it has instances
+    struct InstanceSlot
+    {
+        UInt mesh = 0, index = 0;
+        std::shared_ptr<void> meshReference;
+        Bool live = false;                          // False for ids on the free list
+    };
+}
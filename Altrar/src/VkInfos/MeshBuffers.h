@@ -0,0 +1,80 @@
+#pragma once
+#include "atrfwd.h"
+
+#include <chrono>
+#include <exception>
+#include <future>
+#include <memory>
+
+#include "Geometry/Mesh.h"
+#include "Instances.h"
+#include "Staging.h"
+
+namespace ATR
+{
+    // Returned by the asynchronous mesh API: `id` is usable at once, `ready` is satisfied once the mesh is drawn
+    //  A failed load stores its exception in `ready`; the mesh is released a frame boundary after the last copy of `reference` is gone
+    struct MeshHandle
+    {
+        UInt id = 0;
+        std::shared_future<void> ready;
+        std::shared_ptr<void> reference;
+
+        inline Bool Ready() const { return this->ready.valid() && this->ready.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+    };
+
+    // Element ranges of a mesh inside the shared vertex and index buffers
+    struct MeshRange
+    {
+        UInt firstVertex = 0, vertexCount = 0;
+        UInt firstIndex = 0, indexCount = 0;
+    };
+
+    // Render-thread record of a mesh slot
+    struct MeshRecord
+    {
+        MeshRange range;
+        Vec4 bounds = Vec4(0.f);                    // Bounding sphere of the mesh, see Mesh::BoundingSphere
+        std::promise<void> published;
+        std::shared_future<void> ready;             // Handed to every handle of the slot
+        UInt requestedVersion = 0, publishedVersion = 0;    // Re-uploads of a slot may finish out of order; older versions are dropped
+        Bool loaded = false;
+        Bool settled = false;                       // Whether `published` has been satisfied
+        std::optional<LUInt> cacheKey;              // Unset for meshes outside the cache
+        UInt pipeline = 0;                          // Pipeline handle id, see PipelineVariant; 0 is the default pipeline
+        std::vector<InstanceData> instances;        // Empty draws the mesh once, untransformed
+        std::vector<UInt> instanceIds;              // Parallel to `instances`
+        UInt firstInstance = 0;                     // Of the mesh's range in the instance buffers, placed at upload
+        UInt visibleInstances = 0;                  // Under CPU culling, those written to the front of the range this frame
+        std::optional<UInt> texture;                // Unset draws with the texture bound through BindTexture
+        std::shared_ptr<void> textureReference;
+        UInt material = 0;                          // See VkResourceManager::CreateMaterial; 0 is white over the texture above
+    };
+
+    // An indexed indirect command extended with its group, as read by the culling pass; the draw itself stays usable as is
+    //  Culling appends the command's visible instances to its own instance range, and the command to its group's range of commands
+    struct DrawCommand
+    {
+        VkDrawIndexedIndirectCommand draw;
+        UInt group;                                 // Index into the frame's DrawGroups
+        UInt groupFirst;                            // The group's first command
+        UInt padding = 0;                           // To a 16-byte stride
+    };
+
+    // Consecutive indirect draws sharing a pipeline variant, submitted together
+    struct DrawGroup
+    {
+        UInt variant;
+        UInt firstCommand, commandCount;
+    };
+
+    // Produced on a loader thread: the mesh parsed and copied into a staging buffer, vertices first
+    struct StagedMesh
+    {
+        UInt id, version;
+        std::shared_ptr<const Mesh> source;
+        Vec4 bounds = Vec4(0.f);
+        BufferMemory staging;                       // Null for an empty mesh
+        std::exception_ptr error;
+    };
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include "atrfwd.h"
+
+namespace ATR
+{
+    // Prefix of the pipeline cache file, in front of the vkGetPipelineCacheData blob
+    //  The blob's own header carries vendor, device and cache UUID but no driver version, and nothing guards against a torn or corrupted file
+    struct PipelineCacheFileHeader
+    {
+        char magic[8];
+        UInt vendorID, deviceID;
+        UInt driverVersion;
+        uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+        UInt reserved;
+        LUInt dataSize;
+        LUInt dataHash;                         // FNV-1a of the blob
+    };
+    static_assert(sizeof(PipelineCacheFileHeader) == 56, "PipelineCacheFileHeader must not be padded");
+
+    inline constexpr char pipelineCacheMagic[8] = { 'A', 'T', 'R', 'P', 'S', 'O', '\0', '1' };
+}
@@ -0,0 +1,224 @@
+#pragma once
+#include "atrfwd.h"
+
+#include <future>
+
+#include "ATRHash.h"
+#include "Shaders/ShaderReflection.h"
+
+namespace ATR
+{
+    // Shader stages of a pipeline, with their reflected interface; the vertex layout is derived from the vertex stage's inputs
+    struct ShaderProgram
+    {
+        std::vector<UInt> vertexCode, fragmentCode;
+        ShaderLayout layout;
+        LUInt hash = 0;                             // Of both stages' SPIR-V
+        String vertexSource, fragmentSource;        // Recompiled when edited; empty for stages only given as SPIR-V
+        std::vector<String> defines;                // Sources are compiled with these
+    };
+
+    // A stage recompiling after its source was edited
+    struct ShaderReload
+    {
+        UInt program;
+        VkShaderStageFlagBits stage;
+        std::future<std::vector<UInt>> code;
+    };
+
+    // A program loaded from GLSL whose stages are still compiling
+    struct ShaderLoad
+    {
+        UInt program;
+        std::future<std::vector<UInt>> vertexCode, fragmentCode;
+    };
+
+    struct RasterState
+    {
+        VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+        VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+        VkFrontFace frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    };
+
+    struct DepthState
+    {
+        Bool test = true, write = true;
+        VkCompareOp compareOp = VK_COMPARE_OP_LESS;
+    };
+
+    struct BlendState
+    {
+        Bool enable = true;                         // Alpha blending by default
+        VkBlendFactor srcColor = VK_BLEND_FACTOR_SRC_ALPHA, dstColor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        VkBlendOp colorOp = VK_BLEND_OP_ADD;
+        VkBlendFactor srcAlpha = VK_BLEND_FACTOR_ONE, dstAlpha = VK_BLEND_FACTOR_ZERO;
+        VkBlendOp alphaOp = VK_BLEND_OP_ADD;
+    };
+
+    // Feature bits of the embedded shaders; bit i specializes `layout(constant_id = i) const bool` in every stage declaring it
+    namespace ShaderFeature
+    {
+        inline constexpr UInt UNTEXTURED = 1u << 0;     // Vertex colors only, no texture fetch
+    }
+
+    // Everything a graphics pipeline is baked from; viewport and scissor are dynamic and not part of it
+    struct PipelineState
+    {
+        UInt program = 0;                           // Index into the registered shader programs
+        UInt features = 0;                          // Specialization of the program's boolean constants, see ShaderFeature; clear bits are false
+        RasterState raster;
+        DepthState depth;
+        BlendState blend;
+        VkRenderPass renderPass = VK_NULL_HANDLE;   // Null for the main render pass
+        UInt subpass = 0;
+    };
+
+    // Field by field, so that padding never reaches the key
+    inline LUInt HashPipelineState(const PipelineState& state, LUInt programHash)
+    {
+        LUInt hash = HashValue(programHash);
+        hash = HashValue(state.features, hash);
+        hash = HashValue(state.raster.topology, hash);
+        hash = HashValue(state.raster.polygonMode, hash);
+        hash = HashValue(state.raster.cullMode, hash);
+        hash = HashValue(state.raster.frontFace, hash);
+        hash = HashValue(state.depth.test, hash);
+        hash = HashValue(state.depth.write, hash);
+        hash = HashValue(state.depth.compareOp, hash);
+        hash = HashValue(state.blend.enable, hash);
+        if (state.blend.enable)
+        {
+            hash = HashValue(state.blend.srcColor, hash);
+            hash = HashValue(state.blend.dstColor, hash);
+            hash = HashValue(state.blend.colorOp, hash);
+            hash = HashValue(state.blend.srcAlpha, hash);
+            hash = HashValue(state.blend.dstAlpha, hash);
+            hash = HashValue(state.blend.alphaOp, hash);
+        }
+        hash = HashValue(state.renderPass, hash);
+        return HashValue(state.subpass, hash);
+    }
+
+    // The part of a PipelineState that extended dynamic state sets while recording rather than baking into the pipeline
+    struct DynamicPipelineState
+    {
+        VkPrimitiveTopology topology;
+        VkCullModeFlags cullMode;
+        VkFrontFace frontFace;
+        Bool depthTest, depthWrite;
+        VkCompareOp depthCompareOp;
+
+        bool operator==(const DynamicPipelineState&) const = default;
+    };
+
+    inline DynamicPipelineState DynamicStateOf(const PipelineState& state)
+    {
+        return { state.raster.topology, state.raster.cullMode, state.raster.frontFace, state.depth.test, state.depth.write, state.depth.compareOp };
+    }
+
+    // Dynamic topology may only change within the baked topology's class (points, lines, triangles or patches)
+    inline VkPrimitiveTopology TopologyClass(VkPrimitiveTopology topology)
+    {
+        switch (topology)
+        {
+        case VK_PRIMITIVE_TOPOLOGY_POINT_LIST:
+            return VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+        case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
+        case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+        case VK_PRIMITIVE_TOPOLOGY_LINE_LIST_WITH_ADJACENCY:
+        case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP_WITH_ADJACENCY:
+            return VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+        case VK_PRIMITIVE_TOPOLOGY_PATCH_LIST:
+            return VK_PRIMITIVE_TOPOLOGY_PATCH_LIST;
+        default:
+            return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        }
+    }
+
+    // The state a pipeline is built from when the dynamic part is set per draw: states differing only there share one pipeline
+    inline PipelineState BakedState(PipelineState state)
+    {
+        state.raster.topology = TopologyClass(state.raster.topology);
+        state.raster.cullMode = RasterState().cullMode;
+        state.raster.frontFace = RasterState().frontFace;
+        state.depth = DepthState();
+        return state;
+    }
+
+    // Stable for the lifetime of the renderer; the pipeline behind it compiles in the background, meanwhile draws use the default pipeline
+    struct PipelineHandle
+    {
+        UInt id = 0;
+    };
+
+    // What a handle names: a registered pipeline, and the dynamic state drawn with it
+    //  Without extended dynamic state every variant has a pipeline of its own, and `dynamic` is already baked into it
+    struct PipelineVariant
+    {
+        UInt pipeline;
+        DynamicPipelineState dynamic;
+    };
+
+    inline LUInt HashPipelineVariant(const PipelineVariant& variant)
+    {
+        LUInt hash = HashValue(variant.pipeline);
+        hash = HashValue(variant.dynamic.topology, hash);
+        hash = HashValue(variant.dynamic.cullMode, hash);
+        hash = HashValue(variant.dynamic.frontFace, hash);
+        hash = HashValue(variant.dynamic.depthTest, hash);
+        hash = HashValue(variant.dynamic.depthWrite, hash);
+        return HashValue(variant.dynamic.depthCompareOp, hash);
+    }
+
+    // Produced on a pipeline thread; the layout is the one the pipeline was built against
+    struct PipelineBuild
+    {
+        VkPipeline pipeline;
+        VkPipelineLayout layout;
+        VkShaderStageFlags pushConstantStages;
+        UInt pushConstantSize;
+    };
+
+    // Layout cache entries keep what they were hashed from, so that colliding hashes never share a layout
+    struct CachedSetLayout
+    {
+        std::vector<VkDescriptorSetLayoutBinding> bindings;     // Without immutable samplers
+        std::vector<VkDescriptorBindingFlags> bindingFlags;
+        VkDescriptorSetLayout layout;
+
+        Bool Matches(const std::vector<VkDescriptorSetLayoutBinding>& otherBindings, const std::vector<VkDescriptorBindingFlags>& otherFlags) const
+        {
+            return this->bindingFlags == otherFlags && std::equal(this->bindings.begin(), this->bindings.end(), otherBindings.begin(), otherBindings.end(),
+                [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) {
+                    return a.binding == b.binding && a.descriptorType == b.descriptorType && a.descriptorCount == b.descriptorCount && a.stageFlags == b.stageFlags;
+                });
+        }
+    };
+
+    struct CachedPipelineLayout
+    {
+        std::vector<VkDescriptorSetLayout> setLayouts;
+        std::vector<VkPushConstantRange> pushConstants;
+        VkPipelineLayout layout;
+
+        Bool Matches(const std::vector<VkDescriptorSetLayout>& otherSetLayouts, const std::vector<VkPushConstantRange>& otherPushConstants) const
+        {
+            return this->setLayouts == otherSetLayouts && std::equal(this->pushConstants.begin(), this->pushConstants.end(), otherPushConstants.begin(), otherPushConstants.end(),
+                [](const VkPushConstantRange& a, const VkPushConstantRange& b) { return a.stageFlags == b.stageFlags && a.offset == b.offset && a.size == b.size; });
+        }
+    };
+
+    // Render-thread record of a registered pipeline
+    //  A rebuild leaves the current pipeline drawing until it is collected at a frame boundary
+    struct PipelineRecord
+    {
+        PipelineState state;
+        VkPipeline pipeline = VK_NULL_HANDLE;       // Null until the first build is collected
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+        VkShaderStageFlags pushConstantStages = 0;
+        UInt pushConstantSize = 0;                  // Bytes of PushConstantObject the program declares
+        std::future<PipelineBuild> building;        // Valid while a build is pending or uncollected
+        Bool failed = false;                        // Draws keep using the fallback
+    };
+}
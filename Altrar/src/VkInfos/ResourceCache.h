@@ -0,0 +1,25 @@
+#pragma once
+#include "atrfwd.h"
+
+#include <memory>
+
+#include "ATRLockFreeQueue.h"
+
+namespace ATR
+{
+    // Slot ids whose last handle was dropped; pushed from whichever thread drops it, drained by the render thread
+    using ReleaseQueue = LockFreeQueue<UInt>;
+
+    // The reference every handle of a cached resource shares; the queue is co-owned so handles may outlive the renderer
+    inline std::shared_ptr<void> MakeResourceReference(const std::shared_ptr<ReleaseQueue>& releases, UInt id)
+    {
+        return std::shared_ptr<void>(nullptr, [releases, id](void*) { releases->Push(id); });
+    }
+
+    // Cache entry: a live reference can be revived into a new handle until the release is processed
+    struct CachedResource
+    {
+        UInt id;
+        std::weak_ptr<void> reference;
+    };
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include "atrfwd.h"
+
+#include "MeshBuffers.h"
+#include "Staging.h"
+#include "Texture.h"
+
+namespace ATR
+{
+    // Resources replaced while a frame in flight may still read them; released once that frame slot's fence has signaled
+    struct RetiredResources
+    {
+        std::vector<Texture> textures;
+        std::vector<BufferMemory> buffers;
+        std::vector<MeshRange> meshRanges;          // Returned to the geometry allocators
+        std::vector<VkPipeline> pipelines;          // Replaced by a rebuild
+    };
+}
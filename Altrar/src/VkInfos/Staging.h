@@ -0,0 +1,37 @@
+#pragma once
+#include "atrfwd.h"
+
+namespace ATR
+{
+    // A buffer with its own memory allocation
+    struct BufferMemory
+    {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+    };
+
+    // Host-visible and persistently mapped, one per frame in flight so that rewriting never races the GPU; grown by reallocation
+    struct MappedBuffer
+    {
+        BufferMemory buffer;
+        void* mapped = nullptr;
+        UInt capacity = 0;                          // In elements
+    };
+
+    // Device-local and written by the GPU only, one per frame in flight like MappedBuffer; grown by reallocation, contents dropped
+    struct DeviceBuffer
+    {
+        BufferMemory buffer;
+        UInt capacity = 0;                          // In elements
+    };
+
+    // A submitted transfer whose staging memory may only be released once `fence` is signaled
+    struct StagingSubmission
+    {
+        VkFence fence = VK_NULL_HANDLE;
+        VkCommandPool commandPool = VK_NULL_HANDLE;
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+
+        std::vector<BufferMemory> stagingBuffers;
+    };
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "atrfwd.h"
+
+#include <future>
+#include <memory>
+
+#include "Loader/Image/Image.h"
+
+namespace ATR
+{
+    struct Texture
+    {
+        VkImage image = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+
+        UInt width = 0, height = 0;
+        UInt mipLevels = 1;
+        UInt baseLevel = 0;                 // Source level held in mip 0 of `image`, above 0 while finer levels are not resident
+        Bool loaded = false;                // Until the upload is recorded, the descriptor slot falls back to the default texture
+    };
+
+    // Shared ownership of a texture slot; the slot is released a frame boundary after the last copy is gone
+    //  A default-constructed handle refers to the default texture
+    struct TextureHandle
+    {
+        UInt slot = 0;
+        std::shared_ptr<void> reference;
+    };
+
+    // One entry of an upload batch; source levels finer than `baseLevel` are left out of the GPU image
+    struct TextureUpload
+    {
+        UInt slot;
+        const ImageData* image;
+        UInt baseLevel = 0;
+    };
+
+    // CPU copy of a streamed texture's full chain, from which levels are paged in and out of the GPU
+    struct TextureResidency
+    {
+        ImageData source;
+        UInt coarsestLevel = 0;             // Always resident, and all that is kept while the texture is not on screen
+        UInt desiredLevel = 0;              // Finest level asked for by the last feedback pass
+
+        inline Bool Streamed() const { return this->source.Valid(); }
+        inline size_t ResidentSize(UInt baseLevel) const { return this->source.Size() - this->source.levels[baseLevel].offset; }
+    };
+
+    // A texture still decoding on the worker pool
+    struct PendingTexture
+    {
+        UInt slot;
+        std::future<ImageData> image;
+        std::vector<String> fallbackPaths;  // Tried in order when the device cannot sample the decoded format
+    };
+}
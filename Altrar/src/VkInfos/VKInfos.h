@@ -2,6 +2,14 @@
 #include "atrfwd.h"
 
 #include "Descriptors.h"
+#include "Instances.h"
+#include "MeshBuffers.h"
+#include "PipelineCache.h"
+#include "PipelineState.h"
 #include "QueueFamilyIndices.h"
+#include "ResourceCache.h"
+#include "Retired.h"
+#include "Staging.h"
 #include "SwapChainConfig.h"
 #include "SwapChainSupport.h"
+#include "Texture.h"
@@ -1,8 +1,11 @@
 #include "atrpch.h"
 
 #include "VkResources.h"
+#include "Shaders/EmbeddedShaders.h"
+#include "Shaders/ShaderCompiler.h"
 
 #include <chrono>
+#include <filesystem>
 #include "glm/gtc/matrix_transform.hpp"
 
 namespace ATR
@@ -15,21 +18,45 @@ namespace ATR
         this->width = config.width;
         this->height = config.height;
         this->relLocation = config.location;
+        this->textureBudget = static_cast<VkDeviceSize>(config.textureBudget) << 20;
+        this->pipelineCachePath = config.pipelineCache;
+        this->shaderDirectory = config.shaderDirectory;
+        this->shaderCompiler = ShaderCompiler(config.shaderCache);
+        this->dynamicRenderingRequested = config.dynamicRendering;
+        this->extendedDynamicStateRequested = config.extendedDynamicState;
+        this->gpuCullingRequested = config.gpuCulling;
+        this->cpuCullingRequested = config.cpuCulling;
+        this->occlusionCullingRequested = config.occlusionCulling;
+        this->twoPhaseOcclusionRequested = config.twoPhaseOcclusion;
+        this->bindlessRequested = config.bindless;
+        this->parallelRecording = config.parallelRecording;
+
+        if (!config.archive.empty())
+            this->MountArchive(config.archive);
     }
 
     void VkResourceManager::Init()
     {
-        this->InitParams();
+        // Loads queued before a failed initialization give up instead of waiting for a device forever
+        try
+        {
+            this->InitParams();
 
-        // Setup GLFW Window
-        this->CreateWindow();
+            // Setup GLFW Window
+            this->CreateWindow();
 
-        // Setup Vulkan
-        this->CreateInstance();
-        this->SetupDebugMessenger();
-        this->CreateSurface();
-        this->SelectPhysicalDevice();
-        this->CreateLogicalDevice();
+            // Setup Vulkan
+            this->CreateInstance();
+            this->SetupDebugMessenger();
+            this->CreateSurface();
+            this->SelectPhysicalDevice();
+            this->CreateLogicalDevice();
+        }
+        catch (...)
+        {
+            this->deviceCreated.set_exception(std::current_exception());
+            throw;
+        }
 
         // Setup Graphics Pipeline
         this->CreateSwapchain();
@@ -37,14 +64,22 @@ namespace ATR
         this->CreateRenderPass();
         this->CreateDescriptorSetLayout();
         this->CreateGraphicsPipeline();
+        this->CreateCullPipeline();
         this->CreateCommandPool();
 
+        // Setup Shader Hot Reload
+        if (!this->shaderDirectory.empty())
+            this->shaderWatcher = std::make_unique<FileWatcher>(this->shaderDirectory);
+
         // Setup Buffers and Syncing
         this->CreateDepthBuffer();
         this->CreateTextureImage();
+        this->CreateTextureSampler();
+        this->CreateDepthPyramid();
         this->CreateVertexBuffer();
         this->CreateIndexBuffer();
         this->CreateUniformBuffer();
+        this->CreateDrawBuffers();
         this->CreateFrameBuffers();
         this->CreateDescriptorPool();
         this->CreateDescriptorSets();
@@ -63,6 +98,22 @@ namespace ATR
     {
         // Ensure that the device is subject to cleaning up
         vkDeviceWaitIdle(this->device);
+        this->ReleaseFinishedStagings(true);
+
+        // Loads still in progress finish staging, and whatever was not published is dropped
+        //  Reads in flight hand their contents to the loader threads, so they are waited for first
+        this->fileReader.WaitIdle();
+        this->loaderPool.WaitIdle();
+        while (!this->buildingPipelines.empty())
+            this->CollectPipelineBuild(this->buildingPipelines.back());
+        this->shaderReloads.clear();
+        this->shaderLoads.clear();
+        this->pipelineThreads.WaitIdle();
+        while (auto staged = this->stagedMeshes.TryPop())
+        {
+            vkDestroyBuffer(this->device, staged->staging.buffer, nullptr);
+            vkFreeMemory(this->device, staged->staging.memory, nullptr);
+        }
 
         // Clean up validation layer
         if (enabledValidation)
@@ -82,12 +133,41 @@ namespace ATR
         vkDestroyBuffer(this->device, this->indexBuffer, nullptr);
         vkFreeMemory(this->device, this->indexBufferMemory, nullptr);
 
+        for (UInt i = 0; i != VkResourceManager::maxFramesInFlight; ++i)
+            this->DestroyRetiredResources(i);
+        for (UInt i = 0; i != VkResourceManager::maxFramesInFlight; ++i)
+        {
+            for (const MappedBuffer* buffer : { &this->instanceBuffers[i], &this->drawDataBuffers[i], &this->drawCommandBuffers[i], &this->materialBuffers[i] })
+            {
+                vkDestroyBuffer(this->device, buffer->buffer.buffer, nullptr);
+                vkFreeMemory(this->device, buffer->buffer.memory, nullptr);      // Unmapped implicitly
+            }
+            for (const DeviceBuffer* buffer : { &this->culledInstanceBuffers[i], &this->culledCommandBuffers[i], &this->cullCounterBuffers[i], &this->occludedInstanceBuffers[i] })
+            {
+                vkDestroyBuffer(this->device, buffer->buffer.buffer, nullptr);
+                vkFreeMemory(this->device, buffer->buffer.memory, nullptr);
+            }
+        }
+        for (auto& texture : this->textures)
+            if (texture.loaded)
+                this->DestroyTexture(texture);
+        vkDestroySampler(this->device, this->textureSampler, nullptr);
+        vkDestroySampler(this->device, this->depthPyramidSampler, nullptr);
+
         vkDestroyCommandPool(this->device, this->graphicsCommandPool, nullptr);             // Command buffers are automatically freed when we free the command pool
         vkDestroyCommandPool(this->device, this->transferCommandPool, nullptr);
-
-        vkDestroyPipeline(this->device, this->graphicsPipeline, nullptr);
+        for (const auto& pools : this->recordCommandPools)
+            for (VkCommandPool pool : pools)
+                vkDestroyCommandPool(this->device, pool, nullptr);
+
+        for (const PipelineRecord& pipeline : this->pipelines)
+            vkDestroyPipeline(this->device, pipeline.pipeline, nullptr);
+        vkDestroyPipeline(this->device, this->cullPipeline, nullptr);
+        vkDestroyPipeline(this->device, this->depthPyramidPipeline, nullptr);
         vkDestroyRenderPass(this->device, this->renderPass, nullptr);
-        vkDestroyPipelineLayout(this->device, this->pipelineLayout, nullptr);
+        vkDestroyRenderPass(this->device, this->resumeRenderPass, nullptr);
+        for (auto& [key, cached] : this->pipelineLayoutCache)
+            vkDestroyPipelineLayout(this->device, cached.layout, nullptr);
         this->CleanUpSwapchain();
 
         for (size_t i = 0; i != VkResourceManager::maxFramesInFlight; ++i)
@@ -97,7 +177,11 @@ namespace ATR
         }
 
         vkDestroyDescriptorPool(this->device, this->descriptorPool, nullptr);
-        vkDestroyDescriptorSetLayout(this->device, this->descriptorSetLayout, nullptr);
+        for (auto& [key, cached] : this->descriptorSetLayoutCache)
+            vkDestroyDescriptorSetLayout(this->device, cached.layout, nullptr);
+
+        this->SavePipelineCache();
+        vkDestroyPipelineCache(this->device, this->pipelineCache, nullptr);
 
         vkDestroyDevice(this->device, nullptr);
         
@@ -133,6 +217,13 @@ namespace ATR
         ATR_LOG("Creating Vulkan Instance...")
         VkResourceManager::GetRequiredExtensions();
         VkResourceManager::FindValidationLayers();
+
+        // Newer API versions only where the loader knows them (1.0 loaders lack vkEnumerateInstanceVersion); capped to what this code uses
+        UInt loaderVersion = VK_API_VERSION_1_0;
+        const auto enumerateInstanceVersion = reinterpret_cast<PFN_vkEnumerateInstanceVersion>(vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion"));
+        if (enumerateInstanceVersion != nullptr)
+            enumerateInstanceVersion(&loaderVersion);
+        this->apiVersion = std::min(loaderVersion, static_cast<UInt>(VK_API_VERSION_1_3));
         
         // Vulkan Instance Creation Info
         // NOTE this cannot be extracted to a function as `appInfo` needs to be available when `VkCreateInstance` is called
@@ -143,7 +234,7 @@ namespace ATR
             .applicationVersion = VK_MAKE_VERSION(1, 0, 0),
             .pEngineName = "No Engine",
             .engineVersion = VK_MAKE_VERSION(1, 0, 0),
-            .apiVersion = VK_API_VERSION_1_0
+            .apiVersion = this->apiVersion
         };
 
         VkInstanceCreateInfo createInfo =
@@ -210,14 +301,192 @@ namespace ATR
 
         VkPhysicalDeviceProperties deviceProperties;
         vkGetPhysicalDeviceProperties(this->physicalDevice, &deviceProperties);
+        this->apiVersion = std::min(this->apiVersion, deviceProperties.apiVersion);
         ATR_PRINT_VERBOSE("Using Physical Device: " + String(deviceProperties.deviceName))
+        ATR_PRINT_VERBOSE("API Version: " << VK_API_VERSION_MAJOR(this->apiVersion) << "." << VK_API_VERSION_MINOR(this->apiVersion))
         ATR_PRINT_VERBOSE("Queue Family Indices: \n" << this->queueIndices)
     }
 
     void VkResourceManager::CreateLogicalDevice()
     {
         ATR_LOG("Setting Up Device...")
-        VkPhysicalDeviceFeatures deviceFeatures = {};
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(this->physicalDevice, &supportedFeatures);
+
+        // Only request optional features the device actually has; consumers check `enabledFeatures` before relying on them
+        VkPhysicalDeviceFeatures deviceFeatures = {
+            .multiDrawIndirect = supportedFeatures.multiDrawIndirect,
+            .drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance,
+            .samplerAnisotropy = supportedFeatures.samplerAnisotropy,
+            .textureCompressionBC = supportedFeatures.textureCompressionBC,
+            .shaderSampledImageArrayDynamicIndexing = supportedFeatures.shaderSampledImageArrayDynamicIndexing
+        };
+        this->enabledFeatures = deviceFeatures;
+        this->indirectDraws = deviceFeatures.drawIndirectFirstInstance;
+
+        UInt availableExtensionCount = 0;
+        vkEnumerateDeviceExtensionProperties(this->physicalDevice, nullptr, &availableExtensionCount, nullptr);
+        this->availableDeviceExtensions.resize(availableExtensionCount);
+        vkEnumerateDeviceExtensionProperties(this->physicalDevice, nullptr, &availableExtensionCount, this->availableDeviceExtensions.data());
+        this->enabledDeviceExtensions = this->deviceExtensions;
+
+        // Optional features beyond 1.0 are queried and enabled through one features2 chain, which needs 1.1
+        //  Only structs of the versions and extensions at hand may be chained; the query fills them in place
+        //  Extension feature structs are the core ones under other names, so both paths share them
+        void* featureChain = nullptr;
+        const auto chain = [&featureChain](auto& features) { features.pNext = featureChain; featureChain = &features; };
+
+        VkPhysicalDeviceDynamicRenderingFeatures dynamicRenderingFeatures = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES
+        };
+        const Bool dynamicRenderingCore = this->apiVersion >= VK_API_VERSION_1_3;
+        const Bool dynamicRenderingQueried = this->dynamicRenderingRequested &&
+            (dynamicRenderingCore || (this->apiVersion >= VK_API_VERSION_1_2 && this->DeviceHasExtension(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME)));
+        if (dynamicRenderingQueried)
+            chain(dynamicRenderingFeatures);
+
+        // Core 1.3 has no feature bit for it, the commands are simply there
+        VkPhysicalDeviceExtendedDynamicStateFeaturesEXT extendedDynamicStateFeatures = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT
+        };
+        const Bool extendedDynamicStateCore = this->apiVersion >= VK_API_VERSION_1_3;
+        const Bool extendedDynamicStateQueried = this->extendedDynamicStateRequested && !extendedDynamicStateCore &&
+            this->apiVersion >= VK_API_VERSION_1_1 && this->DeviceHasExtension(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
+        if (extendedDynamicStateQueried)
+            chain(extendedDynamicStateFeatures);
+
+        // Culling runs on the graphics queue, so its family has to do compute as well
+        //  Draw counts let the culled draws be compacted; core 1.2 has a feature bit for them, VK_KHR_draw_indirect_count before has none
+        UInt queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(this->physicalDevice, &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(this->physicalDevice, &queueFamilyCount, queueFamilies.data());
+        this->gpuCulling = this->gpuCullingRequested && this->indirectDraws &&
+            (queueFamilies[this->queueIndices.indices[QueueFamilyIndices::GRAPHICS].value()].queueFlags & VK_QUEUE_COMPUTE_BIT);
+
+        VkPhysicalDeviceVulkan12Features vulkan12Features = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES
+        };
+        const Bool drawIndirectCountCore = this->apiVersion >= VK_API_VERSION_1_2;
+
+        // Bindless textures need runtime-sized sampler arrays, partially bound and updatable after binding, indexed non-uniformly
+        //  Core 1.2 has the bits in its own struct, which may not be chained next to the extension's
+        VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES
+        };
+        const Bool descriptorIndexingCore = this->apiVersion >= VK_API_VERSION_1_2;
+        const Bool descriptorIndexingQueried = this->bindlessRequested &&
+            (descriptorIndexingCore || (this->apiVersion >= VK_API_VERSION_1_1 && this->DeviceHasExtension(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)));
+        if (descriptorIndexingQueried && !descriptorIndexingCore)
+            chain(descriptorIndexingFeatures);
+        if ((this->gpuCulling || descriptorIndexingQueried) && drawIndirectCountCore)
+            chain(vulkan12Features);
+
+        if (featureChain != nullptr)
+        {
+            VkPhysicalDeviceFeatures2 supportedFeatures2 = {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+                .pNext = featureChain
+            };
+            vkGetPhysicalDeviceFeatures2(this->physicalDevice, &supportedFeatures2);
+        }
+        this->dynamicRendering = dynamicRenderingQueried && dynamicRenderingFeatures.dynamicRendering;
+        this->extendedDynamicState = this->extendedDynamicStateRequested &&
+            (extendedDynamicStateCore || (extendedDynamicStateQueried && extendedDynamicStateFeatures.extendedDynamicState));
+        const auto supportsBindless = [](const auto& features) {
+            return features.runtimeDescriptorArray && features.descriptorBindingPartiallyBound && features.descriptorBindingSampledImageUpdateAfterBind &&
+                features.shaderSampledImageArrayNonUniformIndexing;
+        };
+        this->bindless = descriptorIndexingQueried &&
+            (descriptorIndexingCore ? supportsBindless(vulkan12Features) : supportsBindless(descriptorIndexingFeatures));
+
+        // The draws of one indirect call may each read a different texture index, which only bindless.frag samples with (nonuniformEXT)
+        //  The fixed array of shader.frag is indexed uniformly, so there every command is its own call
+        this->multiDraw = this->indirectDraws && deviceFeatures.multiDrawIndirect && this->bindless;
+        this->drawIndirectCount = this->gpuCulling && this->multiDraw &&
+            (drawIndirectCountCore ? vulkan12Features.drawIndirectCount == VK_TRUE : this->DeviceHasExtension(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME));
+
+        // Rechained with the supported ones only, to enable them
+        featureChain = nullptr;
+        if (this->dynamicRendering)
+            chain(dynamicRenderingFeatures);
+        if (this->dynamicRendering && !dynamicRenderingCore)
+            this->enabledDeviceExtensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+        if (this->dynamicRenderingRequested && !this->dynamicRendering)
+            ATR_PRINT("[WARNING] Dynamic rendering is not supported by this device, falling back to render passes");
+        if (this->extendedDynamicState && !extendedDynamicStateCore)
+        {
+            chain(extendedDynamicStateFeatures);
+            this->enabledDeviceExtensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
+        }
+        if (this->extendedDynamicStateRequested && !this->extendedDynamicState)
+            ATR_PRINT("[WARNING] Extended dynamic state is not supported by this device, baking all state into pipelines");
+
+        // The 1.2 struct was filled with every supported feature; only what is used gets enabled
+        vulkan12Features = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+            .drawIndirectCount = this->drawIndirectCount
+        };
+        descriptorIndexingFeatures = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES
+        };
+        const auto enableBindless = [](auto& features) {
+            features.runtimeDescriptorArray = VK_TRUE;
+            features.descriptorBindingPartiallyBound = VK_TRUE;
+            features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+            features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+        };
+        if (this->bindless && descriptorIndexingCore)
+            enableBindless(vulkan12Features);
+        if ((this->drawIndirectCount || this->bindless) && drawIndirectCountCore)
+            chain(vulkan12Features);
+        if (this->drawIndirectCount && !drawIndirectCountCore)
+            this->enabledDeviceExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+        if (this->bindless && !descriptorIndexingCore)
+        {
+            enableBindless(descriptorIndexingFeatures);
+            chain(descriptorIndexingFeatures);
+            this->enabledDeviceExtensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+        }
+        if (this->bindlessRequested && !this->bindless)
+            ATR_PRINT("[WARNING] Descriptor indexing is not supported by this device, textures stay in a fixed array of " << VkResourceManager::maxTextures);
+
+        // The update-after-bind limits apply to the whole array; every frame's set counts against the one over all pools
+        //  Textures loaded before this point were limited to the fixed array's slots
+        if (this->bindless)
+        {
+            VkPhysicalDeviceDescriptorIndexingProperties indexingProperties = {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES
+            };
+            VkPhysicalDeviceProperties2 properties = {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+                .pNext = &indexingProperties
+            };
+            vkGetPhysicalDeviceProperties2(this->physicalDevice, &properties);
+            this->textureCapacity = std::min({
+                VkResourceManager::maxBindlessTextures,
+                indexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers,
+                indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                indexingProperties.maxDescriptorSetUpdateAfterBindSamplers,
+                indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages,
+                indexingProperties.maxUpdateAfterBindDescriptorsInAllPools / VkResourceManager::maxFramesInFlight
+            });
+            this->textures.resize(this->textureCapacity);
+            this->textureCacheKeys.resize(this->textureCapacity);
+            this->textureResidency.resize(this->textureCapacity);
+            ATR_PRINT_VERBOSE("Bindless texture capacity: " << this->textureCapacity)
+        }
+        if (this->gpuCullingRequested && !this->gpuCulling)
+            ATR_PRINT("[WARNING] GPU culling needs indirect draws with a first instance and compute on the graphics queue, drawing everything");
+        if (this->gpuCulling && !this->drawIndirectCount)
+            ATR_PRINT("[WARNING] Indirect draw counts need device support and bindless textures, culled draws are submitted uncompacted");
+        this->cpuCulling = this->cpuCullingRequested && !this->gpuCulling;
+        if (this->cpuCullingRequested && this->gpuCulling)
+            ATR_PRINT("[INFO] GPU culling is on, CPU culling is skipped");
+        this->occlusionCulling = this->occlusionCullingRequested && this->gpuCulling;
+        this->twoPhaseOcclusion = this->occlusionCulling && this->twoPhaseOcclusionRequested;
+        if (this->occlusionCullingRequested && !this->gpuCulling)
+            ATR_PRINT("[WARNING] Occlusion culling runs in the GPU culling pass, which is off");
 
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
         std::set<UInt> uniqueQueueFamilies;
@@ -240,10 +509,11 @@ namespace ATR
             .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
             .queueCreateInfoCount = static_cast<UInt>(queueCreateInfos.size()),
             .pQueueCreateInfos = queueCreateInfos.data(),
-            .enabledExtensionCount = (UInt)(this->deviceExtensions.size()),
-            .ppEnabledExtensionNames = this->deviceExtensions.data(),
+            .enabledExtensionCount = (UInt)(this->enabledDeviceExtensions.size()),
+            .ppEnabledExtensionNames = this->enabledDeviceExtensions.data(),
             .pEnabledFeatures = &deviceFeatures
         };
+        deviceCreateInfo.pNext = featureChain;
 
         // NOTE from Vulkan 1.3.290 this is not necessary as device will automatically have the same validation layers as the instance
         if (this->enabledValidation)
@@ -260,6 +530,35 @@ namespace ATR
 
         for (size_t index = 0; index != QueueFamilyIndices::COUNT; ++index)
             vkGetDeviceQueue(this->device, this->queueIndices.indices[index].value(), 0, &this->queues[index]);
+
+        // Commands of optional features, under their core names or with the extension's suffix
+        const auto loadCommand = [this](const String& name) {
+            const PFN_vkVoidFunction command = vkGetDeviceProcAddr(this->device, name.c_str());
+            if (command == nullptr)
+                throw Exception("Failed to load device command " + name, ExceptionType::INIT_VULKAN);
+            return command;
+        };
+        if (this->dynamicRendering)
+        {
+            const String suffix = dynamicRenderingCore ? "" : "KHR";
+            this->cmdBeginRendering = reinterpret_cast<PFN_vkCmdBeginRendering>(loadCommand("vkCmdBeginRendering" + suffix));
+            this->cmdEndRendering = reinterpret_cast<PFN_vkCmdEndRendering>(loadCommand("vkCmdEndRendering" + suffix));
+        }
+        if (this->extendedDynamicState)
+        {
+            const String suffix = extendedDynamicStateCore ? "" : "EXT";
+            this->cmdSetPrimitiveTopology = reinterpret_cast<PFN_vkCmdSetPrimitiveTopology>(loadCommand("vkCmdSetPrimitiveTopology" + suffix));
+            this->cmdSetCullMode = reinterpret_cast<PFN_vkCmdSetCullMode>(loadCommand("vkCmdSetCullMode" + suffix));
+            this->cmdSetFrontFace = reinterpret_cast<PFN_vkCmdSetFrontFace>(loadCommand("vkCmdSetFrontFace" + suffix));
+            this->cmdSetDepthTestEnable = reinterpret_cast<PFN_vkCmdSetDepthTestEnable>(loadCommand("vkCmdSetDepthTestEnable" + suffix));
+            this->cmdSetDepthWriteEnable = reinterpret_cast<PFN_vkCmdSetDepthWriteEnable>(loadCommand("vkCmdSetDepthWriteEnable" + suffix));
+            this->cmdSetDepthCompareOp = reinterpret_cast<PFN_vkCmdSetDepthCompareOp>(loadCommand("vkCmdSetDepthCompareOp" + suffix));
+        }
+        if (this->drawIndirectCount)
+            this->cmdDrawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCount>(loadCommand(String("vkCmdDrawIndexedIndirectCount") + (drawIndirectCountCore ? "" : "KHR")));
+
+        this->CreatePipelineCache();
+        this->deviceCreated.set_value();
     }
 
     void VkResourceManager::CreateSwapchain()
@@ -303,6 +602,8 @@ namespace ATR
             throw Exception("Failed to create swapchain", ExceptionType::INIT_VULKAN);
 
         this->RetrieveSwapChainImages();
+        this->camera.width = static_cast<Float>(this->swapChainConfig.extent.width);
+        this->camera.height = static_cast<Float>(this->swapChainConfig.extent.height);
     }
 
     void VkResourceManager::CreateImageViews()
@@ -341,17 +642,39 @@ namespace ATR
 
     void VkResourceManager::CreateRenderPass()
     {
+        this->colorFormat = this->swapChainConfig.format.format;
+
+        // The depth pyramid is built by sampling the depth buffer
+        if (this->occlusionCulling)
+        {
+            try { this->depthFormat = this->FindDepthFormat(VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT); }
+            catch (const Exception&)
+            {
+                ATR_PRINT("[WARNING] No depth format can be sampled on this device, occlusion culling is off");
+                this->occlusionCulling = this->twoPhaseOcclusion = false;
+            }
+        }
+        if (!this->occlusionCulling)
+            this->depthFormat = this->FindDepthFormat();
+
+        // Pipelines take the formats instead, and BeginMainPass transitions the images itself
+        if (this->dynamicRendering)
+        {
+            ATR_LOG("Using Dynamic Rendering, No Render Pass Needed...")
+            return;
+        }
+
         ATR_LOG("Creating Render Pass...")
 
         VkAttachmentDescription colorAttachment = {
-            .format = this->swapChainConfig.format.format,
+            .format = this->colorFormat,
             .samples = VK_SAMPLE_COUNT_1_BIT,
             .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
             .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
             .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
             .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
             .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-            .finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+            .finalLayout = this->twoPhaseOcclusion ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR   // Presented after the late draws
         };
 
         VkAttachmentReference colorAttachmentRef = {
@@ -360,10 +683,10 @@ namespace ATR
         };
 
         VkAttachmentDescription depthAttachment = {
-            .format = this->FindDepthFormat(),
+            .format = this->depthFormat,
             .samples = VK_SAMPLE_COUNT_1_BIT,
             .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
-            .storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .storeOp = this->occlusionCulling ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE,     // The depth pyramid is built from it
             .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
             .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
             .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
@@ -405,66 +728,523 @@ namespace ATR
 
         if (vkCreateRenderPass(this->device, &renderPass, nullptr, &this->renderPass) != VK_SUCCESS)
             throw Exception("Failed to create render pass", ExceptionType::INIT_PIPELINE);
+        if (!this->twoPhaseOcclusion)
+            return;
+
+        // The late draws continue on what the early ones stored; compatible with the first pass, so its framebuffers and pipelines serve both
+        colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        attachments = { colorAttachment, depthAttachment };
+
+        // Depth comes back from the pyramid through its own barrier (see RecordDepthPyramid); color is loaded after the early writes
+        dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+        if (vkCreateRenderPass(this->device, &renderPass, nullptr, &this->resumeRenderPass) != VK_SUCCESS)
+            throw Exception("Failed to create resuming render pass", ExceptionType::INIT_PIPELINE);
     }
 
     void VkResourceManager::CreateDescriptorSetLayout()
     {
         ATR_LOG("Creating Descriptor Set Layout...")
-        VkDescriptorSetLayoutBinding uboLayoutBinding = {
-            .binding = 0,
-            .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-            .descriptorCount = 1,
-            .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
-            .pImmutableSamplers = nullptr
+
+        // The interface is whatever the embedded shaders declare: the UBO at binding 0 and the texture array at binding 1, indexed per draw through push constants
+        //  Registering them as the first program fixes the set layout every later program has to match
+        //  Bindless, the fragment shader declares the texture array runtime sized instead
+        const std::filesystem::path sources = this->shaderDirectory;
+        const std::vector<UInt> fragmentCode = this->bindless ?
+            std::vector<UInt>(std::begin(EmbeddedShaders::bindlessFragment), std::end(EmbeddedShaders::bindlessFragment)) :
+            std::vector<UInt>(std::begin(EmbeddedShaders::fragment), std::end(EmbeddedShaders::fragment));
+        this->RegisterShaderProgram(
+            std::vector<UInt>(std::begin(EmbeddedShaders::vertex), std::end(EmbeddedShaders::vertex)),
+            fragmentCode,
+            this->shaderDirectory.empty() ? "" : (sources / "shader.vert").generic_string(),
+            this->shaderDirectory.empty() ? "" : (sources / (this->bindless ? "bindless.frag" : "shader.frag")).generic_string()
+        );
+    }
+
+    UInt VkResourceManager::RegisterShaderProgram(std::vector<UInt> vertexCode, std::vector<UInt> fragmentCode, String vertexSource, String fragmentSource, std::vector<String> defines)
+    {
+        // Layouts are created on the device, and the embedded program has to be registered first
+        if (this->device == VK_NULL_HANDLE)
+            throw Exception("Shader programs can only be registered once the renderer is initialized", ExceptionType::INIT_SHADER);
+
+        ShaderProgram program = this->MakeShaderProgram(std::move(vertexCode), std::move(fragmentCode), std::move(vertexSource), std::move(fragmentSource), std::move(defines));
+        for (UInt i = 0; i != this->shaderPrograms.size(); ++i)
+            if (this->shaderPrograms[i]->hash == program.hash)
+                return i;
+
+        if (this->shaderPrograms.empty())
+            this->descriptorSetLayout = this->GetDescriptorSetLayout(program.layout, 0);
+        this->shaderPrograms.push_back(std::make_shared<const ShaderProgram>(std::move(program)));
+        return static_cast<UInt>(this->shaderPrograms.size() - 1);
+    }
+
+    UInt VkResourceManager::LoadShaderProgram(const String& vertexPath, const String& fragmentPath, const std::vector<String>& defines)
+    {
+        if (this->device == VK_NULL_HANDLE)
+            throw Exception("Shader programs can only be registered once the renderer is initialized", ExceptionType::INIT_SHADER);
+
+        // Until its stages compiled, the program is the embedded one under a hash of its sources, so that its pipelines are keyed apart
+        //  Compiling replaces that hash with the SPIR-V one, so loading the same sources again is matched by the key kept aside
+        LUInt hash = HashString(fragmentPath, HashString(vertexPath, HashValue(vertexPath.size())));
+        for (const String& define : defines)
+            hash = HashString(define, HashValue(define.size(), hash));
+        if (auto loaded = this->shaderSourcePrograms.find(hash); loaded != this->shaderSourcePrograms.end())
+            return loaded->second;
+
+        ShaderProgram placeholder = *this->shaderPrograms[this->pipelines[VkResourceManager::defaultPipelineId].state.program];
+        placeholder.hash = hash;
+        placeholder.vertexSource = vertexPath;
+        placeholder.fragmentSource = fragmentPath;
+        placeholder.defines = defines;
+        this->shaderPrograms.push_back(std::make_shared<const ShaderProgram>(std::move(placeholder)));
+        const UInt id = static_cast<UInt>(this->shaderPrograms.size() - 1);
+        this->shaderSourcePrograms[hash] = id;
+
+        // Both stages compile side by side on the pipeline threads; cached SPIR-V makes repeated loads a file read
+        this->shaderLoads.push_back({
+            .program = id,
+            .vertexCode = this->pipelineThreads.Submit([this, vertexPath, defines]() { return this->shaderCompiler.Compile(vertexPath, defines); }),
+            .fragmentCode = this->pipelineThreads.Submit([this, fragmentPath, defines]() { return this->shaderCompiler.Compile(fragmentPath, defines); })
+        });
+        return id;
+    }
+
+    void VkResourceManager::CollectLoadedShaders()
+    {
+        // A failed compilation or an incompatible interface leaves the embedded program drawing in its place
+        for (auto load = this->shaderLoads.begin(); load != this->shaderLoads.end(); )
+        {
+            if (load->vertexCode.wait_for(std::chrono::seconds(0)) != std::future_status::ready ||
+                load->fragmentCode.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            {
+                ++load;
+                continue;
+            }
+
+            try
+            {
+                const ShaderProgram& current = *this->shaderPrograms[load->program];
+                std::vector<UInt> vertexCode = load->vertexCode.get();
+                this->ReplaceShaderProgram(load->program, this->MakeShaderProgram(
+                    std::move(vertexCode), load->fragmentCode.get(), current.vertexSource, current.fragmentSource, current.defines
+                ));
+            }
+            catch (const Exception& e)
+            {
+                ATR_ERROR(e.What())
+            }
+            load = this->shaderLoads.erase(load);
+        }
+    }
+
+    ShaderProgram VkResourceManager::MakeShaderProgram(std::vector<UInt> vertexCode, std::vector<UInt> fragmentCode, String vertexSource, String fragmentSource, std::vector<String> defines)
+    {
+        LUInt hash = HashBytes(vertexCode.data(), sizeof(UInt) * vertexCode.size(), HashValue(vertexCode.size()));
+        hash = HashBytes(fragmentCode.data(), sizeof(UInt) * fragmentCode.size(), hash);
+
+        ShaderLayout layout = ShaderReflection::Reflect(vertexCode.data(), sizeof(UInt) * vertexCode.size());
+        layout.Merge(ShaderReflection::Reflect(fragmentCode.data(), sizeof(UInt) * fragmentCode.size()));
+        if (layout.SetCount() > 1)
+            throw Exception("Shaders may only use descriptor set 0", ExceptionType::INIT_SHADER);
+
+        // Every program draws with the same per-frame descriptor sets; deduplicated layouts make this a handle comparison
+        //  The first program registered (the embedded one) defines that set
+        if (!this->shaderPrograms.empty() && this->GetDescriptorSetLayout(layout, 0) != this->descriptorSetLayout)
+            throw Exception("Shader program declares a descriptor set 0 different from the embedded shaders'", ExceptionType::INIT_SHADER);
+
+        return {
+            .vertexCode = std::move(vertexCode),
+            .fragmentCode = std::move(fragmentCode),
+            .layout = std::move(layout),
+            .hash = hash,
+            .vertexSource = std::move(vertexSource),
+            .fragmentSource = std::move(fragmentSource),
+            .defines = std::move(defines)
         };
+    }
+
+    void VkResourceManager::ReplaceShaderProgram(UInt id, ShaderProgram program)
+    {
+        // Pipeline keys include the program's hash: the program's pipelines are re-keyed, keeping their ids
+        std::vector<UInt> affected;
+        for (auto entry = this->pipelineIds.begin(); entry != this->pipelineIds.end(); )
+            if (this->pipelines[entry->second].state.program == id)
+            {
+                affected.push_back(entry->second);
+                entry = this->pipelineIds.erase(entry);
+            }
+            else
+                ++entry;
+
+        this->shaderPrograms[id] = std::make_shared<const ShaderProgram>(std::move(program));
+        for (UInt pipeline : affected)
+        {
+            this->pipelineIds[HashPipelineState(this->pipelines[pipeline].state, this->shaderPrograms[id]->hash)] = pipeline;
+            this->SubmitPipelineBuild(pipeline);
+        }
+        ATR_LOG("Reloaded shader program " << id << ", rebuilding " << affected.size() << " pipeline(s)")
+    }
+
+    void VkResourceManager::ReloadChangedShaders()
+    {
+        // Only the edited stages recompile, each on its own job; the other stage of the program keeps its SPIR-V
+        for (const String& path : this->shaderWatcher->Poll())
+        {
+            std::error_code error;
+            const std::filesystem::path changed = std::filesystem::weakly_canonical(path, error);
+            for (UInt id = 0; id != this->shaderPrograms.size(); ++id)
+                for (auto [source, stage] : { std::pair(&this->shaderPrograms[id]->vertexSource, VK_SHADER_STAGE_VERTEX_BIT), std::pair(&this->shaderPrograms[id]->fragmentSource, VK_SHADER_STAGE_FRAGMENT_BIT) })
+                    if (!source->empty() && std::filesystem::weakly_canonical(*source, error) == changed)
+                    {
+                        ATR_LOG("Recompiling " << *source)
+                        this->shaderReloads.push_back({ .program = id, .stage = stage, .code = this->pipelineThreads.Submit([this, source = *source, defines = this->shaderPrograms[id]->defines]() { return this->shaderCompiler.Compile(source, defines); }) });
+                    }
+        }
+
+        // A failed compilation or an incompatible interface leaves the program as it was
+        for (auto reload = this->shaderReloads.begin(); reload != this->shaderReloads.end(); )
+        {
+            if (reload->code.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            {
+                ++reload;
+                continue;
+            }
+
+            try
+            {
+                const ShaderProgram& current = *this->shaderPrograms[reload->program];
+                std::vector<UInt> code = reload->code.get();
+                const Bool vertex = reload->stage == VK_SHADER_STAGE_VERTEX_BIT;
+                this->ReplaceShaderProgram(reload->program, this->MakeShaderProgram(
+                    vertex ? std::move(code) : current.vertexCode,
+                    vertex ? current.fragmentCode : std::move(code),
+                    current.vertexSource, current.fragmentSource, current.defines
+                ));
+            }
+            catch (const Exception& e)
+            {
+                ATR_ERROR(e.What())
+            }
+            reload = this->shaderReloads.erase(reload);
+        }
+    }
 
+    VkDescriptorSetLayout VkResourceManager::GetDescriptorSetLayout(const ShaderLayout& layout, UInt set)
+    {
+        // Runtime-sized arrays (only the bindless texture array) get every texture slot, partially bound and updatable after binding
+        const VkDescriptorBindingFlags runtimeArrayFlags = this->bindless ?
+            VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT : 0;
+        const std::vector<VkDescriptorSetLayoutBinding> bindings = layout.SetBindings(set, this->textureCapacity);
+        const std::vector<VkDescriptorBindingFlags> bindingFlags = layout.SetBindingFlags(set, runtimeArrayFlags);
+        const Bool updateAfterBind = std::any_of(bindingFlags.begin(), bindingFlags.end(),
+            [](VkDescriptorBindingFlags flags) { return (flags & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) != 0; });
+
+        // Bindings are hashed field by field; the structs carry padding and a sampler pointer
+        LUInt key = HashValue(bindings.size());
+        for (size_t i = 0; i != bindings.size(); ++i)
+        {
+            key = HashValue(bindings[i].binding, key);
+            key = HashValue(bindings[i].descriptorType, key);
+            key = HashValue(bindings[i].descriptorCount, key);
+            key = HashValue(bindings[i].stageFlags, key);
+            key = HashValue(bindingFlags[i], key);
+        }
+        for (auto [cached, last] = this->descriptorSetLayoutCache.equal_range(key); cached != last; ++cached)
+            if (cached->second.Matches(bindings, bindingFlags))
+                return cached->second.layout;
+
+        VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+            .bindingCount = static_cast<UInt>(bindingFlags.size()),
+            .pBindingFlags = bindingFlags.data()
+        };
         VkDescriptorSetLayoutCreateInfo layoutInfo = {
             .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-            .bindingCount = 1,
-            .pBindings = &uboLayoutBinding
+            .pNext = this->bindless ? &flagsInfo : nullptr,
+            .flags = updateAfterBind ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT : 0u,
+            .bindingCount = static_cast<UInt>(bindings.size()),
+            .pBindings = bindings.data()
         };
 
-        if (vkCreateDescriptorSetLayout(this->device, &layoutInfo, nullptr, &this->descriptorSetLayout) != VK_SUCCESS)
+        VkDescriptorSetLayout setLayout;
+        if (vkCreateDescriptorSetLayout(this->device, &layoutInfo, nullptr, &setLayout) != VK_SUCCESS)
             throw Exception("Failed to create descriptor set layout", ExceptionType::INIT_PIPELINE);
+        this->descriptorSetLayoutCache.emplace(key, CachedSetLayout{ .bindings = bindings, .bindingFlags = bindingFlags, .layout = setLayout });
+        return setLayout;
+    }
+
+    VkPipelineLayout VkResourceManager::GetPipelineLayout(const ShaderLayout& layout)
+    {
+        // Sets skipped by the shaders still need a (empty) layout, since set numbers index into the array
+        std::vector<VkDescriptorSetLayout> setLayouts;
+        for (UInt set = 0; set != layout.SetCount(); ++set)
+            setLayouts.push_back(this->GetDescriptorSetLayout(layout, set));
+
+        LUInt key = HashValue(setLayouts.size());
+        for (VkDescriptorSetLayout setLayout : setLayouts)
+            key = HashValue(setLayout, key);
+        for (const VkPushConstantRange& range : layout.pushConstants)
+            key = HashValue(range, key);
+        for (auto [cached, last] = this->pipelineLayoutCache.equal_range(key); cached != last; ++cached)
+            if (cached->second.Matches(setLayouts, layout.pushConstants))
+                return cached->second.layout;
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+            .setLayoutCount = static_cast<UInt>(setLayouts.size()),
+            .pSetLayouts = setLayouts.data(),
+            .pushConstantRangeCount = static_cast<UInt>(layout.pushConstants.size()),
+            .pPushConstantRanges = layout.pushConstants.data()
+        };
+
+        VkPipelineLayout pipelineLayout;
+        if (vkCreatePipelineLayout(this->device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+            throw Exception("Failed to create pipeline layout", ExceptionType::INIT_PIPELINE);
+        this->pipelineLayoutCache.emplace(key, CachedPipelineLayout{ .setLayouts = setLayouts, .pushConstants = layout.pushConstants, .layout = pipelineLayout });
+        return pipelineLayout;
     }
 
     void VkResourceManager::CreateGraphicsPipeline()
     {
         ATR_LOG("Creating Graphics Pipeline...")
 
-        // Compile Shaders
-        // TODO refactor and define paths in ATRConst.h
-        ATR_LOG_SUB("Compiling Shaders...")
-        this->CompileShaders();
+        // Built here on the render thread, since it is the fallback for every pipeline compiling in the background
+        this->GetPipeline(PipelineState());
+
+        ATR_LOG("Graphics Pipeline Created Successfully.")
+    }
+
+    void VkResourceManager::CreateCullPipeline()
+    {
+        if (!this->gpuCulling)
+            return;
+        ATR_LOG("Creating Culling Pipelines...")
+
+        // Reflected like the graphics programs, but with a set of its own: it binds the draw buffers for writing
+        this->cullLayout = ShaderReflection::Reflect(EmbeddedShaders::cull, sizeof(EmbeddedShaders::cull));
+        this->cullSetLayout = this->GetDescriptorSetLayout(this->cullLayout, 0);
+        this->cullPipelineLayout = this->GetPipelineLayout(this->cullLayout);
+        this->cullPipeline = this->CreateComputePipeline(EmbeddedShaders::cull, sizeof(EmbeddedShaders::cull), this->cullPipelineLayout);
+        if (!this->occlusionCulling)
+            return;
+
+        this->depthPyramidLayout = ShaderReflection::Reflect(EmbeddedShaders::depthPyramid, sizeof(EmbeddedShaders::depthPyramid));
+        this->depthPyramidSetLayout = this->GetDescriptorSetLayout(this->depthPyramidLayout, 0);
+        this->depthPyramidPipelineLayout = this->GetPipelineLayout(this->depthPyramidLayout);
+        this->depthPyramidPipeline = this->CreateComputePipeline(EmbeddedShaders::depthPyramid, sizeof(EmbeddedShaders::depthPyramid), this->depthPyramidPipelineLayout);
+    }
+
+    VkPipeline VkResourceManager::CreateComputePipeline(const UInt* code, size_t codeSize, VkPipelineLayout layout)
+    {
+        VkShaderModule module = this->CreateShaderModule(code, codeSize);
+        VkComputePipelineCreateInfo pipelineInfo = {
+            .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+            .stage = {
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+                .module = module,
+                .pName = "main"
+            },
+            .layout = layout
+        };
+
+        VkPipeline pipeline;
+        const VkResult result = vkCreateComputePipelines(this->device, this->pipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
+        vkDestroyShaderModule(this->device, module, nullptr);
+        if (result != VK_SUCCESS)
+            throw Exception("Failed to create compute pipeline", ExceptionType::INIT_PIPELINE);
+        return pipeline;
+    }
+
+    PipelineHandle VkResourceManager::GetPipeline(const PipelineState& state)
+    {
+        if (state.program >= this->shaderPrograms.size())
+            throw Exception("Pipeline refers to unregistered shader program " + std::to_string(state.program), ExceptionType::INIT_PIPELINE);
+
+        // Under extended dynamic state, states differing only in what is set per draw share one pipeline
+        const PipelineState baked = this->extendedDynamicState ? BakedState(state) : state;
+        const LUInt key = HashPipelineState(baked, this->shaderPrograms[state.program]->hash);
+        UInt id;
+        if (auto cached = this->pipelineIds.find(key); cached != this->pipelineIds.end())
+            id = cached->second;
+        else
+        {
+            // Each feature combination is its own permutation, only ever built once registered here
+            if (const UInt undeclared = state.features & ~this->shaderPrograms[state.program]->layout.FeatureMask())
+                throw Exception("Shader program " + std::to_string(state.program) + " declares no specialization constant for feature bits " + std::to_string(undeclared), ExceptionType::INIT_PIPELINE);
+
+            id = static_cast<UInt>(this->pipelines.size());
+            this->pipelines.push_back({ .state = baked });
+            this->pipelineIds[key] = id;
+            ATR_LOG_VERBOSE("Registered pipeline " << id)
+
+            // Compilation starts at registration, so that the pipeline is usually ready by the time something is drawn with it
+            this->SubmitPipelineBuild(id);
+            if (id == VkResourceManager::defaultPipelineId)
+                this->CollectPipelineBuild(id);
+        }
+
+        const PipelineVariant variant = { .pipeline = id, .dynamic = DynamicStateOf(state) };
+        const LUInt variantKey = HashPipelineVariant(variant);
+        if (auto cached = this->pipelineVariantIds.find(variantKey); cached != this->pipelineVariantIds.end())
+            return { .id = cached->second };
+
+        const UInt variantId = static_cast<UInt>(this->pipelineVariants.size());
+        this->pipelineVariants.push_back(variant);
+        this->pipelineVariantIds[variantKey] = variantId;
+        return { .id = variantId };
+    }
+
+    void VkResourceManager::SubmitPipelineBuild(UInt id)
+    {
+        // A build still in flight is collected first, so that its pipeline is retired rather than leaked
+        PipelineRecord& record = this->pipelines[id];
+        if (record.building.valid())
+            this->CollectPipelineBuild(id);
+
+        std::shared_ptr<const ShaderProgram> program = this->shaderPrograms[record.state.program];
+        const VkPipelineLayout layout = this->GetPipelineLayout(program->layout);
+        // Only the part of PushConstantObject the program declares is pushed; a larger update would overrun its ranges
+        const UInt pushConstantSize = std::min(program->layout.PushConstantSize(), static_cast<UInt>(sizeof(PushConstantObject)));
+        const VkShaderStageFlags pushConstantStages = program->layout.PushConstantStages(0, pushConstantSize);
+        record.building = this->pipelineThreads.Submit([this, state = record.state, program, layout, pushConstantStages, pushConstantSize]() {
+            return PipelineBuild{
+                .pipeline = this->BuildPipeline(state, *program, layout),
+                .layout = layout,
+                .pushConstantStages = pushConstantStages,
+                .pushConstantSize = pushConstantSize
+            };
+        });
+        if (std::find(this->buildingPipelines.begin(), this->buildingPipelines.end(), id) == this->buildingPipelines.end())
+            this->buildingPipelines.push_back(id);
+    }
+
+    void VkResourceManager::CollectPipelineBuild(UInt id)
+    {
+        // Blocks until the build finished; the pipeline it replaces may still be read by the frame in flight
+        //  Builds run on the pipeline threads without logging, so their outcome is reported here on the render thread
+        PipelineRecord& record = this->pipelines[id];
+        try
+        {
+            const PipelineBuild build = record.building.get();
+            if (record.pipeline != VK_NULL_HANDLE)
+                this->retiredResources[this->currentFrameIndex].pipelines.push_back(record.pipeline);
+            record.pipeline = build.pipeline;
+            record.layout = build.layout;
+            record.pushConstantStages = build.pushConstantStages;
+            record.pushConstantSize = build.pushConstantSize;
+            record.failed = false;
+            ATR_LOG_VERBOSE("Built pipeline " << id)
+        }
+        catch (const Exception& e)
+        {
+            if (id == VkResourceManager::defaultPipelineId && record.pipeline == VK_NULL_HANDLE)
+                throw;
+            record.failed = record.pipeline == VK_NULL_HANDLE;          // A failed rebuild keeps the previous pipeline
+            ATR_ERROR("Pipeline " + std::to_string(id) + ": " + e.What())
+        }
+        this->buildingPipelines.erase(std::remove(this->buildingPipelines.begin(), this->buildingPipelines.end(), id), this->buildingPipelines.end());
+    }
+
+    void VkResourceManager::CollectBuiltPipelines()
+    {
+        for (size_t i = this->buildingPipelines.size(); i-- != 0; )
+        {
+            const UInt id = this->buildingPipelines[i];
+            if (this->pipelines[id].building.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+                this->CollectPipelineBuild(id);
+        }
+    }
+
+    const PipelineRecord* VkResourceManager::ResolvePipeline(UInt id) const
+    {
+        const PipelineRecord& record = this->pipelines[id];
+        if (record.pipeline != VK_NULL_HANDLE)
+            return &record;
+
+        // Still compiling, or failed: the fallback draws the same vertices with the same descriptor set, in default state
+        //  It can only stand in within the pass it was built for; elsewhere the draw is skipped until CollectBuiltPipelines picks the build up
+        const PipelineRecord& fallback = this->pipelines[VkResourceManager::defaultPipelineId];
+        const Bool compatible = record.state.renderPass == fallback.state.renderPass && record.state.subpass == fallback.state.subpass;
+        return compatible ? &fallback : nullptr;
+    }
 
-        std::vector<char> vertShaderCode = ReadShaderCode("bin/shaders/vert.spv");
-        std::vector<char> fragShaderCode = ReadShaderCode("bin/shaders/frag.spv");
+    VkPipeline VkResourceManager::BuildPipeline(const PipelineState& state, const ShaderProgram& program, VkPipelineLayout layout)
+    {
+        // Runs on the pipeline threads: reads nothing the render thread may change
 
         // Shader modules can be destroyed after shader stage creation, and therefore is not a member variable of VkResourceManager
-        VkShaderModule vertShaderModule = CreateShaderModule(vertShaderCode);
-        VkShaderModule fragShaderModule = CreateShaderModule(fragShaderCode);
+        VkShaderModule vertShaderModule = CreateShaderModule(program.vertexCode.data(), sizeof(UInt) * program.vertexCode.size());
+        VkShaderModule fragShaderModule = CreateShaderModule(program.fragmentCode.data(), sizeof(UInt) * program.fragmentCode.size());
+
+        // Specialization: feature bits become the boolean constants, so the driver folds away the branches on them
+        //  Every stage maps only the constants it declares, all read from the same array of bits
+        std::array<VkBool32, 32> featureValues;
+        for (UInt bit = 0; bit != featureValues.size(); ++bit)
+            featureValues[bit] = (state.features >> bit) & 1u;
+
+        std::vector<VkSpecializationMapEntry> vertEntries, fragEntries;
+        for (const ReflectedSpecConstant& constant : program.layout.specConstants)
+            if (constant.boolean && constant.id < featureValues.size())
+            {
+                const VkSpecializationMapEntry entry = { .constantID = constant.id, .offset = static_cast<UInt>(sizeof(VkBool32) * constant.id), .size = sizeof(VkBool32) };
+                if (constant.stages & VK_SHADER_STAGE_VERTEX_BIT)
+                    vertEntries.push_back(entry);
+                if (constant.stages & VK_SHADER_STAGE_FRAGMENT_BIT)
+                    fragEntries.push_back(entry);
+            }
+
+        const VkSpecializationInfo vertSpecialization = {
+            .mapEntryCount = static_cast<UInt>(vertEntries.size()),
+            .pMapEntries = vertEntries.data(),
+            .dataSize = sizeof(featureValues),
+            .pData = featureValues.data()
+        };
+        const VkSpecializationInfo fragSpecialization = {
+            .mapEntryCount = static_cast<UInt>(fragEntries.size()),
+            .pMapEntries = fragEntries.data(),
+            .dataSize = sizeof(featureValues),
+            .pData = featureValues.data()
+        };
 
         // Shader Stage Creation
-        ATR_LOG_SUB("Creating Shader Stages...")
         VkPipelineShaderStageCreateInfo vertShaderStageInfo = {
             .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
             .stage = VK_SHADER_STAGE_VERTEX_BIT,
             .module = vertShaderModule,
-            .pName = Const::DefaultShaderEntryPoint
+            .pName = Const::DefaultShaderEntryPoint,
+            .pSpecializationInfo = vertEntries.empty() ? nullptr : &vertSpecialization
         };
         VkPipelineShaderStageCreateInfo fragShaderStageInfo = {
             .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
             .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
             .module = fragShaderModule,
-            .pName = Const::DefaultShaderEntryPoint
+            .pName = Const::DefaultShaderEntryPoint,
+            .pSpecializationInfo = fragEntries.empty() ? nullptr : &fragSpecialization
         };
         VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
 
-        // Configurable states
+        // Configurable states; under extended dynamic state the baked values of these are ignored, see BakedState
         std::vector<VkDynamicState> dynamicStates = {
             VK_DYNAMIC_STATE_VIEWPORT,
             VK_DYNAMIC_STATE_SCISSOR
         };
+        if (this->extendedDynamicState)
+            dynamicStates.insert(dynamicStates.end(), {
+                VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY,
+                VK_DYNAMIC_STATE_CULL_MODE,
+                VK_DYNAMIC_STATE_FRONT_FACE,
+                VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE,
+                VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE,
+                VK_DYNAMIC_STATE_DEPTH_COMPARE_OP
+            });
 
         VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo = {
             .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
@@ -472,57 +1252,62 @@ namespace ATR
             .pDynamicStates = dynamicStates.data()
         };
 
-        // Vertex Layout: TODO move the hardcoded values in the shader to the configurable ones here
-        ATR_LOG_SUB("Configuring Input Layouts...")
+        // Vertex Layout: the vertex shader's inputs, interleaved in location order, must describe `Vertex` exactly
+        //  Inputs from `instanceInputLocation` on come from binding 1 per instance, and must describe `InstanceData`; shaders may leave them out
+        UInt vertexStride, instanceStride;
+        std::vector<VkVertexInputAttributeDescription> vertexAttributes = program.layout.VertexAttributes(0, 0, VkResourceManager::instanceInputLocation, vertexStride);
+        const std::vector<VkVertexInputAttributeDescription> instanceAttributes = program.layout.VertexAttributes(1, VkResourceManager::instanceInputLocation, UINT32_MAX, instanceStride);
+        if (vertexStride != sizeof(Vertex))
+            throw Exception("Vertex shader inputs span " + std::to_string(vertexStride) + " bytes, Vertex has " + std::to_string(sizeof(Vertex)), ExceptionType::INIT_PIPELINE);
+        if (instanceStride != 0 && instanceStride != sizeof(InstanceData))
+            throw Exception("Vertex shader instance inputs span " + std::to_string(instanceStride) + " bytes, InstanceData has " + std::to_string(sizeof(InstanceData)), ExceptionType::INIT_PIPELINE);
+        vertexAttributes.insert(vertexAttributes.end(), instanceAttributes.begin(), instanceAttributes.end());
+
+        const std::array<VkVertexInputBindingDescription, 2> vertexBindings = { {
+            {
+                .binding = 0,
+                .stride = vertexStride,
+                .inputRate = VK_VERTEX_INPUT_RATE_VERTEX
+            },
+            {
+                .binding = 1,
+                .stride = instanceStride,
+                .inputRate = VK_VERTEX_INPUT_RATE_INSTANCE
+            }
+        } };
+
         VkPipelineVertexInputStateCreateInfo vertexInputInfo = {
             .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-            .vertexBindingDescriptionCount = 1,
-            .pVertexBindingDescriptions = &Vertex::bindingDescription,
-            .vertexAttributeDescriptionCount = Vertex::attributeDescriptions.size(),
-            .pVertexAttributeDescriptions = Vertex::attributeDescriptions.data(),
+            .vertexBindingDescriptionCount = instanceAttributes.empty() ? 1u : 2u,
+            .pVertexBindingDescriptions = vertexBindings.data(),
+            .vertexAttributeDescriptionCount = static_cast<UInt>(vertexAttributes.size()),
+            .pVertexAttributeDescriptions = vertexAttributes.data(),
         };
 
         // Input Assembly
         VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo = {
             .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
-            .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+            .topology = state.raster.topology,
             .primitiveRestartEnable = VK_FALSE
         };
 
-        // Viewport and Scissor (Viewport States)
-        ATR_LOG_SUB("Configuring Viewport...")
-        VkViewport viewport = {
-            .x = 0.0f,
-            .y = 0.0f,
-            .width = (Float)this->swapChainConfig.extent.width,
-            .height = (Float)this->swapChainConfig.extent.height,
-            .minDepth = 0.0f,           // Notice Vulkan uses depth from 0 to 1
-            .maxDepth = 1.0f
-        };
-
-        VkRect2D scissor = {
-            .offset = { 0, 0 },
-            .extent = this->swapChainConfig.extent
-        };
-
-        // TODO see how this coops with dynamic configuration
+        // Viewport and Scissor (Viewport States): both dynamic, set while recording, so only their count is baked
         VkPipelineViewportStateCreateInfo viewportStateInfo = {
             .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
             .viewportCount = 1,
-            .pViewports = &viewport,
+            .pViewports = nullptr,
             .scissorCount = 1,
-            .pScissors = &scissor
+            .pScissors = nullptr
         };
 
         // Rasterizer
-        ATR_LOG_SUB("Configuring Rasterizer...")
         VkPipelineRasterizationStateCreateInfo rasterizerInfo = {
             .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
             .depthClampEnable = VK_FALSE,
             .rasterizerDiscardEnable = VK_FALSE,
-            .polygonMode = VK_POLYGON_MODE_FILL,
-            .cullMode = VK_CULL_MODE_BACK_BIT,
-            .frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,            
+            .polygonMode = state.raster.polygonMode,
+            .cullMode = state.raster.cullMode,
+            .frontFace = state.raster.frontFace,
             .depthBiasEnable = VK_FALSE,
             .lineWidth = 1.0f
         };
@@ -540,9 +1325,9 @@ namespace ATR
 
         VkPipelineDepthStencilStateCreateInfo depthStencilInfo = {
             .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
-            .depthTestEnable = VK_TRUE,
-            .depthWriteEnable = VK_TRUE,
-            .depthCompareOp = VK_COMPARE_OP_LESS,
+            .depthTestEnable = state.depth.test,
+            .depthWriteEnable = state.depth.write,
+            .depthCompareOp = state.depth.compareOp,
             .depthBoundsTestEnable = VK_FALSE,
             .stencilTestEnable = VK_FALSE,
             .front = {},
@@ -553,14 +1338,13 @@ namespace ATR
 
         // Color Blending per buffer
         VkPipelineColorBlendAttachmentState colorBlendAttachment = {
-            // Enable Alpha Blending
-            .blendEnable = VK_TRUE,
-            .srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
-            .dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
-            .colorBlendOp = VK_BLEND_OP_ADD,
-            .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
-            .dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
-            .alphaBlendOp = VK_BLEND_OP_ADD,
+            .blendEnable = state.blend.enable,
+            .srcColorBlendFactor = state.blend.srcColor,
+            .dstColorBlendFactor = state.blend.dstColor,
+            .colorBlendOp = state.blend.colorOp,
+            .srcAlphaBlendFactor = state.blend.srcAlpha,
+            .dstAlphaBlendFactor = state.blend.dstAlpha,
+            .alphaBlendOp = state.blend.alphaOp,
             .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT
         };
 
@@ -574,21 +1358,21 @@ namespace ATR
             .blendConstants = { 0.0f, 0.0f, 0.0f, 0.0f }
         };
 
-        // Pipeline Layout for Uniforms
-        VkPipelineLayoutCreateInfo pipelineLayoutInfo = {
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-            .setLayoutCount = 1,
-            .pSetLayouts = &this->descriptorSetLayout,
-            .pushConstantRangeCount = 0,
-            .pPushConstantRanges = nullptr
+        // Attachment formats of the main pass, standing in for its render pass under dynamic rendering
+        //  Pipelines naming a render pass of their own still use it
+        const Bool mainPass = state.renderPass == VK_NULL_HANDLE;
+        const VkPipelineRenderingCreateInfo renderingInfo = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+            .colorAttachmentCount = 1,
+            .pColorAttachmentFormats = &this->colorFormat,
+            .depthAttachmentFormat = this->depthFormat,
+            .stencilAttachmentFormat = VK_FORMAT_UNDEFINED
         };
 
-        if (vkCreatePipelineLayout(this->device, &pipelineLayoutInfo, nullptr, &this->pipelineLayout) != VK_SUCCESS)
-            throw Exception("Failed to create pipeline layout", ExceptionType::INIT_PIPELINE);
-
         // Creating the Graphics Pipeline
         VkGraphicsPipelineCreateInfo createInfo = {
             .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+            .pNext = this->dynamicRendering && mainPass ? &renderingInfo : nullptr,
             .stageCount = 2,
             .pStages = shaderStages,
             .pVertexInputState = &vertexInputInfo,
@@ -599,25 +1383,30 @@ namespace ATR
             .pDepthStencilState = &depthStencilInfo,
             .pColorBlendState = &colorBlendingInfo,
             .pDynamicState = &dynamicStateCreateInfo,
-            .layout = this->pipelineLayout,
-            .renderPass = this->renderPass, 
-            .subpass = 0,
+            .layout = layout,
+            .renderPass = mainPass ? this->renderPass : state.renderPass,
+            .subpass = state.subpass,
             .basePipelineHandle = VK_NULL_HANDLE,
             .basePipelineIndex = -1
         };
 
-        if (vkCreateGraphicsPipelines(this->device, VK_NULL_HANDLE, 1, &createInfo, nullptr, &this->graphicsPipeline) != VK_SUCCESS)
-            throw Exception("Failed to create graphics pipeline", ExceptionType::INIT_PIPELINE);
-
-        ATR_LOG("Graphics Pipeline Created Successfully.")
+        VkPipeline pipeline;
+        const VkResult result = vkCreateGraphicsPipelines(this->device, this->pipelineCache, 1, &createInfo, nullptr, &pipeline);
 
         // Cleanup Loaded ShaderCode
         vkDestroyShaderModule(this->device, vertShaderModule, nullptr);
         vkDestroyShaderModule(this->device, fragShaderModule, nullptr);
+
+        if (result != VK_SUCCESS)
+            throw Exception("Failed to create graphics pipeline", ExceptionType::INIT_PIPELINE);
+        return pipeline;
     }
 
     void VkResourceManager::CreateFrameBuffers()
     {
+        if (this->dynamicRendering)
+            return;                             // Attachments are named per frame in BeginMainPass
+
         ATR_LOG("Creating Framebuffers...")
 
         this->swapchainFrameBuffers.resize(this->swapchainImageViews.size());
@@ -665,86 +1454,251 @@ namespace ATR
             if (vkCreateCommandPool(this->device, &transferCommandPoolInfo, nullptr, &this->transferCommandPool) != VK_SUCCESS)
                 throw Exception("Failed to create transfer command pool", ExceptionType::INIT_PIPELINE);
         }
+
+        // One pool per range of draws and frame in flight, for as many ranges as there are recording threads and the render thread
+        if (!this->parallelRecording)
+            return;
+        this->recordThreads = std::make_unique<ThreadPool>();
+        const VkCommandPoolCreateInfo recordCommandPoolInfo = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+            .queueFamilyIndex = this->queueIndices.indices[QueueFamilyIndices::GRAPHICS].value()
+        };
+        for (auto& pools : this->recordCommandPools)
+        {
+            pools.resize(this->recordThreads->ThreadCount() + 1);
+            for (VkCommandPool& pool : pools)
+                if (vkCreateCommandPool(this->device, &recordCommandPoolInfo, nullptr, &pool) != VK_SUCCESS)
+                    throw Exception("Failed to create recording command pool", ExceptionType::INIT_PIPELINE);
+        }
     }
 
     void VkResourceManager::CreateDepthBuffer()
     {
-        VkFormat depthFormat = this->FindDepthFormat();
         this->CreateImage(
             this->swapChainConfig.extent.width,
             this->swapChainConfig.extent.height,
-            depthFormat,
+            1,
+            this->depthFormat,
             VK_IMAGE_TILING_OPTIMAL,
-            VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+            VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | (this->occlusionCulling ? VK_IMAGE_USAGE_SAMPLED_BIT : 0),   // Read into the depth pyramid
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
             this->depthImage,
             this->depthImageMemory
         );
-        this->depthImageView = this->CreateImageView(this->depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
+        this->depthImageView = this->CreateImageView(this->depthImage, this->depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1);
     }
 
-    void VkResourceManager::CreateTextureImage()
-    {
-        // TODO
-    }
-
-    void VkResourceManager::CreateVertexBuffer()
+    void VkResourceManager::CreateDepthPyramid()
     {
-        // TODO make this more flexible
-        ATR_LOG("Creating Vertex Buffer...")
-        VkDeviceSize bufferSize = sizeof(this->mesh.GetVertices()[0]) * this->mesh.GetVertices().size();
+        if (!this->occlusionCulling)
+            return;
 
-        VkBuffer stagingBuffer;                         // Buffer on CPU, temporary, host-visible
-        VkDeviceMemory stagingBufferMemory;
+        // Power of two sizes halve exactly from level to level; level 0 is the largest within the depth buffer
+        const auto floorPowerOfTwo = [](UInt value) { UInt power = 1; while (power <= value / 2) power *= 2; return power; };
+        this->depthPyramidExtent = { floorPowerOfTwo(this->swapChainConfig.extent.width), floorPowerOfTwo(this->swapChainConfig.extent.height) };
+        UInt levels = 1;
+        while ((std::max(this->depthPyramidExtent.width, this->depthPyramidExtent.height) >> levels) != 0)
+            ++levels;
 
-        this->CreateStagingBuffer(bufferSize, stagingBuffer, stagingBufferMemory);
+        this->CreateImage(
+            this->depthPyramidExtent.width,
+            this->depthPyramidExtent.height,
+            levels,
+            VK_FORMAT_R32_SFLOAT,
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            this->depthPyramid,
+            this->depthPyramidMemory
+        );
+        this->depthPyramidView = this->CreateImageView(this->depthPyramid, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, levels);
+        this->depthPyramidLevelViews.resize(levels);
+        for (UInt level = 0; level != levels; ++level)
+        {
+            VkImageViewCreateInfo viewInfo = {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+                .image = this->depthPyramid,
+                .viewType = VK_IMAGE_VIEW_TYPE_2D,
+                .format = VK_FORMAT_R32_SFLOAT,
+                .subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1 }
+            };
+            if (vkCreateImageView(this->device, &viewInfo, nullptr, &this->depthPyramidLevelViews[level]) != VK_SUCCESS)
+                throw Exception("Failed to create depth pyramid level view", ExceptionType::INIT_BUFFER);
+        }
 
-        void* data;
-        vkMapMemory(this->device, stagingBufferMemory, 0, bufferSize, 0, &data);
-            memcpy(data, this->mesh.GetVertices().data(), static_cast<size_t>(bufferSize));
-        vkUnmapMemory(this->device, stagingBufferMemory);
+        // One set per level, sized from the reflected layout like the main descriptor pool
+        std::vector<VkDescriptorPoolSize> poolSizes;
+        for (const VkDescriptorSetLayoutBinding& binding : this->depthPyramidLayout.SetBindings(0, 1))
+            poolSizes.push_back({ .type = binding.descriptorType, .descriptorCount = binding.descriptorCount * levels });
+        VkDescriptorPoolCreateInfo poolInfo = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+            .maxSets = levels,
+            .poolSizeCount = static_cast<UInt>(poolSizes.size()),
+            .pPoolSizes = poolSizes.data()
+        };
+        if (vkCreateDescriptorPool(this->device, &poolInfo, nullptr, &this->depthPyramidDescriptorPool) != VK_SUCCESS)
+            throw Exception("Failed to create depth pyramid descriptor pool", ExceptionType::INIT_BUFFER);
 
-        this->CreateBuffer(
-            bufferSize,
-            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,       // Will receive transfer from the host, and used as vertex buffer
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,                                        // Most suitable (performative) for device local access
-            this->vertexBuffer,
-            this->vertexBufferMemory
-        );
+        std::vector<VkDescriptorSetLayout> layouts(levels, this->depthPyramidSetLayout);
+        VkDescriptorSetAllocateInfo allocInfo = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            .descriptorPool = this->depthPyramidDescriptorPool,
+            .descriptorSetCount = levels,
+            .pSetLayouts = layouts.data()
+        };
+        this->depthPyramidDescriptorSets.resize(levels);
+        if (vkAllocateDescriptorSets(this->device, &allocInfo, this->depthPyramidDescriptorSets.data()) != VK_SUCCESS)
+            throw Exception("Failed to allocate depth pyramid descriptor sets", ExceptionType::INIT_BUFFER);
 
-        this->CopyBuffer(stagingBuffer, this->vertexBuffer, bufferSize);
+        for (UInt level = 0; level != levels; ++level)
+        {
+            const VkDescriptorImageInfo source = {
+                .sampler = this->depthPyramidSampler,
+                .imageView = level == 0 ? this->depthImageView : this->depthPyramidLevelViews[level - 1],
+                .imageLayout = level == 0 ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL
+            };
+            const VkDescriptorImageInfo target = {
+                .imageView = this->depthPyramidLevelViews[level],
+                .imageLayout = VK_IMAGE_LAYOUT_GENERAL
+            };
+            const std::array<VkWriteDescriptorSet, 2> descriptorWrites = { {
+                {
+                    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                    .dstSet = this->depthPyramidDescriptorSets[level],
+                    .dstBinding = 0,
+                    .descriptorCount = 1,
+                    .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                    .pImageInfo = &source
+                },
+                {
+                    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                    .dstSet = this->depthPyramidDescriptorSets[level],
+                    .dstBinding = 1,
+                    .descriptorCount = 1,
+                    .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                    .pImageInfo = &target
+                }
+            } };
+            vkUpdateDescriptorSets(this->device, static_cast<UInt>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+        }
 
-        vkDestroyBuffer(this->device, stagingBuffer, nullptr);
-        vkFreeMemory(this->device, stagingBufferMemory, nullptr);
+        // Cleared to the far plane, so that nothing counts as hidden until a frame has been drawn into it
+        VkCommandBuffer commandBuffer = this->BeginSingleTimeCommands(this->graphicsCommandPool);
+        VkImageMemoryBarrier barrier = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .srcAccessMask = 0,
+            .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = this->depthPyramid,
+            .subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, levels, 0, 1 }
+        };
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        const VkClearColorValue farPlane = { { 1.f, 0.f, 0.f, 0.f } };
+        vkCmdClearColorImage(commandBuffer, this->depthPyramid, VK_IMAGE_LAYOUT_GENERAL, &farPlane, 1, &barrier.subresourceRange);
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        this->SubmitSingleTimeCommands(commandBuffer, this->graphicsCommandPool, this->queues[QueueFamilyIndices::GRAPHICS], {});
+
+        // Recreated with the swapchain, after the culling sets were first written
+        for (UInt i = 0; i != this->cullDescriptorSets.size(); ++i)
+            this->UpdateCullDescriptors(i);
     }
 
-    void VkResourceManager::CreateIndexBuffer()
+    void VkResourceManager::CreateTextureImage()
     {
-        ATR_LOG("Creating Index Buffer...")
-        VkDeviceSize bufferSize = sizeof(this->mesh.GetIndices()[0]) * this->mesh.GetIndices().size();
+        ATR_LOG("Creating Texture Images...")
 
-        VkBuffer stagingBuffer;
-        VkDeviceMemory stagingBufferMemory;
+        // The default texture occupies slot 0 and backs every slot that has not finished loading
+        ImageData white;
+        white.width = 1;
+        white.height = 1;
+        white.pixels = { 255, 255, 255, 255 };
+        white.levels.push_back({ .width = 1, .height = 1, .offset = 0, .size = white.pixels.size() });
 
-        this->CreateStagingBuffer(bufferSize, stagingBuffer, stagingBufferMemory);
+        this->UploadTextures({ { .slot = VkResourceManager::defaultTextureIndex, .image = &white } });
 
-        void* data;
-        vkMapMemory(this->device, stagingBufferMemory, 0, bufferSize, 0, &data);
-            memcpy(data, this->mesh.GetIndices().data(), static_cast<size_t>(bufferSize));
-        vkUnmapMemory(this->device, stagingBufferMemory);
+        // Textures requested before initialization have been decoding in the meantime
+        this->UploadPendingTextures();
+    }
 
-        this->CreateBuffer(
-            bufferSize,
-            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+    void VkResourceManager::CreateTextureSampler()
+    {
+        ATR_LOG("Creating Texture Sampler...")
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(this->physicalDevice, &properties);
+
+        // One sampler is shared by all textures, as they only differ in the image bound
+        VkSamplerCreateInfo samplerInfo = {
+            .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+            .magFilter = VK_FILTER_LINEAR,
+            .minFilter = VK_FILTER_LINEAR,
+            .mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
+            .addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+            .addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+            .addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+            .mipLodBias = 0.0f,
+            .anisotropyEnable = this->enabledFeatures.samplerAnisotropy,
+            .maxAnisotropy = this->enabledFeatures.samplerAnisotropy ? properties.limits.maxSamplerAnisotropy : 1.0f,
+            .compareEnable = VK_FALSE,
+            .compareOp = VK_COMPARE_OP_ALWAYS,
+            .minLod = 0.0f,
+            .maxLod = VK_LOD_CLAMP_NONE,
+            .borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
+            .unnormalizedCoordinates = VK_FALSE
+        };
+
+        if (vkCreateSampler(this->device, &samplerInfo, nullptr, &this->textureSampler) != VK_SUCCESS)
+            throw Exception("Failed to create texture sampler", ExceptionType::INIT_BUFFER);
+        if (!this->occlusionCulling)
+            return;
+
+        // The depth pyramid is only ever fetched from, texel by texel
+        samplerInfo.magFilter = VK_FILTER_NEAREST;
+        samplerInfo.minFilter = VK_FILTER_NEAREST;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.anisotropyEnable = VK_FALSE;
+        samplerInfo.maxAnisotropy = 1.0f;
+        if (vkCreateSampler(this->device, &samplerInfo, nullptr, &this->depthPyramidSampler) != VK_SUCCESS)
+            throw Exception("Failed to create depth pyramid sampler", ExceptionType::INIT_BUFFER);
+    }
+
+    void VkResourceManager::CreateVertexBuffer()
+    {
+        ATR_LOG("Creating Vertex Buffer...")
+
+        // Mesh contents arrive later through PublishLoadedMeshes; the buffer is sized for many meshes and grows on demand
+        this->CreateBuffer(
+            sizeof(Vertex) * VkResourceManager::initialVertexCapacity,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,   // Source of the copy when growing
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,                                        // Most suitable (performative) for device local access
+            this->vertexBuffer,
+            this->vertexBufferMemory
+        );
+        this->vertexAllocator = RangeAllocator(VkResourceManager::initialVertexCapacity);
+    }
+
+    void VkResourceManager::CreateIndexBuffer()
+    {
+        ATR_LOG("Creating Index Buffer...")
+
+        this->CreateBuffer(
+            sizeof(UInt) * VkResourceManager::initialIndexCapacity,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
             this->indexBuffer,
             this->indexBufferMemory
         );
-
-        this->CopyBuffer(stagingBuffer, this->indexBuffer, bufferSize);
-
-        vkDestroyBuffer(this->device, stagingBuffer, nullptr);
-        vkFreeMemory(this->device, stagingBufferMemory, nullptr);
+        this->indexAllocator = RangeAllocator(VkResourceManager::initialIndexCapacity);
     }
 
     void VkResourceManager::CreateUniformBuffer()
@@ -774,19 +1728,55 @@ namespace ATR
         }
     }
 
+    void VkResourceManager::CreateDrawBuffers()
+    {
+        ATR_LOG("Creating Instance and Draw Buffers...")
+
+        // Host-visible like the uniform buffers, written at frame boundaries; every one exists from the start, so descriptors never point at nothing
+        for (UInt i = 0; i != VkResourceManager::maxFramesInFlight; ++i)
+        {
+            this->ReserveMappedBuffer(this->instanceBuffers[i], VkResourceManager::initialInstanceCapacity, sizeof(InstanceData), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, i);
+            this->ReserveMappedBuffer(this->drawDataBuffers[i], VkResourceManager::initialDrawCapacity, sizeof(DrawData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, i);
+            this->ReserveMappedBuffer(this->drawCommandBuffers[i], VkResourceManager::initialDrawCapacity, sizeof(DrawCommand), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, i);
+            this->ReserveMappedBuffer(this->materialBuffers[i], VkResourceManager::initialDrawCapacity, sizeof(MaterialData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, i);
+            if (!this->gpuCulling)
+                continue;
+
+            // Their counterparts written by the culling pass; counters need room for a group per command on top
+            this->ReserveDeviceBuffer(this->culledInstanceBuffers[i], VkResourceManager::initialInstanceCapacity, sizeof(InstanceData), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, i);
+            this->ReserveDeviceBuffer(this->culledCommandBuffers[i], VkResourceManager::initialDrawCapacity, sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, i);
+            this->ReserveDeviceBuffer(this->cullCounterBuffers[i], 2 * VkResourceManager::initialDrawCapacity, sizeof(UInt), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, i);
+            this->ReserveDeviceBuffer(this->occludedInstanceBuffers[i], VkResourceManager::initialInstanceCapacity, sizeof(UInt), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, i);
+        }
+        this->instancesStale.fill(true);
+        this->materialsStale.fill(true);
+    }
+
     void VkResourceManager::CreateDescriptorPool()
     {
         ATR_LOG("Creating Descriptor Pool...")
-        VkDescriptorPoolSize poolSize = {
-            .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-            .descriptorCount = static_cast<UInt>(VkResourceManager::maxFramesInFlight)
-        };
+        // Sized for one set of the reflected layout per frame in flight, and as many of the culling pass's
+        std::vector<const ShaderLayout*> layouts = { &this->shaderPrograms[0]->layout };
+        if (this->gpuCulling)
+            layouts.push_back(&this->cullLayout);
+
+        std::vector<VkDescriptorPoolSize> poolSizes;
+        for (const ShaderLayout* layout : layouts)
+            for (const VkDescriptorSetLayoutBinding& binding : layout->SetBindings(0, this->textureCapacity))
+            {
+                auto poolSize = std::find_if(poolSizes.begin(), poolSizes.end(), [&](const VkDescriptorPoolSize& size) { return size.type == binding.descriptorType; });
+                if (poolSize == poolSizes.end())
+                    poolSize = poolSizes.insert(poolSizes.end(), { .type = binding.descriptorType, .descriptorCount = 0 });
+                poolSize->descriptorCount += binding.descriptorCount * VkResourceManager::maxFramesInFlight;
+            }
 
+        // Sets of the bindless layout can only come from update-after-bind pools
         VkDescriptorPoolCreateInfo poolInfo = {
             .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-            .maxSets = static_cast<UInt>(VkResourceManager::maxFramesInFlight),
-            .poolSizeCount = 1,
-            .pPoolSizes = &poolSize
+            .flags = this->bindless ? VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT : 0u,
+            .maxSets = static_cast<UInt>(layouts.size() * VkResourceManager::maxFramesInFlight),
+            .poolSizeCount = static_cast<UInt>(poolSizes.size()),
+            .pPoolSizes = poolSizes.data()
         };
 
         if (vkCreateDescriptorPool(this->device, &poolInfo, nullptr, &this->descriptorPool) != VK_SUCCESS)
@@ -830,7 +1820,25 @@ namespace ATR
             };
 
             vkUpdateDescriptorSets(this->device, 1, &descriptorWrite, 0, nullptr);
+
+            // Every slot of the fixed array has to be valid; the partially bound one only needs those handed out so far
+            const UInt writtenSlots = this->bindless ? this->textureSlotCount : this->textureCapacity;
+            for (UInt slot = 0; slot != writtenSlots; ++slot)
+                this->staleTextureSlots[i].push_back(slot);
+            this->UpdateTextureDescriptors(i);
+            this->UpdateDrawDataDescriptor(i);
         }
+
+        if (!this->gpuCulling)
+            return;
+
+        std::vector<VkDescriptorSetLayout> cullLayouts(VkResourceManager::maxFramesInFlight, this->cullSetLayout);
+        allocInfo.pSetLayouts = cullLayouts.data();
+        this->cullDescriptorSets.resize(VkResourceManager::maxFramesInFlight);
+        if (vkAllocateDescriptorSets(this->device, &allocInfo, this->cullDescriptorSets.data()) != VK_SUCCESS)
+            throw Exception("Failed to allocate culling descriptor sets", ExceptionType::INIT_BUFFER);
+        for (UInt i = 0; i != VkResourceManager::maxFramesInFlight; ++i)
+            this->UpdateCullDescriptors(i);
     }
 
     void VkResourceManager::CreateCommandBuffer()
@@ -846,6 +1854,23 @@ namespace ATR
 
         if (vkAllocateCommandBuffers(this->device, &commandBufferInfo, graphicsCommandBuffers.data()) != VK_SUCCESS)
             throw Exception("Failed to allocate command buffers", ExceptionType::INIT_BUFFER);
+
+        // Secondary ones for the early and late draws of every range, from the range's own pool
+        for (UInt frame = 0; frame != VkResourceManager::maxFramesInFlight; ++frame)
+        {
+            this->secondaryCommandBuffers[frame].resize(this->recordCommandPools[frame].size());
+            for (size_t range = 0; range != this->recordCommandPools[frame].size(); ++range)
+            {
+                const VkCommandBufferAllocateInfo secondaryInfo = {
+                    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                    .commandPool = this->recordCommandPools[frame][range],
+                    .level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+                    .commandBufferCount = static_cast<UInt>(this->secondaryCommandBuffers[frame][range].size())
+                };
+                if (vkAllocateCommandBuffers(this->device, &secondaryInfo, this->secondaryCommandBuffers[frame][range].data()) != VK_SUCCESS)
+                    throw Exception("Failed to allocate secondary command buffers", ExceptionType::INIT_BUFFER);
+            }
+        }
     }
 
     void VkResourceManager::CreateSyncGadgets()
@@ -879,11 +1904,31 @@ namespace ATR
     {
         vkWaitForFences(this->device, 1, &this->inFlightFences[this->currentFrameIndex], VK_TRUE, UINT64_MAX);
 
+        // Texture uploads are recorded here and never waited on; decoding happened on the worker threads
+        this->DestroyRetiredResources(this->currentFrameIndex);
+        this->ReleaseUnusedResources();
+        if (this->shaderWatcher)
+            this->ReloadChangedShaders();
+        this->CollectLoadedShaders();
+        this->CollectBuiltPipelines();
+        this->ReleaseFinishedStagings();
+        this->UploadPendingTextures();
+        if (this->textureBudget != 0 && this->frameCount % VkResourceManager::streamingFeedbackInterval == 0)
+            this->UpdateTextureResidency();
+        if (!this->staleTextureSlots[this->currentFrameIndex].empty())
+            this->UpdateTextureDescriptors(this->currentFrameIndex);            // Safe: this frame's set is no longer in use
+
+        // Edits through AddTriangle/UpdateMesh are staged on the loader threads like any other mesh
         if (this->meshStale)
         {
-            this->UpdateImageBuffers();
+            this->QueueMeshLoad(VkResourceManager::immediateMeshId, [mesh = std::make_shared<const Mesh>(this->mesh)]() { return mesh; });
             this->meshStale = false;
         }
+        this->PublishLoadedMeshes();
+        if (this->cpuCulling)
+            this->CullInstances();
+        this->UploadInstances(this->currentFrameIndex);
+        this->UploadDrawCommands(this->currentFrameIndex);
 
         UInt imageIndex;
         VkResult result = vkAcquireNextImageKHR(this->device, this->swapchain, UINT64_MAX, this->imageAvailableSemaphores[this->currentFrameIndex], VK_NULL_HANDLE, &imageIndex);
@@ -898,6 +1943,8 @@ namespace ATR
 
         vkResetFences(this->device, 1, &this->inFlightFences[this->currentFrameIndex]);             // Reset here to avoid deadlock
 
+        // The transforms come first, since the culling pass recorded with the draws takes its frustum from them
+        this->UpdateUniformBuffer(this->currentFrameIndex);
         vkResetCommandBuffer(this->graphicsCommandBuffers[this->currentFrameIndex], 0);
         RecordCommandBuffer(this->graphicsCommandBuffers[this->currentFrameIndex], imageIndex);
 
@@ -905,8 +1952,6 @@ namespace ATR
         VkSemaphore signalSemaphores[] = { this->renderFinishedSemaphores[this->currentFrameIndex] };
         VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
 
-        this->UpdateUniformBuffer(this->currentFrameIndex);
-
         VkSubmitInfo submitInfo = {
             .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
             .waitSemaphoreCount = 1,
@@ -942,6 +1987,7 @@ namespace ATR
             throw Exception("Failed to present swapchain image", ExceptionType::UPDATE_RENDER);
 
         this->currentFrameIndex = (this->currentFrameIndex + 1) % VkResourceManager::maxFramesInFlight;
+        ++this->frameCount;
     }
 
     void VkResourceManager::CleanUpSwapchain()
@@ -955,6 +2001,14 @@ namespace ATR
         vkDestroyImage(this->device, this->depthImage, nullptr);
         vkFreeMemory(this->device, this->depthImageMemory, nullptr);
 
+        vkDestroyDescriptorPool(this->device, this->depthPyramidDescriptorPool, nullptr);     // Frees the level sets
+        for (const auto& view : this->depthPyramidLevelViews)
+            vkDestroyImageView(this->device, view, nullptr);
+        this->depthPyramidLevelViews.clear();
+        vkDestroyImageView(this->device, this->depthPyramidView, nullptr);
+        vkDestroyImage(this->device, this->depthPyramid, nullptr);
+        vkFreeMemory(this->device, this->depthPyramidMemory, nullptr);
+
         vkDestroySwapchainKHR(this->device, this->swapchain, nullptr);
     }
 
@@ -1114,7 +2168,7 @@ namespace ATR
     }
 
     // TODO replace repetitions of this code block
-    void VkResourceManager::CreateImage(UInt width, UInt height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory)
+    void VkResourceManager::CreateImage(UInt width, UInt height, UInt mipLevels, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory)
     {
         VkImageCreateInfo imageInfo{};
         imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -1122,7 +2176,7 @@ namespace ATR
         imageInfo.extent.width = width;
         imageInfo.extent.height = height;
         imageInfo.extent.depth = 1;
-        imageInfo.mipLevels = 1;
+        imageInfo.mipLevels = mipLevels;
         imageInfo.arrayLayers = 1;
         imageInfo.format = format;
         imageInfo.tiling = tiling;
@@ -1150,7 +2204,7 @@ namespace ATR
         vkBindImageMemory(device, image, imageMemory, 0);
     }
 
-    VkImageView VkResourceManager::CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags)
+    VkImageView VkResourceManager::CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, UInt mipLevels)
     {
         VkImageViewCreateInfo viewInfo{};
         viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -1159,7 +2213,7 @@ namespace ATR
         viewInfo.format = format;
         viewInfo.subresourceRange.aspectMask = aspectFlags;
         viewInfo.subresourceRange.baseMipLevel = 0;
-        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.levelCount = mipLevels;
         viewInfo.subresourceRange.baseArrayLayer = 0;
         viewInfo.subresourceRange.layerCount = 1;
 
@@ -1187,6 +2241,24 @@ namespace ATR
         throw Exception("Failed to find supported format", ExceptionType::INIT_PIPELINE);
     }
 
+    Bool VkResourceManager::SupportsLinearBlit(VkFormat format)
+    {
+        VkFormatProperties props;
+        vkGetPhysicalDeviceFormatProperties(this->physicalDevice, format, &props);
+
+        const VkFormatFeatureFlags required = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+        return (props.optimalTilingFeatures & required) == required;
+    }
+
+    Bool VkResourceManager::SupportsSampling(VkFormat format)
+    {
+        VkFormatProperties props;
+        vkGetPhysicalDeviceFormatProperties(this->physicalDevice, format, &props);
+
+        const VkFormatFeatureFlags required = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+        return (props.optimalTilingFeatures & required) == required;
+    }
+
     Bool VkResourceManager::CheckDeviceExtensionSupport(VkPhysicalDevice device)
     {
         UInt deviceExtensionCount = 0;
@@ -1206,6 +2278,13 @@ namespace ATR
         return true;
     }
 
+    Bool VkResourceManager::DeviceHasExtension(const char* extensionName) const
+    {
+        return std::find_if(this->availableDeviceExtensions.begin(), this->availableDeviceExtensions.end(),
+            [&](const VkExtensionProperties& ext) { return strcmp(ext.extensionName, extensionName) == 0; }
+        ) != this->availableDeviceExtensions.end();
+    }
+
     void VkResourceManager::QuerySwapChainSupport(VkPhysicalDevice device)
     {
         // Capabilities
@@ -1330,6 +2409,37 @@ namespace ATR
         );
     }
 
+    Bool VkResourceManager::ReserveMappedBuffer(MappedBuffer& buffer, UInt count, VkDeviceSize elementSize, VkBufferUsageFlags usage, UInt frameIndex)
+    {
+        if (count <= buffer.capacity)
+            return false;
+
+        // The frame slot's fence has signaled, but the old buffer is retired like any other for uniformity
+        if (buffer.buffer.buffer != VK_NULL_HANDLE)
+            this->retiredResources[frameIndex].buffers.push_back(buffer.buffer);
+
+        buffer.capacity = std::max(count, 2 * buffer.capacity);
+        const VkDeviceSize size = elementSize * buffer.capacity;
+        this->CreateBuffer(size, usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, buffer.buffer.buffer, buffer.buffer.memory);
+        if (vkMapMemory(this->device, buffer.buffer.memory, 0, size, 0, &buffer.mapped) != VK_SUCCESS)
+            throw Exception("Failed to map buffer memory", ExceptionType::INIT_BUFFER);
+        return true;
+    }
+
+    Bool VkResourceManager::ReserveDeviceBuffer(DeviceBuffer& buffer, UInt count, VkDeviceSize elementSize, VkBufferUsageFlags usage, UInt frameIndex)
+    {
+        if (count <= buffer.capacity)
+            return false;
+
+        // Contents are rewritten by the GPU every frame, so nothing is copied over
+        if (buffer.buffer.buffer != VK_NULL_HANDLE)
+            this->retiredResources[frameIndex].buffers.push_back(buffer.buffer);
+
+        buffer.capacity = std::max(count, 2 * buffer.capacity);
+        this->CreateBuffer(elementSize * buffer.capacity, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer.buffer.buffer, buffer.buffer.memory);
+        return true;
+    }
+
     void VkResourceManager::CopyBuffer(VkBuffer src, VkBuffer dst, VkDeviceSize size)
     {
         VkCommandBufferAllocateInfo allocInfo = {
@@ -1373,6 +2483,61 @@ namespace ATR
         vkFreeCommandBuffers(this->device, this->transferCommandPool, 1, &copyCommandBuffer);
     }
 
+    VkCommandBuffer VkResourceManager::BeginSingleTimeCommands(VkCommandPool pool)
+    {
+        VkCommandBufferAllocateInfo allocInfo = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = pool,
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1
+        };
+
+        VkCommandBuffer commandBuffer;
+        if (vkAllocateCommandBuffers(this->device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+            throw Exception("Failed to allocate single-time command buffer", ExceptionType::UPDATE_MEMORY);
+
+        VkCommandBufferBeginInfo beginInfo = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+        };
+
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+            throw Exception("Failed to begin recording single-time command buffer", ExceptionType::UPDATE_MEMORY);
+
+        return commandBuffer;
+    }
+
+    void VkResourceManager::SubmitSingleTimeCommands(VkCommandBuffer commandBuffer, VkCommandPool pool, VkQueue queue, std::vector<BufferMemory> stagingBuffers)
+    {
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+            throw Exception("Failed to end recording single-time command buffer", ExceptionType::UPDATE_MEMORY);
+
+        // Unlike CopyBuffer, the queue is not waited on; the fence tells when the staging memory can go
+        VkFenceCreateInfo fenceInfo = {
+            .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO
+        };
+
+        StagingSubmission submission = {
+            .commandPool = pool,
+            .commandBuffer = commandBuffer,
+            .stagingBuffers = std::move(stagingBuffers)
+        };
+
+        if (vkCreateFence(this->device, &fenceInfo, nullptr, &submission.fence) != VK_SUCCESS)
+            throw Exception("Failed to create staging fence", ExceptionType::UPDATE_MEMORY);
+
+        VkSubmitInfo submitInfo = {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .commandBufferCount = 1,
+            .pCommandBuffers = &commandBuffer
+        };
+
+        if (vkQueueSubmit(queue, 1, &submitInfo, submission.fence) != VK_SUCCESS)
+            throw Exception("Failed to submit single-time command buffer", ExceptionType::UPDATE_MEMORY);
+
+        this->stagingSubmissions.push_back(submission);
+    }
+
     void VkResourceManager::RetrieveSwapChainImages()
     {
         UInt imageCount = 0;
@@ -1384,12 +2549,12 @@ namespace ATR
         ATR_PRINT_VERBOSE("Retrieved " + std::to_string(imageCount) + " images in total in the swapchain.")
     }
 
-    inline VkFormat VkResourceManager::FindDepthFormat()
+    inline VkFormat VkResourceManager::FindDepthFormat(VkFormatFeatureFlags features)
     {
         return FindSupportedFormat(
             { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
             VK_IMAGE_TILING_OPTIMAL,
-            VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
+            VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | features
         );
     }
 
@@ -1410,51 +2575,451 @@ namespace ATR
         if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
             throw Exception("Failed to begin recording command buffer for rendering", ExceptionType::INIT_PIPELINE);
 
-        std::array<VkClearValue, 2> clearValues = { VkResourceManager::defaultClearValue, VkResourceManager::defaultDepthClearValue };
+        // Pipelines are resolved up front, since resolving may collect builds; recording only reads the results
+        std::vector<const PipelineRecord*> groupPipelines;
+        groupPipelines.reserve(this->drawGroups.size());
+        for (const DrawGroup& group : this->drawGroups)
+            groupPipelines.push_back(this->ResolvePipeline(this->pipelineVariants[group.variant].pipeline));
+
+        // Groups drawn in one call each cost a call, the others a call per command
+        const UInt commandCount = static_cast<UInt>(this->drawCommands.size());
+        const Bool callPerGroup = this->drawIndirectCount || this->multiDraw;
+        const UInt callCount = callPerGroup ? static_cast<UInt>(this->drawGroups.size()) : commandCount;
+        const UInt partitionCount = this->parallelRecording ?
+            std::clamp(callCount / VkResourceManager::recordBatchSize, 1u, static_cast<UInt>(this->recordCommandPools[this->currentFrameIndex].size())) : 1;
+        const Bool secondary = partitionCount > 1;
+
+        // Ranges beyond the first go to the recording threads while the render thread records the first, ahead of the passes that execute them
+        if (secondary)
+        {
+            std::vector<std::future<void>> partitions;
+            for (UInt partition = 1; partition != partitionCount; ++partition)
+                partitions.push_back(this->recordThreads->Submit([this, partition, partitionCount, imageIndex, &groupPipelines]() {
+                    this->RecordDrawPartition(partition, partitionCount, imageIndex, groupPipelines);
+                }));
+
+            // The jobs read `groupPipelines` off this frame, so all of them finish before the first error leaves it
+            std::exception_ptr error;
+            try
+            {
+                this->RecordDrawPartition(0, partitionCount, imageIndex, groupPipelines);
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+            for (std::future<void>& partition : partitions)
+            {
+                try
+                {
+                    partition.get();
+                }
+                catch (...)
+                {
+                    if (!error)
+                        error = std::current_exception();
+                }
+            }
+            if (error)
+                std::rethrow_exception(error);
+        }
+        const auto recordDraws = [&](Bool late) {
+            if (!secondary)
+            {
+                this->RecordDraws(commandBuffer, late, 0, commandCount, groupPipelines);
+                return;
+            }
+            std::vector<VkCommandBuffer> secondaryBuffers;
+            for (UInt partition = 0; partition != partitionCount; ++partition)
+                secondaryBuffers.push_back(this->secondaryCommandBuffers[this->currentFrameIndex][partition][late ? 1 : 0]);
+            vkCmdExecuteCommands(commandBuffer, static_cast<UInt>(secondaryBuffers.size()), secondaryBuffers.data());
+        };
+
+        // With two-phase occlusion culling the main pass is split around the depth pyramid, drawing what it reveals in the second half
+        if (this->gpuCulling)
+            this->RecordCullPass(commandBuffer, false);
+        this->BeginMainPass(commandBuffer, imageIndex, false, secondary);
+        recordDraws(false);
+        this->EndMainPass(commandBuffer, imageIndex, this->twoPhaseOcclusion);
 
-        VkRenderPassBeginInfo renderPassInfo = {
-            .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-            .renderPass = this->renderPass,
-            .framebuffer = this->swapchainFrameBuffers[imageIndex],
-            .renderArea = {
-                .offset = { 0, 0 },
-                .extent = this->swapChainConfig.extent
-            },
-            .clearValueCount = static_cast<UInt>(clearValues.size()),
-            .pClearValues = clearValues.data()
+        if (this->occlusionCulling)
+            this->RecordDepthPyramid(commandBuffer);
+        if (this->twoPhaseOcclusion)
+        {
+            this->RecordCullPass(commandBuffer, true);
+            this->BeginMainPass(commandBuffer, imageIndex, true, secondary);
+            recordDraws(true);
+            this->EndMainPass(commandBuffer, imageIndex, false);
+
+            // Built again, so that the next frame's early pass sees what the late draws cover too
+            this->RecordDepthPyramid(commandBuffer);
+        }
+
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+            throw Exception("Failed to end recording command buffer for rendering", ExceptionType::INIT_PIPELINE);
+    }
+
+    void VkResourceManager::RecordCullPass(VkCommandBuffer commandBuffer, Bool late)
+    {
+        // Tested in the space the instance transforms start from, so the spheres only need those applied
+        const UInt groupCount = static_cast<UInt>(this->drawGroups.size()), commandCount = static_cast<UInt>(this->drawCommands.size());
+        if (commandCount == 0)
+            return;
+        CullConstants constants = {
+            .planes = Frustum::FromMatrix(this->frameTransforms.proj * this->frameTransforms.view * this->frameTransforms.model).planes,
+            .instanceCount = this->instanceCount,
+            .commandCount = commandCount,
+            .groupCount = groupCount,
+            .phase = CullConstants::cullPhase,
+            .instanceWords = sizeof(InstanceData) / sizeof(UInt),
+            .drawWord = offsetof(InstanceData, draw) / sizeof(UInt),
+            .flags = (this->occlusionCulling ? CullConstants::occlusionFlag : 0) | (this->twoPhaseOcclusion ? CullConstants::twoPhaseFlag : 0) | (late ? CullConstants::lateFlag : 0)
+        };
+
+        // Counters of both passes start from zero; the previous use of this frame's buffers finished with its fence
+        VkMemoryBarrier barrier = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
         };
+        if (!late)
+        {
+            const UInt passes = this->twoPhaseOcclusion ? 2 : 1;
+            vkCmdFillBuffer(commandBuffer, this->cullCounterBuffers[this->currentFrameIndex].buffer.buffer, 0, VkDeviceSize(sizeof(UInt)) * passes * (groupCount + commandCount), 0);
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+        }
 
-        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->cullPipeline);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->cullPipelineLayout, 0, 1, &this->cullDescriptorSets[this->currentFrameIndex], 0, nullptr);
+        vkCmdPushConstants(commandBuffer, this->cullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, this->cullLayout.pushConstants.front().size, &constants);
+        if (this->instanceCount != 0)
+            vkCmdDispatch(commandBuffer, (this->instanceCount + VkResourceManager::cullGroupSize - 1) / VkResourceManager::cullGroupSize, 1, 1);
+
+        // Every instance is counted before any command is written
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        constants.phase = this->drawIndirectCount ? CullConstants::compactPhase : CullConstants::writePhase;
+        vkCmdPushConstants(commandBuffer, this->cullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, offsetof(CullConstants, phase), sizeof(UInt), &constants.phase);
+        if (commandCount != 0)
+            vkCmdDispatch(commandBuffer, (commandCount + VkResourceManager::cullGroupSize - 1) / VkResourceManager::cullGroupSize, 1, 1);
+
+        // The draws read the commands, the counts and the instances
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
 
-            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, this->graphicsPipeline);
+    void VkResourceManager::RecordDepthPyramid(VkCommandBuffer commandBuffer)
+    {
+        // The main pass's depth writes land before the pyramid reads them, and the culling pass's reads of the pyramid before it is overwritten
+        const VkImageAspectFlags depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT | (this->HasStencilComponent(this->depthFormat) ? VK_IMAGE_ASPECT_STENCIL_BIT : 0);
+        VkImageMemoryBarrier depthBarrier = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            .newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = this->depthImage,
+            .subresourceRange = { depthAspect, 0, 1, 0, 1 }
+        };
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &depthBarrier);
+
+        // Level by level, each reading the one written before it; the last barrier also hands the pyramid to the next culling pass
+        const VkMemoryBarrier levelBarrier = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT
+        };
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->depthPyramidPipeline);
+        for (UInt level = 0; level != this->depthPyramidDescriptorSets.size(); ++level)
+        {
+            const UInt width = std::max(this->depthPyramidExtent.width >> level, 1u), height = std::max(this->depthPyramidExtent.height >> level, 1u);
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->depthPyramidPipelineLayout, 0, 1, &this->depthPyramidDescriptorSets[level], 0, nullptr);
+            vkCmdDispatch(commandBuffer, (width + VkResourceManager::depthPyramidGroupSize - 1) / VkResourceManager::depthPyramidGroupSize,
+                (height + VkResourceManager::depthPyramidGroupSize - 1) / VkResourceManager::depthPyramidGroupSize, 1);
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &levelBarrier, 0, nullptr, 0, nullptr);
+        }
 
-            VkViewport viewport;
-            viewport.x = 0;
-            viewport.y = 0;
-            viewport.width = (Float)this->swapChainConfig.extent.width;
-            viewport.height = (Float)this->swapChainConfig.extent.height;
-            viewport.minDepth = 0.0f;
-            viewport.maxDepth = 1.0f;
-            vkCmdSetViewport(this->graphicsCommandBuffers[this->currentFrameIndex], 0, 1, &viewport);
+        // Back to the layout the late draws load it in; the next main pass's depth writes wait for the reads above
+        depthBarrier.srcAccessMask = 0;
+        depthBarrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        depthBarrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+        depthBarrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &depthBarrier);
+    }
 
-            VkRect2D scissor;
-            scissor.offset = { 0, 0 };
-            scissor.extent = this->swapChainConfig.extent;
-            vkCmdSetScissor(this->graphicsCommandBuffers[this->currentFrameIndex], 0, 1, &scissor);
+    void VkResourceManager::RecordDrawPartition(UInt partition, UInt partitionCount, UInt imageIndex, const std::vector<const PipelineRecord*>& groupPipelines)
+    {
+        // The range's pool belongs to this job alone; this frame's previous use of it finished with the frame's fence
+        if (vkResetCommandPool(this->device, this->recordCommandPools[this->currentFrameIndex][partition], 0) != VK_SUCCESS)
+            throw Exception("Failed to reset recording command pool", ExceptionType::UPDATE_RENDER);
+
+        const LUInt commandCount = this->drawCommands.size();
+        const UInt beginCommand = static_cast<UInt>(commandCount * partition / partitionCount);
+        const UInt endCommand = static_cast<UInt>(commandCount * (partition + 1) / partitionCount);
+        for (UInt half = 0; half != (this->twoPhaseOcclusion ? 2 : 1); ++half)
+        {
+            // Recorded for the pass the half is drawn in: the render pass (compatible ones share the inheritance), or the attachment formats
+            const VkCommandBufferInheritanceRenderingInfo renderingInheritance = {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO,
+                .colorAttachmentCount = 1,
+                .pColorAttachmentFormats = &this->colorFormat,
+                .depthAttachmentFormat = this->depthFormat,
+                .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT
+            };
+            const VkCommandBufferInheritanceInfo inheritanceInfo = {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+                .pNext = this->dynamicRendering ? &renderingInheritance : nullptr,
+                .renderPass = half == 0 ? this->renderPass : this->resumeRenderPass,
+                .subpass = 0,
+                .framebuffer = this->dynamicRendering ? VK_NULL_HANDLE : this->swapchainFrameBuffers[imageIndex]
+            };
+            const VkCommandBufferBeginInfo beginInfo = {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                .flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+                .pInheritanceInfo = &inheritanceInfo
+            };
 
-            VkBuffer vertexBuffers[] = { this->vertexBuffer };
-            VkDeviceSize offsets[] = { 0 };
-            vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-            vkCmdBindIndexBuffer(commandBuffer, this->indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+            const VkCommandBuffer commandBuffer = this->secondaryCommandBuffers[this->currentFrameIndex][partition][half];
+            if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+                throw Exception("Failed to begin recording secondary command buffer", ExceptionType::INIT_PIPELINE);
+            this->RecordDraws(commandBuffer, half == 1, beginCommand, endCommand, groupPipelines);
+            if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+                throw Exception("Failed to end recording secondary command buffer", ExceptionType::INIT_PIPELINE);
+        }
+    }
 
-            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, this->pipelineLayout, 0, 1, &this->descriptorSets[this->currentFrameIndex], 0, nullptr);
+    void VkResourceManager::RecordDraws(VkCommandBuffer commandBuffer, Bool late, UInt beginCommand, UInt endCommand, const std::vector<const PipelineRecord*>& groupPipelines)
+    {
+        // Nothing carries over into secondary command buffers, so every range sets all of its state
+        //  Runs on the recording threads: reads nothing the render thread changes while they run
+        VkViewport viewport;
+        viewport.x = 0;
+        viewport.y = 0;
+        viewport.width = (Float)this->swapChainConfig.extent.width;
+        viewport.height = (Float)this->swapChainConfig.extent.height;
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+        VkRect2D scissor;
+        scissor.offset = { 0, 0 };
+        scissor.extent = this->swapChainConfig.extent;
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+        // Culled draws read the instances and commands the culling pass wrote, at the same places
+        VkBuffer vertexBuffers[] = { this->vertexBuffer, (this->gpuCulling ? this->culledInstanceBuffers[this->currentFrameIndex].buffer : this->instanceBuffers[this->currentFrameIndex].buffer).buffer };
+        VkDeviceSize offsets[] = { 0, 0 };
+        vkCmdBindVertexBuffers(commandBuffer, 0, 2, vertexBuffers, offsets);
+        vkCmdBindIndexBuffer(commandBuffer, this->indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+        // One submission per group of draws, see UploadDrawCommands
+        const PushConstantObject pushConstants = { .textureIndex = this->boundTexture };
+        const VkBuffer indirectBuffer = (this->gpuCulling ? this->culledCommandBuffers[this->currentFrameIndex].buffer : this->drawCommandBuffers[this->currentFrameIndex].buffer).buffer;
+        const UInt commandStride = this->gpuCulling ? sizeof(VkDrawIndexedIndirectCommand) : sizeof(DrawCommand);
+        // The late pass's commands and counters follow the early pass's
+        const UInt firstCommand = late ? static_cast<UInt>(this->drawCommands.size()) : 0;
+        const UInt firstCounter = late ? static_cast<UInt>(this->drawGroups.size() + this->drawCommands.size()) : 0;
+        // Groups drawn in one call belong to the range holding their first command; the others' commands are split between ranges
+        const Bool callPerGroup = this->drawIndirectCount || this->multiDraw;
+        std::optional<DynamicPipelineState> dynamicState;
+        VkPipeline boundPipeline = VK_NULL_HANDLE;
+        VkPipelineLayout boundLayout = VK_NULL_HANDLE;
+        for (UInt groupIndex = 0; groupIndex != this->drawGroups.size(); ++groupIndex)
+        {
+            const DrawGroup& group = this->drawGroups[groupIndex];
+            const UInt groupBegin = std::max(beginCommand, group.firstCommand), groupEnd = std::min(endCommand, group.firstCommand + group.commandCount);
+            if (callPerGroup ? group.firstCommand < beginCommand || group.firstCommand >= endCommand : groupBegin >= groupEnd)
+                continue;
+
+            // Pipelines still compiling resolved to the fallback, which stays bound across them; failed ones without a compatible fallback draw nothing
+            if (groupPipelines[groupIndex] == nullptr)
+                continue;
+            const PipelineVariant& variant = this->pipelineVariants[group.variant];
+            const PipelineRecord& pipeline = *groupPipelines[groupIndex];
+            if (pipeline.pipeline != boundPipeline)
+                vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline);
+            boundPipeline = pipeline.pipeline;
+
+            // Pipelines sharing a layout (most do, layouts are deduplicated) keep the bound set and push constants
+            if (pipeline.layout != boundLayout)
+            {
+                vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.layout, 0, 1, &this->descriptorSets[this->currentFrameIndex], 0, nullptr);
+                if (pipeline.pushConstantStages != 0)
+                    vkCmdPushConstants(commandBuffer, pipeline.layout, pipeline.pushConstantStages, 0, pipeline.pushConstantSize, &pushConstants);
+                boundLayout = pipeline.layout;
+            }
 
-            vkCmdDrawIndexed(commandBuffer, this->mesh.GetIndices().size(), 1, 0, 0, 0);
+            // Every pipeline leaves the same states dynamic, so they carry over pipeline binds
+            if (this->extendedDynamicState && dynamicState != variant.dynamic)
+            {
+                this->SetDynamicState(commandBuffer, variant.dynamic, dynamicState);
+                dynamicState = variant.dynamic;
+            }
 
-        vkCmdEndRenderPass(commandBuffer);
+            // Compacted groups draw as many commands as the culling pass counted, the counts leading the counter buffer
+            //  Without multiDraw every command is its own submission, still without reading anything back on the CPU
+            if (this->drawIndirectCount)
+                this->cmdDrawIndexedIndirectCount(commandBuffer, indirectBuffer, VkDeviceSize(commandStride) * (firstCommand + group.firstCommand),
+                    this->cullCounterBuffers[this->currentFrameIndex].buffer.buffer, VkDeviceSize(sizeof(UInt)) * (firstCounter + groupIndex), group.commandCount, commandStride);
+            else if (this->multiDraw)
+                vkCmdDrawIndexedIndirect(commandBuffer, indirectBuffer, VkDeviceSize(commandStride) * (firstCommand + group.firstCommand), group.commandCount, commandStride);
+            else if (this->indirectDraws)
+                for (UInt i = groupBegin; i != groupEnd; ++i)
+                    vkCmdDrawIndexedIndirect(commandBuffer, indirectBuffer, VkDeviceSize(commandStride) * (firstCommand + i), 1, commandStride);
+            else
+                for (UInt i = groupBegin; i != groupEnd; ++i)
+                {
+                    const VkDrawIndexedIndirectCommand& command = this->drawCommands[i].draw;
+                    vkCmdDrawIndexed(commandBuffer, command.indexCount, command.instanceCount, command.firstIndex, command.vertexOffset, command.firstInstance);
+                }
+        }
+    }
 
-        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
-            throw Exception("Failed to end recording command buffer for rendering", ExceptionType::INIT_PIPELINE);
+    void VkResourceManager::SetDynamicState(VkCommandBuffer commandBuffer, const DynamicPipelineState& state, const std::optional<DynamicPipelineState>& current)
+    {
+        // Only what differs from the state already set; everything at the first draw of a command buffer
+        if (!current || current->topology != state.topology)
+            this->cmdSetPrimitiveTopology(commandBuffer, state.topology);
+        if (!current || current->cullMode != state.cullMode)
+            this->cmdSetCullMode(commandBuffer, state.cullMode);
+        if (!current || current->frontFace != state.frontFace)
+            this->cmdSetFrontFace(commandBuffer, state.frontFace);
+        if (!current || current->depthTest != state.depthTest)
+            this->cmdSetDepthTestEnable(commandBuffer, state.depthTest);
+        if (!current || current->depthWrite != state.depthWrite)
+            this->cmdSetDepthWriteEnable(commandBuffer, state.depthWrite);
+        if (!current || current->depthCompareOp != state.depthCompareOp)
+            this->cmdSetDepthCompareOp(commandBuffer, state.depthCompareOp);
+    }
+
+    void VkResourceManager::BeginMainPass(VkCommandBuffer commandBuffer, UInt imageIndex, Bool resume, Bool secondary)
+    {
+        const VkRect2D renderArea = {
+            .offset = { 0, 0 },
+            .extent = this->swapChainConfig.extent
+        };
+
+        if (!this->dynamicRendering)
+        {
+            std::array<VkClearValue, 2> clearValues = { VkResourceManager::defaultClearValue, VkResourceManager::defaultDepthClearValue };
+
+            VkRenderPassBeginInfo renderPassInfo = {
+                .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+                .renderPass = resume ? this->resumeRenderPass : this->renderPass,
+                .framebuffer = this->swapchainFrameBuffers[imageIndex],
+                .renderArea = renderArea,
+                .clearValueCount = static_cast<UInt>(clearValues.size()),
+                .pClearValues = clearValues.data()
+            };
+
+            vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, secondary ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+            return;
+        }
+
+        // What the render pass's layouts and external dependency did: both attachments are cleared, so their old contents are discarded
+        //  The color write waits for the acquire semaphore (signalled at this stage), the depth write for the previous frame's depth tests
+        const VkImageAspectFlags depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT | (this->HasStencilComponent(this->depthFormat) ? VK_IMAGE_ASPECT_STENCIL_BIT : 0);
+        const std::array<VkImageMemoryBarrier, 2> barriers = { {
+            {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                .srcAccessMask = 0,
+                .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                .newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = this->swapchainImages[imageIndex],
+                .subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }
+            },
+            {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                .srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                .newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = this->depthImage,
+                .subresourceRange = { depthAspect, 0, 1, 0, 1 }
+            }
+        } };
+        const VkPipelineStageFlags attachmentStages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        if (!resume)
+            vkCmdPipelineBarrier(commandBuffer, attachmentStages, attachmentStages, 0, 0, nullptr, 0, nullptr, static_cast<UInt>(barriers.size()), barriers.data());
+        else
+        {
+            // Resuming, the attachments keep their layouts and contents; the depth came back from the pyramid through its own barrier
+            const VkMemoryBarrier colorBarrier = {
+                .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+            };
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, 1, &colorBarrier, 0, nullptr, 0, nullptr);
+        }
+
+        // The depth is kept for the depth pyramid, which is built after each half when the pass is split
+        const VkAttachmentLoadOp loadOp = resume ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
+
+        const VkRenderingAttachmentInfo colorAttachment = {
+            .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+            .imageView = this->swapchainImageViews[imageIndex],
+            .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            .loadOp = loadOp,
+            .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+            .clearValue = VkResourceManager::defaultClearValue
+        };
+        const VkRenderingAttachmentInfo depthAttachment = {
+            .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+            .imageView = this->depthImageView,
+            .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            .loadOp = loadOp,
+            .storeOp = this->occlusionCulling ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .clearValue = VkResourceManager::defaultDepthClearValue
+        };
+        const VkRenderingInfo renderingInfo = {
+            .sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+            .flags = secondary ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : VkRenderingFlags(0),
+            .renderArea = renderArea,
+            .layerCount = 1,
+            .colorAttachmentCount = 1,
+            .pColorAttachments = &colorAttachment,
+            .pDepthAttachment = &depthAttachment
+        };
+        this->cmdBeginRendering(commandBuffer, &renderingInfo);
+    }
+
+    void VkResourceManager::EndMainPass(VkCommandBuffer commandBuffer, UInt imageIndex, Bool suspend)
+    {
+        if (!this->dynamicRendering)
+        {
+            vkCmdEndRenderPass(commandBuffer);
+            return;
+        }
+
+        this->cmdEndRendering(commandBuffer);
+        if (suspend)
+            return;                             // Presented after the second half
+
+        // Presentation waits on the render finished semaphore, so the transition needs no later stage
+        const VkImageMemoryBarrier presentBarrier = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+            .dstAccessMask = 0,
+            .oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            .newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = this->swapchainImages[imageIndex],
+            .subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }
+        };
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &presentBarrier);
     }
 
     UInt VkResourceManager::FindMemoryType(UInt typeFilter, VkMemoryPropertyFlags properties)
@@ -1481,17 +3046,46 @@ namespace ATR
 
         UniformBufferObject ubo;
         //ubo.model = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.f), glm::vec3(0.0f, 0.0f, 1.0f));
-        ubo.model = glm::mat4(1.0f);
-        ubo.view = glm::lookAt(glm::vec3(2.f, 2.f, 2.f), glm::vec3(0.f, 0.f, 0.f), glm::vec3(0.f, 0.f, 1.f));
-        auto swapExtent = this->swapChainConfig.extent;
-        ubo.proj = glm::perspective(glm::radians(45.f), static_cast<float>(swapExtent.width) / static_cast<float>(swapExtent.height), 0.1f, 10.f);
+        ubo.model = glm::mat4(1.0f);                    // CPU culling takes world space to be model space
+        ubo.view = this->camera.View();
+        ubo.proj = this->camera.Projection();
+        ubo.previousView = this->frameTransforms.view;
+        ubo.previousProj = this->frameTransforms.proj;
 
-        ubo.proj[1][1] *= -1;       // Vulkan designates the origin of an image to be the upper-left vertex
-        
         // TODO learn about "push constants" for improving efficiency
         memcpy(this->uniformBufferMappedMemory[currentFrameIndex], &ubo, sizeof(ubo));
+        this->frameTransforms = ubo;
     } 
 
+    Float VkResourceManager::EstimateScreenDiameter(const MeshRecord& record) const
+    {
+        // Bounding spheres stand in for the triangles: the largest projection among the mesh's instances, in pixels
+        //  Spheres behind the camera or beside the view are off screen; one reaching past the camera covers all of it
+        const Mat4 view = this->frameTransforms.view * this->frameTransforms.model;
+        const Vec2 focal = glm::abs(Vec2(this->frameTransforms.proj[0][0], this->frameTransforms.proj[1][1]));
+        const Float screenHeight = static_cast<Float>(this->swapChainConfig.extent.height);
+        const Float screenSize = static_cast<Float>(std::max(this->swapChainConfig.extent.width, this->swapChainConfig.extent.height));
+
+        auto project = [&](const Mat4& transform) {
+            const Mat4 modelView = view * transform;
+            const Vec3 center = Vec3(modelView * Vec4(Vec3(record.bounds), 1.f));
+            const Float radius = record.bounds.w * std::max({ glm::length(Vec3(modelView[0])), glm::length(Vec3(modelView[1])), glm::length(Vec3(modelView[2])) });
+            const Float depth = -center.z;
+            if (depth <= radius)
+                return depth + radius > 0.f ? screenSize : 0.f;
+            if ((std::abs(center.x) - radius) * focal.x > depth || (std::abs(center.y) - radius) * focal.y > depth)
+                return 0.f;
+            return radius * focal.y * screenHeight / depth;
+        };
+
+        if (record.instances.empty())
+            return project(Mat4(1.f));
+        Float diameter = 0.f;
+        for (const InstanceData& instance : record.instances)
+            diameter = std::max(diameter, project(instance.transform));
+        return diameter;
+    }
+
     void VkResourceManager::RecreateSwapchain()
     {
         // If window is minimized, pause update
@@ -1511,81 +3105,1393 @@ namespace ATR
         CreateSwapchain();
         CreateImageViews();
         CreateDepthBuffer();
+        CreateDepthPyramid();
         CreateFrameBuffers();
     }
 
-    void VkResourceManager::UpdateImageBuffers()
+    MeshHandle VkResourceManager::LoadMesh(const String& path)
     {
-        ATR_LOG("Updating Mesh Infos...")
-        VkDeviceSize indexBufferSize = sizeof(UInt) * this->mesh.GetIndices().size();
+        const LUInt key = VkResourceManager::SourceKey({ path });
+        if (auto cached = this->meshCache.find(key); cached != this->meshCache.end())
+            if (std::shared_ptr<void> reference = cached->second.reference.lock())
+                return { .id = cached->second.id, .ready = this->meshes[cached->second.id].ready, .reference = std::move(reference) };
+
+        MeshHandle handle = this->CreateMeshHandle(key);
+        ATR_LOG_VERBOSE("Queueing mesh " << path << " as mesh " << handle.id)
+        if (std::shared_ptr<const AssetArchive> archive = this->FindArchive(path))
+        {
+            this->QueueMeshLoad(handle.id, [path, archive]() {
+                return std::make_shared<const Mesh>(archive->Parse(path, [&path](std::istream& stream) { return MeshLoader::Load(path, stream); }));
+            });
+            return handle;
+        }
 
-        VkBuffer indexStagingBuffer;
-        VkDeviceMemory indexStagingBufferMemory;
+        const UInt id = handle.id, version = ++this->meshes[id].requestedVersion;
+        this->ReadLooseFile(path, this->loaderPool,
+            [this, id, version, path](std::istream& stream) {
+                this->StageMeshLoad(id, version, [&]() { return std::make_shared<const Mesh>(MeshLoader::Load(path, stream)); });
+            },
+            [this, id, version](std::exception_ptr error) { this->stagedMeshes.Push({ .id = id, .version = version, .error = error }); });
+        return handle;
+    }
 
-        this->CreateStagingBuffer(indexBufferSize, indexStagingBuffer, indexStagingBufferMemory);
+    MeshHandle VkResourceManager::LoadMesh(Mesh mesh)
+    {
+        static_assert(sizeof(Vertex) == sizeof(Float) * 11, "Vertices are hashed as bytes and must not contain padding");
 
-        void* indexData;
-        vkMapMemory(this->device, indexStagingBufferMemory, 0, indexBufferSize, 0, &indexData);
-        memcpy(indexData, this->mesh.GetIndices().data(), static_cast<size_t>(indexBufferSize));
-        vkUnmapMemory(this->device, indexStagingBufferMemory);
-        
-        this->CopyBuffer(indexStagingBuffer, this->indexBuffer, indexBufferSize);
+        const auto& vertices = mesh.GetVertices();
+        const auto& indices = mesh.GetIndices();
+        LUInt key = HashValue(vertices.size());
+        key = HashBytes(vertices.data(), sizeof(Vertex) * vertices.size(), key);
+        key = HashBytes(indices.data(), sizeof(UInt) * indices.size(), key);
 
-        vkDestroyBuffer(this->device, indexStagingBuffer, nullptr);
-        vkFreeMemory(this->device, indexStagingBufferMemory, nullptr);
+        if (auto cached = this->meshCache.find(key); cached != this->meshCache.end())
+            if (std::shared_ptr<void> reference = cached->second.reference.lock())
+                return { .id = cached->second.id, .ready = this->meshes[cached->second.id].ready, .reference = std::move(reference) };
 
-        VkDeviceSize vertexBufferSize = sizeof(Vertex) * this->mesh.GetVertices().size();
+        MeshHandle handle = this->CreateMeshHandle(key);
+        this->QueueMeshLoad(handle.id, [mesh = std::make_shared<const Mesh>(std::move(mesh))]() { return mesh; });
+        return handle;
+    }
+
+    MeshHandle VkResourceManager::CreateMeshHandle(LUInt cacheKey)
+    {
+        UInt id;
+        if (!this->freeMeshIds.empty())
+        {
+            id = this->freeMeshIds.back();
+            this->freeMeshIds.pop_back();
+        }
+        else
+        {
+            id = static_cast<UInt>(this->meshes.size());
+            this->meshes.emplace_back();
+            this->instancesStale.fill(true);                                // The new slot needs its instance range
+            this->instanceBoundsStale = true;
+        }
 
-        VkBuffer vertexStagingBuffer;
-        VkDeviceMemory vertexStagingBufferMemory;
+        MeshRecord& record = this->meshes[id];
+        record.cacheKey = cacheKey;
+        record.ready = record.published.get_future().share();
+
+        MeshHandle handle = { .id = id, .ready = record.ready, .reference = MakeResourceReference(this->releasedMeshes, id) };
+        this->meshCache[cacheKey] = { .id = id, .reference = handle.reference };
+        return handle;
+    }
+
+    InstanceHandle VkResourceManager::AddInstance(const MeshHandle& mesh, const Mat4& transform, const Vec4& color)
+    {
+        UInt id;
+        if (!this->freeInstanceIds.empty())
+        {
+            id = this->freeInstanceIds.back();
+            this->freeInstanceIds.pop_back();
+        }
+        else
+        {
+            id = static_cast<UInt>(this->instanceSlots.size());
+            this->instanceSlots.emplace_back();
+        }
 
-        this->CreateStagingBuffer(vertexBufferSize, vertexStagingBuffer, vertexStagingBufferMemory);
+        MeshRecord& record = this->meshes[mesh.id];
+        this->instanceSlots[id] = { .mesh = mesh.id, .index = static_cast<UInt>(record.instances.size()), .meshReference = mesh.reference, .live = true };
+        record.instances.push_back({ .transform = transform, .color = color, .draw = mesh.id });
+        record.instanceIds.push_back(id);
+        this->instancesStale.fill(true);
+        this->instanceBoundsStale = true;
+        return { .id = id };
+    }
 
-        void* vertexData;
-        vkMapMemory(this->device, vertexStagingBufferMemory, 0, vertexBufferSize, 0, &vertexData);
-        memcpy(vertexData, this->mesh.GetVertices().data(), static_cast<size_t>(vertexBufferSize));
-        vkUnmapMemory(this->device, vertexStagingBufferMemory);
+    void VkResourceManager::UpdateInstance(const InstanceHandle& instance, const Mat4& transform, const Vec4& color)
+    {
+        if (instance.id >= this->instanceSlots.size() || !this->instanceSlots[instance.id].live)
+            throw Exception("Invalid instance handle " + std::to_string(instance.id), ExceptionType::UPDATE_RENDER);
+
+        const InstanceSlot& slot = this->instanceSlots[instance.id];
+        MeshRecord& record = this->meshes[slot.mesh];
+        record.instances[slot.index] = { .transform = transform, .color = color, .draw = slot.mesh };
+        this->instanceBoundsStale = true;
+
+        // Ranges only move when instances come or go, which rewrites the buffers whole; an update dirties its own element
+        //  While a rewrite is pending the placement may be outdated, but then the span is not used
+        const UInt position = record.firstInstance + slot.index;
+        for (std::pair<UInt, UInt>& dirty : this->dirtyInstances)
+            dirty = dirty.first == dirty.second ? std::pair(position, position + 1) : std::pair(std::min(dirty.first, position), std::max(dirty.second, position + 1));
+    }
 
-        this->CopyBuffer(vertexStagingBuffer, this->vertexBuffer, vertexBufferSize);
+    void VkResourceManager::RemoveInstance(const InstanceHandle& instance)
+    {
+        if (instance.id >= this->instanceSlots.size() || !this->instanceSlots[instance.id].live)
+            throw Exception("Invalid instance handle " + std::to_string(instance.id), ExceptionType::UPDATE_RENDER);
+
+        // The mesh's last instance moves into the gap, keeping its range dense
+        InstanceSlot& slot = this->instanceSlots[instance.id];
+        MeshRecord& record = this->meshes[slot.mesh];
+        record.instances[slot.index] = record.instances.back();
+        record.instanceIds[slot.index] = record.instanceIds.back();
+        this->instanceSlots[record.instanceIds[slot.index]].index = slot.index;
+        record.instances.pop_back();
+        record.instanceIds.pop_back();
+
+        slot = InstanceSlot();                                              // Drops the mesh reference
+        this->freeInstanceIds.push_back(instance.id);
+        this->instancesStale.fill(true);
+        this->instanceBoundsStale = true;
+    }
 
-        vkDestroyBuffer(this->device, vertexStagingBuffer, nullptr);
-        vkFreeMemory(this->device, vertexStagingBufferMemory, nullptr);
+    UInt VkResourceManager::PlaceInstances()
+    {
+        // Every slot gets a range, so that placing them never depends on which meshes are loaded
+        //  Both frames' buffers are laid out alike from the same records; a buffer not yet rewritten is stale and rewritten before its next use
+        UInt count = 0;
+        for (MeshRecord& record : this->meshes)
+        {
+            record.firstInstance = count;
+            count += std::max<UInt>(static_cast<UInt>(record.instances.size()), 1);
+        }
+        this->instanceCount = count;
+        return count;
     }
 
-    void VkResourceManager::CompileShaders()
+    void VkResourceManager::CullInstances()
     {
-        const String& path = this->relLocation;
-        const String sep = (path == "") ? "" : "\\";
-        const String compilerPath = path + sep + "..\\vendor\\bin\\Windows\\glslc.exe";
+        // Spheres sit where their instances sit in the instance buffers, the implicit instance of a slot without any included
+        if (this->instanceBoundsStale)
+        {
+            this->instanceBounds.Resize(this->PlaceInstances());
+            for (const MeshRecord& record : this->meshes)
+            {
+                const Vec3 center = Vec3(record.bounds);
+                if (record.instances.empty())
+                    this->instanceBounds.Set(record.firstInstance, center, record.bounds.w);
+
+                // The largest axis scale of a transform bounds how much the sphere grows
+                for (UInt i = 0; i != record.instances.size(); ++i)
+                {
+                    const Mat4& transform = record.instances[i].transform;
+                    const Float scale = std::sqrt(std::max({ glm::dot(Vec3(transform[0]), Vec3(transform[0])), glm::dot(Vec3(transform[1]), Vec3(transform[1])), glm::dot(Vec3(transform[2]), Vec3(transform[2])) }));
+                    this->instanceBounds.Set(record.firstInstance + i, Vec3(transform * Vec4(center, 1.f)), record.bounds.w * scale);
+                }
+            }
+            this->instanceVisibility.resize(this->instanceBounds.Size());
+            this->instanceBoundsStale = false;
+        }
+
+        // Batches beyond the first go to the culling threads while the render thread tests the first
+        const Frustum frustum = this->camera.ViewFrustum();
+        const UInt count = this->instanceBounds.Size();
+        std::vector<std::future<void>> batches;
+        for (UInt begin = VkResourceManager::cullBatchSize; begin < count; begin += VkResourceManager::cullBatchSize)
+            batches.push_back(this->cullThreads.Submit([this, &frustum, begin, end = std::min(count, begin + VkResourceManager::cullBatchSize)]() {
+                this->instanceBounds.Cull(frustum, begin, end, this->instanceVisibility.data());
+            }));
+        this->instanceBounds.Cull(frustum, 0, std::min(count, VkResourceManager::cullBatchSize), this->instanceVisibility.data());
+        for (std::future<void>& batch : batches)
+            batch.get();
+    }
 
-        ATR::OS::Execute("rmdir /s /q bin\\shaders");
-        ATR::OS::Execute("mkdir bin");
-        ATR::OS::Execute("mkdir bin\\shaders");
-        ATR::OS::Execute(compilerPath + " " + "shaders\\shader.vert -o bin\\shaders\\vert.spv");
-        ATR::OS::Execute(compilerPath + " " + "shaders\\shader.frag -o bin\\shaders\\frag.spv");
+    void VkResourceManager::SetCamera(const Camera& camera)
+    {
+        // The aspect ratio stays the swapchain's
+        const Float width = this->camera.width, height = this->camera.height;
+        this->camera = camera;
+        this->camera.width = width;
+        this->camera.height = height;
     }
 
-    std::vector<char> VkResourceManager::ReadShaderCode(const char* path)
+    void VkResourceManager::UploadInstances(UInt frameIndex)
     {
-        std::ifstream file(path, std::ios::ate | std::ios::binary);
-        if (!file.is_open())
-            throw Exception("Failed to open file: " + String(path), ExceptionType::INIT_SHADER);
+        // Culled on the CPU, what is visible changes every frame
+        Bool whole = this->instancesStale[frameIndex] || this->cpuCulling;
+        if (!whole && this->dirtyInstances[frameIndex].first == this->dirtyInstances[frameIndex].second)
+            return;
+
+        const UInt count = this->PlaceInstances();
+        MappedBuffer& instances = this->instanceBuffers[frameIndex];
+        if (this->ReserveMappedBuffer(instances, count, sizeof(InstanceData), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, frameIndex))
+        {
+            this->cullDescriptorsStale[frameIndex] = true;
+            whole = true;                                           // A new buffer starts out empty
+        }
+        if (this->gpuCulling && this->ReserveDeviceBuffer(this->culledInstanceBuffers[frameIndex], count, sizeof(InstanceData), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, frameIndex))
+            this->cullDescriptorsStale[frameIndex] = true;
+        if (this->gpuCulling && this->ReserveDeviceBuffer(this->occludedInstanceBuffers[frameIndex], count, sizeof(UInt), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, frameIndex))
+            this->cullDescriptorsStale[frameIndex] = true;
 
-        size_t fileSize = (size_t)file.tellg();
-        std::vector<char> buffer(fileSize);
-        file.seekg(0);
-        file.read(buffer.data(), fileSize);
-        file.close();
+        InstanceData* target = static_cast<InstanceData*>(instances.mapped);
+        for (UInt id = 0; id != this->meshes.size(); ++id)
+        {
+            MeshRecord& record = this->meshes[id];
+            if (this->cpuCulling)
+            {
+                // Visible instances only, packed at the front of the range
+                const uint8_t* visible = this->instanceVisibility.data() + record.firstInstance;
+                record.visibleInstances = 0;
+                if (record.instances.empty() && visible[0])
+                    target[record.firstInstance + record.visibleInstances++] = { .draw = id };
+                for (UInt i = 0; i != record.instances.size(); ++i)
+                    if (visible[i])
+                        target[record.firstInstance + record.visibleInstances++] = record.instances[i];
+            }
+            else
+            {
+                // Only the part of the range within the dirty span
+                const UInt first = record.firstInstance, last = first + std::max<UInt>(static_cast<UInt>(record.instances.size()), 1);
+                const UInt begin = whole ? first : std::clamp(this->dirtyInstances[frameIndex].first, first, last);
+                const UInt end = whole ? last : std::clamp(this->dirtyInstances[frameIndex].second, first, last);
+                if (begin == end)
+                    continue;
+
+                if (record.instances.empty())
+                    target[first] = { .draw = id };
+                else
+                    std::copy(record.instances.begin() + (begin - first), record.instances.begin() + (end - first), target + begin);
+            }
+        }
+        this->instancesStale[frameIndex] = false;
+        this->dirtyInstances[frameIndex] = {};
+    }
 
-        return buffer;
+    void VkResourceManager::UploadDrawCommands(UInt frameIndex)
+    {
+        // Per-draw data for every slot, indexed by the slot like the instances' draw index
+        MappedBuffer& drawData = this->drawDataBuffers[frameIndex];
+        if (this->ReserveMappedBuffer(drawData, static_cast<UInt>(this->meshes.size()), sizeof(DrawData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, frameIndex))
+        {
+            this->UpdateDrawDataDescriptor(frameIndex);             // Safe: this frame's set is no longer in use
+            this->cullDescriptorsStale[frameIndex] = true;
+        }
+        DrawData* data = static_cast<DrawData*>(drawData.mapped);
+        for (UInt id = 0; id != this->meshes.size(); ++id)
+            data[id] = {
+                .bounds = this->meshes[id].bounds,
+                .textureIndex = this->meshes[id].texture.value_or(this->boundTexture),
+                .command = DrawData::notDrawn,
+                .material = this->meshes[id].material
+            };
+
+        // Materials only change when added, so each frame's copy is rewritten only then
+        if (this->materialsStale[frameIndex])
+        {
+            MappedBuffer& materials = this->materialBuffers[frameIndex];
+            if (this->ReserveMappedBuffer(materials, static_cast<UInt>(this->materials.size()), sizeof(MaterialData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, frameIndex))
+                this->UpdateDrawDataDescriptor(frameIndex);
+            std::copy(this->materials.begin(), this->materials.end(), static_cast<MaterialData*>(materials.mapped));
+            this->materialsStale[frameIndex] = false;
+        }
+
+        // Commands grouped by pipeline, so that each pipeline is bound once and built at most once per frame
+        //  Within a pipeline, by variant, so that the dynamic state changes as rarely as possible
+        //  Meshes culled entirely on the CPU get none
+        std::vector<UInt> drawOrder;
+        for (UInt id = 0; id != this->meshes.size(); ++id)
+            if (this->meshes[id].loaded && this->meshes[id].range.indexCount != 0 && (!this->cpuCulling || this->meshes[id].visibleInstances != 0))
+                drawOrder.push_back(id);
+        std::stable_sort(drawOrder.begin(), drawOrder.end(), [this](UInt a, UInt b) {
+            const UInt variantA = this->meshes[a].pipeline, variantB = this->meshes[b].pipeline;
+            return std::tie(this->pipelineVariants[variantA].pipeline, variantA) < std::tie(this->pipelineVariants[variantB].pipeline, variantB);
+        });
+
+        this->drawCommands.clear();
+        this->drawGroups.clear();
+        for (UInt id : drawOrder)
+        {
+            const MeshRecord& record = this->meshes[id];
+            if (this->drawGroups.empty() || this->drawGroups.back().variant != record.pipeline)
+                this->drawGroups.push_back({ .variant = record.pipeline, .firstCommand = static_cast<UInt>(this->drawCommands.size()), .commandCount = 0 });
+            ++this->drawGroups.back().commandCount;
+            data[id].command = static_cast<UInt>(this->drawCommands.size());
+            this->drawCommands.push_back({
+                .draw = {
+                    .indexCount = record.range.indexCount,
+                    .instanceCount = this->cpuCulling ? record.visibleInstances : std::max<UInt>(static_cast<UInt>(record.instances.size()), 1),
+                    .firstIndex = record.range.firstIndex,
+                    .vertexOffset = static_cast<Int>(record.range.firstVertex),
+                    .firstInstance = record.firstInstance
+                },
+                .group = static_cast<UInt>(this->drawGroups.size() - 1),
+                .groupFirst = this->drawGroups.back().firstCommand
+            });
+        }
+
+        if (!this->indirectDraws)
+            return;
+        const UInt commandCount = static_cast<UInt>(this->drawCommands.size());
+        MappedBuffer& commands = this->drawCommandBuffers[frameIndex];
+        if (this->ReserveMappedBuffer(commands, commandCount, sizeof(DrawCommand), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, frameIndex))
+            this->cullDescriptorsStale[frameIndex] = true;
+        std::copy(this->drawCommands.begin(), this->drawCommands.end(), static_cast<DrawCommand*>(commands.mapped));
+
+        if (!this->gpuCulling)
+            return;
+        // Two-phase occlusion culling writes a second set of commands and counters for the late draws
+        const UInt passes = this->twoPhaseOcclusion ? 2 : 1;
+        if (this->ReserveDeviceBuffer(this->culledCommandBuffers[frameIndex], passes * commandCount, sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, frameIndex))
+            this->cullDescriptorsStale[frameIndex] = true;
+        if (this->ReserveDeviceBuffer(this->cullCounterBuffers[frameIndex], passes * (static_cast<UInt>(this->drawGroups.size()) + commandCount), sizeof(UInt), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, frameIndex))
+            this->cullDescriptorsStale[frameIndex] = true;
+        if (this->cullDescriptorsStale[frameIndex])
+            this->UpdateCullDescriptors(frameIndex);                // Safe like the draw data's
+    }
+
+    void VkResourceManager::UpdateDrawDataDescriptor(UInt frameIndex)
+    {
+        // The draw data at binding 2, and the materials it indexes at binding 3
+        const std::array<VkDescriptorBufferInfo, 2> bufferInfos = { {
+            { .buffer = this->drawDataBuffers[frameIndex].buffer.buffer, .offset = 0, .range = VK_WHOLE_SIZE },
+            { .buffer = this->materialBuffers[frameIndex].buffer.buffer, .offset = 0, .range = VK_WHOLE_SIZE }
+        } };
+
+        std::array<VkWriteDescriptorSet, 2> descriptorWrites;
+        for (UInt i = 0; i != descriptorWrites.size(); ++i)
+            descriptorWrites[i] = {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = this->descriptorSets[frameIndex],
+                .dstBinding = 2 + i,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pBufferInfo = &bufferInfos[i]
+            };
+
+        vkUpdateDescriptorSets(this->device, static_cast<UInt>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+    }
+
+    void VkResourceManager::UpdateCullDescriptors(UInt frameIndex)
+    {
+        // In binding order, see shaders/cull.comp; the depth pyramid and the uniform buffer sit between the last two storage buffers
+        const std::array<VkBuffer, 7> buffers = {
+            this->instanceBuffers[frameIndex].buffer.buffer,
+            this->drawDataBuffers[frameIndex].buffer.buffer,
+            this->drawCommandBuffers[frameIndex].buffer.buffer,
+            this->culledInstanceBuffers[frameIndex].buffer.buffer,
+            this->culledCommandBuffers[frameIndex].buffer.buffer,
+            this->cullCounterBuffers[frameIndex].buffer.buffer,
+            this->occludedInstanceBuffers[frameIndex].buffer.buffer
+        };
+        const std::array<UInt, 7> bindings = { 0, 1, 2, 3, 4, 5, 8 };
+        constexpr UInt pyramidBinding = 6, uniformBinding = 7;
+
+        std::array<VkDescriptorBufferInfo, 8> bufferInfos;
+        std::array<VkWriteDescriptorSet, 9> descriptorWrites;
+        for (UInt i = 0; i != buffers.size(); ++i)
+        {
+            bufferInfos[i] = { .buffer = buffers[i], .offset = 0, .range = VK_WHOLE_SIZE };
+            descriptorWrites[i] = {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = this->cullDescriptorSets[frameIndex],
+                .dstBinding = bindings[i],
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pBufferInfo = &bufferInfos[i]
+            };
+        }
+
+        // Without occlusion culling the shader never reads the pyramid, but the binding still needs an image
+        bufferInfos[buffers.size()] = { .buffer = this->uniformBuffers[frameIndex], .offset = 0, .range = sizeof(UniformBufferObject) };
+        const VkDescriptorImageInfo pyramidInfo = this->occlusionCulling ?
+            VkDescriptorImageInfo{ .sampler = this->depthPyramidSampler, .imageView = this->depthPyramidView, .imageLayout = VK_IMAGE_LAYOUT_GENERAL } :
+            VkDescriptorImageInfo{ .sampler = this->textureSampler, .imageView = this->textures[VkResourceManager::defaultTextureIndex].view, .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+        descriptorWrites[buffers.size()] = {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = this->cullDescriptorSets[frameIndex],
+            .dstBinding = pyramidBinding,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .pImageInfo = &pyramidInfo
+        };
+        descriptorWrites[buffers.size() + 1] = {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = this->cullDescriptorSets[frameIndex],
+            .dstBinding = uniformBinding,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+            .pBufferInfo = &bufferInfos[buffers.size()]
+        };
+
+        vkUpdateDescriptorSets(this->device, static_cast<UInt>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+        this->cullDescriptorsStale[frameIndex] = false;
+    }
+
+    void VkResourceManager::QueueMeshLoad(UInt id, std::function<std::shared_ptr<const Mesh>()> produce)
+    {
+        const UInt version = ++this->meshes[id].requestedVersion;
+        this->loaderPool.Submit([this, id, version, produce = std::move(produce)]() { this->StageMeshLoad(id, version, produce); });
+    }
+
+    void VkResourceManager::StageMeshLoad(UInt id, UInt version, const std::function<std::shared_ptr<const Mesh>()>& produce)
+    {
+        StagedMesh staged = { .id = id, .version = version };
+        try
+        {
+            staged.source = produce();
+            staged.bounds = staged.source->BoundingSphere();
+            this->deviceReady.get();                    // Meshes may be requested before initialization; rethrows if it failed
+            staged.staging = this->StageMesh(*staged.source);
+        }
+        catch (...)
+        {
+            staged.error = std::current_exception();
+        }
+        this->stagedMeshes.Push(std::move(staged));
+    }
+
+    BufferMemory VkResourceManager::StageMesh(const Mesh& mesh)
+    {
+        const VkDeviceSize vertexSize = sizeof(Vertex) * mesh.GetVertices().size();
+        const VkDeviceSize indexSize = sizeof(UInt) * mesh.GetIndices().size();
+
+        BufferMemory staging;
+        if (vertexSize + indexSize == 0)
+            return staging;
+
+        // Buffer creation and mapping only touch objects owned by this thread, so no lock is needed
+        this->CreateStagingBuffer(vertexSize + indexSize, staging.buffer, staging.memory);
+
+        void* data;
+        if (vkMapMemory(this->device, staging.memory, 0, vertexSize + indexSize, 0, &data) != VK_SUCCESS)
+        {
+            vkDestroyBuffer(this->device, staging.buffer, nullptr);
+            vkFreeMemory(this->device, staging.memory, nullptr);
+            throw Exception("Failed to map staging memory", ExceptionType::INIT_BUFFER);
+        }
+            memcpy(data, mesh.GetVertices().data(), static_cast<size_t>(vertexSize));
+            memcpy(static_cast<uint8_t*>(data) + vertexSize, mesh.GetIndices().data(), static_cast<size_t>(indexSize));
+        vkUnmapMemory(this->device, staging.memory);
+
+        return staging;
+    }
+
+    void VkResourceManager::PublishLoadedMeshes()
+    {
+        std::vector<StagedMesh> batch;
+        while (auto staged = this->stagedMeshes.TryPop())
+            batch.push_back(std::move(*staged));
+        if (batch.empty())
+            return;
+
+        // Only the newest version of a slot is published; older ones that arrive late are dropped
+        std::vector<BufferMemory> stagingBuffers;
+        std::vector<StagedMesh*> publishing;
+        for (StagedMesh& staged : batch)
+        {
+            MeshRecord& record = this->meshes[staged.id];
+            const Bool superseded = staged.version <= record.publishedVersion ||
+                std::any_of(batch.begin(), batch.end(), [&](const StagedMesh& other) { return other.id == staged.id && other.version > staged.version; });
+
+            if (staged.staging.buffer != VK_NULL_HANDLE)
+                stagingBuffers.push_back(staged.staging);                  // Released with the submission, or right away below
+            if (superseded)
+                continue;
+
+            if (staged.error)
+            {
+                try
+                {
+                    std::rethrow_exception(staged.error);
+                }
+                catch (const Exception& e)
+                {
+                    ATR_ERROR(e.What())
+                }
+                catch (const std::exception& e)
+                {
+                    ATR_ERROR(e.what())
+                }
+
+                if (!record.settled)
+                    record.published.set_exception(staged.error);
+                record.settled = true;
+                continue;
+            }
+            publishing.push_back(&staged);
+        }
+
+        if (publishing.empty())
+        {
+            for (const BufferMemory& staging : stagingBuffers)
+            {
+                vkDestroyBuffer(this->device, staging.buffer, nullptr);
+                vkFreeMemory(this->device, staging.memory, nullptr);
+            }
+            return;
+        }
+
+        VkCommandBuffer commandBuffer = this->BeginSingleTimeCommands(this->graphicsCommandPool);
+
+            for (StagedMesh* staged : publishing)
+            {
+                MeshRecord& record = this->meshes[staged->id];
+                const UInt vertexCount = static_cast<UInt>(staged->source->GetVertices().size());
+                const UInt indexCount = static_cast<UInt>(staged->source->GetIndices().size());
+
+                std::optional<UInt> firstVertex = this->vertexAllocator.Allocate(vertexCount);
+                std::optional<UInt> firstIndex = this->indexAllocator.Allocate(indexCount);
+                if (!firstVertex || !firstIndex)
+                {
+                    if (firstVertex)
+                        this->vertexAllocator.Free(*firstVertex, vertexCount);
+                    if (firstIndex)
+                        this->indexAllocator.Free(*firstIndex, indexCount);
+
+                    this->GrowGeometryBuffers(commandBuffer, vertexCount, indexCount);
+                    firstVertex = this->vertexAllocator.Allocate(vertexCount);
+                    firstIndex = this->indexAllocator.Allocate(indexCount);
+                }
+
+                // The previous contents of the slot may still be drawn by frames in flight
+                if (record.loaded)
+                    this->retiredResources[this->currentFrameIndex].meshRanges.push_back(record.range);
+
+                record.range = { .firstVertex = *firstVertex, .vertexCount = vertexCount, .firstIndex = *firstIndex, .indexCount = indexCount };
+                record.bounds = staged->bounds;
+                this->instanceBoundsStale = true;
+                record.publishedVersion = staged->version;
+                record.loaded = true;
+
+                if (staged->staging.buffer == VK_NULL_HANDLE)
+                    continue;
+
+                const VkDeviceSize vertexSize = sizeof(Vertex) * vertexCount;
+                const VkBufferCopy vertexRegion = { .srcOffset = 0, .dstOffset = sizeof(Vertex) * record.range.firstVertex, .size = vertexSize };
+                const VkBufferCopy indexRegion = { .srcOffset = vertexSize, .dstOffset = sizeof(UInt) * record.range.firstIndex, .size = sizeof(UInt) * indexCount };
+                if (vertexRegion.size != 0)
+                    vkCmdCopyBuffer(commandBuffer, staged->staging.buffer, this->vertexBuffer, 1, &vertexRegion);
+                if (indexRegion.size != 0)
+                    vkCmdCopyBuffer(commandBuffer, staged->staging.buffer, this->indexBuffer, 1, &indexRegion);
+            }
+
+            VkMemoryBarrier barrier = {
+                .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT
+            };
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        // Submitted before this frame's draw on the same queue, so the new meshes are drawn from this frame on
+        this->SubmitSingleTimeCommands(commandBuffer, this->graphicsCommandPool, this->queues[QueueFamilyIndices::GRAPHICS], std::move(stagingBuffers));
+
+        for (StagedMesh* staged : publishing)
+        {
+            MeshRecord& record = this->meshes[staged->id];
+            if (!record.settled)
+                record.published.set_value();
+            record.settled = true;
+        }
+    }
+
+    void VkResourceManager::GrowGeometryBuffers(VkCommandBuffer commandBuffer, UInt vertexCount, UInt indexCount)
+    {
+        // Both buffers are doubled at least; old contents are copied on the GPU and the old buffers retire with this frame
+        struct GeometryBuffer
+        {
+            VkBuffer& buffer;
+            VkDeviceMemory& memory;
+            RangeAllocator& allocator;
+            VkDeviceSize elementSize;
+            VkBufferUsageFlags usage;
+            UInt required;
+        };
+        std::array<GeometryBuffer, 2> geometryBuffers = { {
+            { this->vertexBuffer, this->vertexBufferMemory, this->vertexAllocator, sizeof(Vertex), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertexCount },
+            { this->indexBuffer, this->indexBufferMemory, this->indexAllocator, sizeof(UInt), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indexCount }
+        } };
+
+        // Copies recorded earlier in this command buffer must land before the old contents are read, and before new ones overwrite the copy
+        VkMemoryBarrier barrier = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT
+        };
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        for (GeometryBuffer& geometry : geometryBuffers)
+        {
+            const UInt oldCapacity = geometry.allocator.Capacity();
+            const UInt newCapacity = std::max(oldCapacity * 2, oldCapacity + geometry.required);
+            ATR_LOG_VERBOSE("Growing geometry buffer from " << oldCapacity << " to " << newCapacity << " elements")
+
+            VkBuffer buffer;
+            VkDeviceMemory memory;
+            this->CreateBuffer(
+                geometry.elementSize * newCapacity,
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | geometry.usage,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                buffer,
+                memory
+            );
+
+            const VkBufferCopy region = { .srcOffset = 0, .dstOffset = 0, .size = geometry.elementSize * oldCapacity };
+            vkCmdCopyBuffer(commandBuffer, geometry.buffer, buffer, 1, &region);
+
+            this->retiredResources[this->currentFrameIndex].buffers.push_back({ .buffer = geometry.buffer, .memory = geometry.memory });
+            geometry.buffer = buffer;
+            geometry.memory = memory;
+            geometry.allocator.Grow(newCapacity);
+        }
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+
+    TextureHandle VkResourceManager::LoadTexture(const String& path)
+    {
+        return this->LoadTexture(std::vector<String>{ path });
+    }
+
+    TextureHandle VkResourceManager::LoadTexture(const std::vector<String>& candidatePaths)
+    {
+        if (candidatePaths.empty())
+            throw Exception("No texture path given", ExceptionType::LOAD_ASSET);
+
+        const LUInt key = VkResourceManager::SourceKey(candidatePaths);
+        if (auto cached = this->textureCache.find(key); cached != this->textureCache.end())
+            if (std::shared_ptr<void> reference = cached->second.reference.lock())
+                return { .slot = cached->second.id, .reference = std::move(reference) };
+
+        UInt slot;
+        if (!this->freeTextureSlots.empty())
+        {
+            slot = this->freeTextureSlots.back();
+            this->freeTextureSlots.pop_back();
+        }
+        else if (this->textureSlotCount != this->textureCapacity)
+            slot = this->textureSlotCount++;
+        else
+            throw Exception("Out of texture slots, cannot load " + candidatePaths.front(), ExceptionType::LOAD_ASSET);
+
+        TextureHandle handle = { .slot = slot, .reference = MakeResourceReference(this->releasedTextures, slot) };
+        this->textureCache[key] = { .id = slot, .reference = handle.reference };
+        this->textureCacheKeys[slot] = key;
+        this->MarkTextureStale(slot);                               // Shows the default texture until uploaded, bindless slots being unwritten before
+
+        // Candidates are ordered by preference, e.g. a BC7 encode followed by a BC1 encode and an uncompressed source
+        const String& path = candidatePaths.front();
+        ATR_LOG_VERBOSE("Queueing texture " << path << " into slot " << slot)
+        this->pendingTextures.push_back({
+            .slot = slot,
+            .image = this->DecodeTexture(path),
+            .fallbackPaths = std::vector<String>(candidatePaths.begin() + 1, candidatePaths.end())
+        });
+        return handle;
+    }
+
+    UInt VkResourceManager::CreateMaterial(const Vec4& color)
+    {
+        this->materials.push_back({ .color = color, .textureIndex = MaterialData::drawTexture });
+        this->materialTextureReferences.emplace_back();
+        this->materialsStale.fill(true);
+        return static_cast<UInt>(this->materials.size() - 1);
+    }
+
+    UInt VkResourceManager::CreateMaterial(const Vec4& color, const TextureHandle& texture)
+    {
+        // The material holds on to the slot, so it outlives every other handle of the texture
+        this->materials.push_back({ .color = color, .textureIndex = texture.slot });
+        this->materialTextureReferences.push_back(texture.reference);
+        this->materialsStale.fill(true);
+        return static_cast<UInt>(this->materials.size() - 1);
+    }
+
+    void VkResourceManager::SetMeshMaterial(const MeshHandle& mesh, UInt material)
+    {
+        // The shaders index the material buffer with it unchecked
+        if (material >= this->materials.size())
+            throw Exception("Invalid material " + std::to_string(material), ExceptionType::UPDATE_RENDER);
+        this->meshes[mesh.id].material = material;
+    }
+
+    LUInt VkResourceManager::SourceKey(const std::vector<String>& paths)
+    {
+        // A rewritten file gets a new key, so edited assets are loaded again instead of served stale
+        LUInt key = hashSeed;
+        for (const String& path : paths)
+        {
+            std::error_code error;
+            const auto modified = std::filesystem::last_write_time(path, error);
+            key = HashString(path, key);
+            key = HashValue(error ? 0 : static_cast<LInt>(modified.time_since_epoch().count()), key);
+        }
+        return key;
+    }
+
+    void VkResourceManager::MountArchive(const String& path)
+    {
+        try
+        {
+            this->archives.push_back(std::make_shared<const AssetArchive>(path));
+        }
+        catch (const Exception& e)
+        {
+            ATR_ERROR(e.What())                     // Assets keep loading from loose files
+        }
+    }
+
+    std::shared_ptr<const AssetArchive> VkResourceManager::FindArchive(const String& path) const
+    {
+        for (auto archive = this->archives.rbegin(); archive != this->archives.rend(); ++archive)
+            if ((*archive)->Contains(path))
+                return *archive;
+        return nullptr;
+    }
+
+    std::future<ImageData> VkResourceManager::DecodeTexture(const String& path)
+    {
+        if (std::shared_ptr<const AssetArchive> archive = this->FindArchive(path))
+            return this->workerPool.Submit([path, archive]() {
+                return archive->Parse(path, [&path](std::istream& stream) { return ImageLoader::Load(path, stream); });
+            });
+
+        auto decoded = std::make_shared<std::promise<ImageData>>();
+        std::future<ImageData> image = decoded->get_future();
+        this->ReadLooseFile(path, this->workerPool,
+            [decoded, path](std::istream& stream) { decoded->set_value(ImageLoader::Load(path, stream)); },
+            [decoded](std::exception_ptr error) { decoded->set_exception(error); });
+        return image;
+    }
+
+    void VkResourceManager::ReadLooseFile(const String& path, ThreadPool& pool, std::function<void(std::istream&)> parse, std::function<void(std::exception_ptr)> fail)
+    {
+        std::error_code error;
+        const uintmax_t size = std::filesystem::file_size(path, error);
+        if (error)
+        {
+            fail(std::make_exception_ptr(Exception("Failed to open file: " + path, ExceptionType::LOAD_ASSET)));
+            return;
+        }
+
+        // Parsing is handed to `pool` so that the I/O thread only ever waits on the ring
+        auto contents = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(size));
+        this->fileReader.Submit({
+            .path = path,
+            .size = contents->size(),
+            .destination = contents->data(),
+            .onComplete = [&pool, contents, parse = std::move(parse), fail = std::move(fail)](std::exception_ptr readError) {
+                pool.Submit([contents, parse, fail, readError]() {
+                    try
+                    {
+                        if (readError)
+                            std::rethrow_exception(readError);
+                        MemoryStream stream(contents->data(), contents->size());
+                        parse(stream);
+                    }
+                    catch (...)
+                    {
+                        fail(std::current_exception());
+                    }
+                });
+            }
+        });
+    }
+
+    void VkResourceManager::ReleaseUnusedResources()
+    {
+        // Cache entries are only dropped if they were not re-pointed at a newer load of the same source meanwhile
+        while (std::optional<UInt> id = this->releasedMeshes->TryPop())
+        {
+            MeshRecord& record = this->meshes[*id];
+            if (record.cacheKey)
+                if (auto cached = this->meshCache.find(*record.cacheKey); cached != this->meshCache.end() && cached->second.id == *id)
+                    this->meshCache.erase(cached);
+
+            if (record.loaded)
+                this->retiredResources[this->currentFrameIndex].meshRanges.push_back(record.range);
+
+            // Loads still running for the slot carry older versions and will be dropped on arrival
+            //  The slot had no instances left (they hold references), so its instance range stays as placed
+            const UInt version = record.requestedVersion, firstInstance = record.firstInstance;
+            record = MeshRecord();
+            record.requestedVersion = version;
+            record.publishedVersion = version;
+            record.firstInstance = firstInstance;
+            this->freeMeshIds.push_back(*id);
+        }
+
+        while (std::optional<UInt> slot = this->releasedTextures->TryPop())
+        {
+            if (auto& key = this->textureCacheKeys[*slot]; key)
+            {
+                if (auto cached = this->textureCache.find(*key); cached != this->textureCache.end() && cached->second.id == *slot)
+                    this->textureCache.erase(cached);
+                key.reset();
+            }
+
+            std::erase_if(this->pendingTextures, [&](const PendingTexture& pending) { return pending.slot == *slot; });
+            if (this->textures[*slot].loaded)
+                this->retiredResources[this->currentFrameIndex].textures.push_back(this->textures[*slot]);
+            this->textures[*slot] = Texture();
+            this->textureResidency[*slot] = TextureResidency();
+            this->MarkTextureStale(*slot);
+            this->freeTextureSlots.push_back(*slot);
+        }
+    }
+
+    void VkResourceManager::UploadPendingTextures()
+    {
+        std::vector<std::pair<UInt, ImageData>> decoded;
+        for (auto iter = this->pendingTextures.begin(); iter != this->pendingTextures.end(); )
+        {
+            if (iter->image.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            {
+                ++iter;
+                continue;
+            }
+
+            try
+            {
+                ImageData image = iter->image.get();
+
+                // Block-compressed data is uploaded as-is, so a format the device cannot sample moves on to the next candidate
+                if (!this->SupportsSampling(image.format))
+                {
+                    if (iter->fallbackPaths.empty())
+                        throw Exception("Device cannot sample texture format " + std::to_string(image.format), ExceptionType::LOAD_ASSET);
+
+                    String path = iter->fallbackPaths.front();
+                    iter->fallbackPaths.erase(iter->fallbackPaths.begin());
+                    ATR_LOG_VERBOSE("Texture format " << image.format << " unsupported, falling back to " << path)
+                    iter->image = this->DecodeTexture(path);
+                    ++iter;
+                    continue;
+                }
+
+                // Without linear blits the chain is filtered on a worker instead, and the slot is checked again next frame
+                //  Streamed textures need their chain on the CPU regardless; a complete chain is never filtered twice
+                if (image.MipLevels() != ImageData::FullMipCount(image.width, image.height) && image.MipLevels() == 1 && image.RGBA8() &&
+                    (this->textureBudget != 0 || !this->SupportsLinearBlit(image.format)))
+                {
+                    iter->image = this->workerPool.Submit([image = std::move(image)]() mutable {
+                        ImageLoader::GenerateMips(image);
+                        return std::move(image);
+                    });
+                    ++iter;
+                    continue;
+                }
+
+                decoded.emplace_back(iter->slot, std::move(image));
+            }
+            catch (const Exception& e)
+            {
+                ATR_ERROR(e.What())                 // The slot keeps showing the default texture
+            }
+            iter = this->pendingTextures.erase(iter);
+        }
+
+        if (decoded.empty())
+            return;
+
+        std::vector<TextureUpload> uploads;
+        for (auto& [slot, image] : decoded)
+        {
+            if (this->textureBudget == 0)
+            {
+                uploads.push_back({ .slot = slot, .image = &image });
+                continue;
+            }
+
+            // Streamed textures start out with their coarse tail only; finer levels follow once feedback asks for them
+            TextureResidency& residency = this->textureResidency[slot];
+            residency.source = std::move(image);
+            residency.coarsestLevel = residency.source.MipLevels() - 1;
+            while (residency.coarsestLevel != 0 &&
+                std::max(residency.source.levels[residency.coarsestLevel - 1].width, residency.source.levels[residency.coarsestLevel - 1].height) <= VkResourceManager::streamingResidentSize)
+                --residency.coarsestLevel;
+            residency.desiredLevel = residency.coarsestLevel;
+            uploads.push_back({ .slot = slot, .image = &residency.source, .baseLevel = residency.coarsestLevel });
+        }
+        this->UploadTextures(uploads);
+    }
+
+    void VkResourceManager::UploadTextures(const std::vector<TextureUpload>& uploads)
+    {
+        ATR_LOG_VERBOSE("Uploading " << uploads.size() << " texture(s)...")
+
+        // All images of the batch share one staging buffer, each level at an aligned offset
+        //  Only levels from the base level on are staged; they are stored contiguously at the end of the image data
+        std::vector<VkDeviceSize> offsets, sizes;
+        offsets.reserve(uploads.size());
+        sizes.reserve(uploads.size());
+
+        VkDeviceSize totalSize = 0;
+        for (const TextureUpload& upload : uploads)
+        {
+            offsets.push_back(totalSize);
+            sizes.push_back(upload.image->Size() - upload.image->levels[upload.baseLevel].offset);
+            totalSize += (sizes.back() + ImageData::levelAlignment - 1) / ImageData::levelAlignment * ImageData::levelAlignment;
+        }
+
+        VkBuffer stagingBuffer;
+        VkDeviceMemory stagingBufferMemory;
+        this->CreateStagingBuffer(totalSize, stagingBuffer, stagingBufferMemory);
+
+        void* data;
+        if (vkMapMemory(this->device, stagingBufferMemory, 0, totalSize, 0, &data) != VK_SUCCESS)
+        {
+            vkDestroyBuffer(this->device, stagingBuffer, nullptr);
+            vkFreeMemory(this->device, stagingBufferMemory, nullptr);
+            throw Exception("Failed to map staging memory", ExceptionType::INIT_BUFFER);
+        }
+            for (size_t i = 0; i != uploads.size(); ++i)
+                memcpy(static_cast<uint8_t*>(data) + offsets[i], uploads[i].image->pixels.data() + uploads[i].image->levels[uploads[i].baseLevel].offset, sizes[i]);
+        vkUnmapMemory(this->device, stagingBufferMemory);
+
+        // Images carrying a single level get their chain blitted on the GPU; cooked chains are copied level by level
+        std::vector<Bool> blitMips(uploads.size());
+        UInt maxBlitLevels = 1;
+
+        std::vector<VkImageMemoryBarrier> toTransferBarriers, toShaderReadBarriers;
+        for (size_t i = 0; i != uploads.size(); ++i)
+        {
+            const ImageData& image = *uploads[i].image;
+            const ImageLevel& base = image.levels[uploads[i].baseLevel];
+            blitMips[i] = image.MipLevels() == 1 && this->SupportsLinearBlit(image.format);
+
+            // A resident image being replaced may still be read by frames in flight
+            Texture& texture = this->textures[uploads[i].slot];
+            if (texture.loaded)
+                this->retiredResources[this->currentFrameIndex].textures.push_back(texture);
+
+            texture.width = base.width;
+            texture.height = base.height;
+            texture.baseLevel = uploads[i].baseLevel;
+            texture.mipLevels = blitMips[i] ? ImageData::FullMipCount(image.width, image.height) : image.MipLevels() - uploads[i].baseLevel;
+            if (blitMips[i])
+                maxBlitLevels = std::max(maxBlitLevels, texture.mipLevels);
+
+            this->CreateImage(
+                texture.width,
+                texture.height,
+                texture.mipLevels,
+                image.format,
+                VK_IMAGE_TILING_OPTIMAL,
+                VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                texture.image,
+                texture.memory
+            );
+            texture.view = this->CreateImageView(texture.image, image.format, VK_IMAGE_ASPECT_COLOR_BIT, texture.mipLevels);
+
+            VkImageMemoryBarrier barrier = {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                .srcAccessMask = 0,
+                .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = texture.image,
+                .subresourceRange = {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .baseMipLevel = 0,
+                    .levelCount = texture.mipLevels,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1
+                }
+            };
+            toTransferBarriers.push_back(barrier);
+
+            // Blitted chains leave every level but the last in TRANSFER_SRC; that transition is appended after the blits
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            if (blitMips[i])
+            {
+                barrier.subresourceRange.baseMipLevel = texture.mipLevels - 1;
+                barrier.subresourceRange.levelCount = 1;
+            }
+            toShaderReadBarriers.push_back(barrier);
+
+            if (blitMips[i] && texture.mipLevels > 1)
+            {
+                barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+                barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+                barrier.subresourceRange.baseMipLevel = 0;
+                barrier.subresourceRange.levelCount = texture.mipLevels - 1;
+                toShaderReadBarriers.push_back(barrier);
+            }
+        }
+
+        // One command buffer for the whole batch: transitions, copies, mip blits and final transitions
+        //  Recorded on the graphics queue, as a transfer-only queue can neither blit nor transition into fragment shader reads
+        VkCommandBuffer commandBuffer = this->BeginSingleTimeCommands(this->graphicsCommandPool);
+
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                0, nullptr, 0, nullptr, static_cast<UInt>(toTransferBarriers.size()), toTransferBarriers.data());
+
+            for (size_t i = 0; i != uploads.size(); ++i)
+            {
+                const ImageData& image = *uploads[i].image;
+                const UInt baseLevel = uploads[i].baseLevel;
+                std::vector<VkBufferImageCopy> regions;
+                for (UInt level = baseLevel; level != image.MipLevels(); ++level)
+                {
+                    regions.push_back({
+                        .bufferOffset = offsets[i] + image.levels[level].offset - image.levels[baseLevel].offset,
+                        .bufferRowLength = 0,
+                        .bufferImageHeight = 0,
+                        .imageSubresource = {
+                            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                            .mipLevel = level - baseLevel,
+                            .baseArrayLayer = 0,
+                            .layerCount = 1
+                        },
+                        .imageOffset = { 0, 0, 0 },
+                        .imageExtent = { image.levels[level].width, image.levels[level].height, 1 }
+                    });
+                }
+                vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, this->textures[uploads[i].slot].image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    static_cast<UInt>(regions.size()), regions.data());
+            }
+
+            // Level by level across the whole batch: one barrier call turns level - 1 of every image into a blit source
+            for (UInt level = 1; level < maxBlitLevels; ++level)
+            {
+                std::vector<VkImageMemoryBarrier> toSourceBarriers;
+                for (size_t i = 0; i != uploads.size(); ++i)
+                {
+                    const Texture& texture = this->textures[uploads[i].slot];
+                    if (!blitMips[i] || level >= texture.mipLevels)
+                        continue;
+
+                    toSourceBarriers.push_back({
+                        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                        .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+                        .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                        .image = texture.image,
+                        .subresourceRange = {
+                            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                            .baseMipLevel = level - 1,
+                            .levelCount = 1,
+                            .baseArrayLayer = 0,
+                            .layerCount = 1
+                        }
+                    });
+                }
+
+                vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                    0, nullptr, 0, nullptr, static_cast<UInt>(toSourceBarriers.size()), toSourceBarriers.data());
+
+                for (size_t i = 0; i != uploads.size(); ++i)
+                {
+                    const Texture& texture = this->textures[uploads[i].slot];
+                    if (!blitMips[i] || level >= texture.mipLevels)
+                        continue;
+
+                    const Int srcWidth = std::max(texture.width >> (level - 1), 1u), srcHeight = std::max(texture.height >> (level - 1), 1u);
+                    const Int dstWidth = std::max(texture.width >> level, 1u), dstHeight = std::max(texture.height >> level, 1u);
+                    VkImageBlit blit = {
+                        .srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1 },
+                        .srcOffsets = { { 0, 0, 0 }, { srcWidth, srcHeight, 1 } },
+                        .dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 },
+                        .dstOffsets = { { 0, 0, 0 }, { dstWidth, dstHeight, 1 } }
+                    };
+                    vkCmdBlitImage(commandBuffer,
+                        texture.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                        texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                        1, &blit, VK_FILTER_LINEAR);
+                }
+            }
+
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                0, nullptr, 0, nullptr, static_cast<UInt>(toShaderReadBarriers.size()), toShaderReadBarriers.data());
+
+        this->SubmitSingleTimeCommands(commandBuffer, this->graphicsCommandPool, this->queues[QueueFamilyIndices::GRAPHICS], { { .buffer = stagingBuffer, .memory = stagingBufferMemory } });
+
+        // Later submissions on the graphics queue are ordered after the upload, so the textures are usable right away
+        for (const TextureUpload& upload : uploads)
+        {
+            this->textures[upload.slot].loaded = true;
+            this->MarkTextureStale(upload.slot);
+        }
+    }
+
+    void VkResourceManager::UpdateTextureResidency()
+    {
+        // Feedback: a streamed texture falls back to its always-resident tail, unless a mesh drawn with it covers enough of the screen
+        //  The texture is taken to span its mesh once, so the level is the texture's size over the mesh's projected diameter
+        for (UInt slot = 0; slot != this->textureSlotCount; ++slot)
+            this->textureResidency[slot].desiredLevel = this->textureResidency[slot].coarsestLevel;
+
+        for (const MeshRecord& record : this->meshes)
+        {
+            if (!record.loaded)
+                continue;
+
+            // The same choice as the vertex shader: the material's texture, else the mesh's own or the bound one
+            const UInt materialTexture = this->materials[record.material].textureIndex;
+            const UInt slot = materialTexture != MaterialData::drawTexture ? materialTexture : record.texture.value_or(this->boundTexture);
+            if (slot >= this->textureSlotCount || !this->textureResidency[slot].Streamed() || !this->textures[slot].loaded)
+                continue;
+
+            const Float diameter = this->EstimateScreenDiameter(record);
+            if (diameter < 1.f)
+                continue;
+            TextureResidency& residency = this->textureResidency[slot];
+            const Float level = std::log2(static_cast<Float>(std::max(residency.source.width, residency.source.height)) / diameter);
+            residency.desiredLevel = std::min(residency.desiredLevel, static_cast<UInt>(std::max(level, 0.f)));
+        }
+
+        // Fit the budget by coarsening whichever texture occupies the most memory, never past its resident tail
+        // Slots past `textureSlotCount` have never been handed out
+        std::vector<UInt> targetLevels(this->textureSlotCount);
+        VkDeviceSize totalSize = 0;
+        for (UInt slot = 0; slot != this->textureSlotCount; ++slot)
+        {
+            targetLevels[slot] = this->textureResidency[slot].desiredLevel;
+            if (this->textureResidency[slot].Streamed())
+                totalSize += this->textureResidency[slot].ResidentSize(targetLevels[slot]);
+        }
+
+        while (totalSize > this->textureBudget)
+        {
+            UInt victim = this->textureSlotCount;
+            size_t largestSize = 0;
+            for (UInt slot = 0; slot != this->textureSlotCount; ++slot)
+            {
+                const TextureResidency& residency = this->textureResidency[slot];
+                if (residency.Streamed() && targetLevels[slot] < residency.coarsestLevel && residency.ResidentSize(targetLevels[slot]) > largestSize)
+                {
+                    victim = slot;
+                    largestSize = residency.ResidentSize(targetLevels[slot]);
+                }
+            }
+            if (victim == this->textureSlotCount)
+                break;                              // Only resident tails are left, which stay regardless of the budget
+
+            ++targetLevels[victim];
+            totalSize -= largestSize - this->textureResidency[victim].ResidentSize(targetLevels[victim]);
+        }
+
+        // Evictions always go through; stream-ins are capped per update, the rest follows on later updates
+        std::vector<TextureUpload> uploads;
+        VkDeviceSize streamedSize = 0;
+        for (UInt slot = 0; slot != this->textureSlotCount; ++slot)
+        {
+            const TextureResidency& residency = this->textureResidency[slot];
+            if (!residency.Streamed() || !this->textures[slot].loaded || targetLevels[slot] == this->textures[slot].baseLevel)
+                continue;
+
+            if (targetLevels[slot] < this->textures[slot].baseLevel)
+            {
+                if (!uploads.empty() && streamedSize + residency.ResidentSize(targetLevels[slot]) > VkResourceManager::streamingUploadLimit)
+                    continue;
+                streamedSize += residency.ResidentSize(targetLevels[slot]);
+            }
+
+            ATR_LOG_VERBOSE("Texture " << slot << " now resident from level " << targetLevels[slot] << " (was " << this->textures[slot].baseLevel << ")")
+            uploads.push_back({ .slot = slot, .image = &residency.source, .baseLevel = targetLevels[slot] });
+        }
+
+        if (!uploads.empty())
+            this->UploadTextures(uploads);
+    }
+
+    void VkResourceManager::DestroyRetiredResources(UInt frameIndex)
+    {
+        // Called once the frame's fence has signaled: the frames that could read these resources have all completed
+        RetiredResources& retired = this->retiredResources[frameIndex];
+        for (const Texture& texture : retired.textures)
+            this->DestroyTexture(texture);
+        for (const BufferMemory& buffer : retired.buffers)
+        {
+            vkDestroyBuffer(this->device, buffer.buffer, nullptr);
+            vkFreeMemory(this->device, buffer.memory, nullptr);
+        }
+        for (const MeshRange& range : retired.meshRanges)
+        {
+            this->vertexAllocator.Free(range.firstVertex, range.vertexCount);
+            this->indexAllocator.Free(range.firstIndex, range.indexCount);
+        }
+        for (VkPipeline pipeline : retired.pipelines)
+            vkDestroyPipeline(this->device, pipeline, nullptr);
+        retired = {};
+    }
+
+    void VkResourceManager::DestroyTexture(const Texture& texture)
+    {
+        vkDestroyImageView(this->device, texture.view, nullptr);
+        vkDestroyImage(this->device, texture.image, nullptr);
+        vkFreeMemory(this->device, texture.memory, nullptr);
+    }
+
+    void VkResourceManager::UpdateTextureDescriptors(UInt frameIndex)
+    {
+        // Only the slots that changed since the frame's set was last written, each once
+        std::vector<UInt>& slots = this->staleTextureSlots[frameIndex];
+        std::sort(slots.begin(), slots.end());
+        slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+
+        std::vector<VkDescriptorImageInfo> imageInfos(slots.size());
+        std::vector<VkWriteDescriptorSet> descriptorWrites(slots.size());
+        for (size_t i = 0; i != slots.size(); ++i)
+        {
+            const Texture& texture = this->textures[slots[i]].loaded ? this->textures[slots[i]] : this->textures[VkResourceManager::defaultTextureIndex];
+            imageInfos[i] = {
+                .sampler = this->textureSampler,
+                .imageView = texture.view,
+                .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+            };
+            descriptorWrites[i] = {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = this->descriptorSets[frameIndex],
+                .dstBinding = 1,
+                .dstArrayElement = slots[i],
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                .pImageInfo = &imageInfos[i]
+            };
+        }
+
+        vkUpdateDescriptorSets(this->device, static_cast<UInt>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+        slots.clear();
+    }
+
+    void VkResourceManager::MarkTextureStale(UInt slot)
+    {
+        // Every frame's set is rewritten on its own turn, once its previous use has completed
+        for (std::vector<UInt>& slots : this->staleTextureSlots)
+            slots.push_back(slot);
+    }
+
+    void VkResourceManager::ReleaseFinishedStagings(Bool waitAll)
+    {
+        for (auto iter = this->stagingSubmissions.begin(); iter != this->stagingSubmissions.end(); )
+        {
+            if (waitAll)
+                vkWaitForFences(this->device, 1, &iter->fence, VK_TRUE, UINT64_MAX);
+            else if (vkGetFenceStatus(this->device, iter->fence) != VK_SUCCESS)
+            {
+                ++iter;
+                continue;
+            }
+
+            vkFreeCommandBuffers(this->device, iter->commandPool, 1, &iter->commandBuffer);
+            vkDestroyFence(this->device, iter->fence, nullptr);
+            for (const BufferMemory& staging : iter->stagingBuffers)
+            {
+                vkDestroyBuffer(this->device, staging.buffer, nullptr);
+                vkFreeMemory(this->device, staging.memory, nullptr);
+            }
+            iter = this->stagingSubmissions.erase(iter);
+        }
+    }
+
+    void VkResourceManager::CreatePipelineCache()
+    {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(this->physicalDevice, &properties);
+
+        // A cache written by another device, driver or build of it is silently replaced, never handed to the driver
+        std::vector<uint8_t> data;
+        if (!this->pipelineCachePath.empty())
+        {
+            std::ifstream file(this->pipelineCachePath, std::ios::binary);
+            PipelineCacheFileHeader header;
+            if (file.is_open() && file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+            {
+                VkPipelineCacheHeaderVersionOne cacheHeader = {};
+                const Bool matches = std::equal(std::begin(pipelineCacheMagic), std::end(pipelineCacheMagic), header.magic)
+                    && header.vendorID == properties.vendorID && header.deviceID == properties.deviceID && header.driverVersion == properties.driverVersion
+                    && std::equal(std::begin(properties.pipelineCacheUUID), std::end(properties.pipelineCacheUUID), header.pipelineCacheUUID)
+                    && header.dataSize >= sizeof(cacheHeader) && header.dataSize <= (LUInt(1) << 30);
+                if (matches)
+                {
+                    data.resize(static_cast<size_t>(header.dataSize));
+                    if (!file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size())) || HashBytes(data.data(), data.size()) != header.dataHash)
+                        data.clear();
+                    else
+                    {
+                        memcpy(&cacheHeader, data.data(), sizeof(cacheHeader));
+                        if (cacheHeader.headerSize < sizeof(cacheHeader) || cacheHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+                            || cacheHeader.vendorID != properties.vendorID || cacheHeader.deviceID != properties.deviceID
+                            || !std::equal(std::begin(properties.pipelineCacheUUID), std::end(properties.pipelineCacheUUID), cacheHeader.pipelineCacheUUID))
+                            data.clear();
+                    }
+                }
+
+                if (data.empty())
+                    ATR_LOG_VERBOSE("Pipeline cache " << this->pipelineCachePath << " does not match this device or driver, starting empty")
+                else
+                    ATR_LOG_VERBOSE("Loaded " << data.size() << " bytes of pipeline cache")
+            }
+        }
+
+        VkPipelineCacheCreateInfo createInfo = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+            .initialDataSize = data.size(),
+            .pInitialData = data.empty() ? nullptr : data.data()
+        };
+
+        if (vkCreatePipelineCache(this->device, &createInfo, nullptr, &this->pipelineCache) != VK_SUCCESS)
+            throw Exception("Failed to create pipeline cache", ExceptionType::INIT_PIPELINE);
+        this->loadedPipelineCacheHash = data.empty() ? 0 : HashBytes(data.data(), data.size());
+    }
+
+    void VkResourceManager::SavePipelineCache()
+    {
+        if (this->pipelineCachePath.empty() || this->pipelineCache == VK_NULL_HANDLE)
+            return;
+
+        size_t size = 0;
+        if (vkGetPipelineCacheData(this->device, this->pipelineCache, &size, nullptr) != VK_SUCCESS || size == 0)
+            return;
+        std::vector<uint8_t> data(size);
+        if (vkGetPipelineCacheData(this->device, this->pipelineCache, &size, data.data()) != VK_SUCCESS)
+            return;
+        data.resize(size);
+
+        const LUInt hash = HashBytes(data.data(), data.size());
+        if (hash == this->loadedPipelineCacheHash)
+            return;                                 // Nothing new was compiled
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(this->physicalDevice, &properties);
+
+        PipelineCacheFileHeader header = {};
+        std::copy(std::begin(pipelineCacheMagic), std::end(pipelineCacheMagic), header.magic);
+        header.vendorID = properties.vendorID;
+        header.deviceID = properties.deviceID;
+        header.driverVersion = properties.driverVersion;
+        std::copy(std::begin(properties.pipelineCacheUUID), std::end(properties.pipelineCacheUUID), header.pipelineCacheUUID);
+        header.dataSize = data.size();
+        header.dataHash = hash;
+
+        // Written beside the target and renamed over it, so a crash mid-write never leaves a torn cache behind
+        const String temporaryPath = this->pipelineCachePath + ".tmp";
+        {
+            std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+            file.flush();
+            if (!file)
+            {
+                ATR_ERROR("Failed to write pipeline cache " << temporaryPath)
+                return;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temporaryPath, this->pipelineCachePath, error);
+        if (error)
+        {
+            ATR_ERROR("Failed to replace pipeline cache " << this->pipelineCachePath << ": " << error.message())
+            std::filesystem::remove(temporaryPath, error);
+        }
     }
 
-    VkShaderModule VkResourceManager::CreateShaderModule(const std::vector<char>& code)
+    VkShaderModule VkResourceManager::CreateShaderModule(const UInt* code, size_t codeSize)
     {
         VkShaderModuleCreateInfo createInfo{
             .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-            .codeSize = code.size(),
-            .pCode = reinterpret_cast<const UInt*>(code.data())
+            .codeSize = codeSize,
+            .pCode = code
         };
 
         VkShaderModule shaderModule;
@@ -1,9 +1,24 @@
 #pragma once
 #include "atrpch.h"
 
+#include <future>
+#include <unordered_map>
+
+#include "ATRAsyncIO.h"
+#include "ATRFileWatcher.h"
+#include "ATRHash.h"
+#include "ATRLockFreeQueue.h"
+#include "ATRRangeAllocator.h"
+#include "ATRThreadPool.h"
+#include "Loader/Archive/AssetArchive.h"
 #include "Loader/Config/Config.h"
+#include "Loader/Image/Image.h"
+#include "Loader/Mesh/MeshLoader.h"
+#include "Shaders/ShaderCompiler.h"
+#include "Shaders/ShaderReflection.h"
 
 #include "Geometry/Geometry.h"
+#include "Scene/Camera.h"
 #include "VkInfos/VkInfos.h"
 
 namespace ATR
@@ -36,13 +51,17 @@ namespace ATR
         void CreateRenderPass();
         void CreateDescriptorSetLayout();
         void CreateGraphicsPipeline();
+        void CreateCullPipeline();
         void CreateCommandPool();
 
         void CreateDepthBuffer();
+        void CreateDepthPyramid();
         void CreateTextureImage();
+        void CreateTextureSampler();
         void CreateVertexBuffer();
         void CreateIndexBuffer();
         void CreateUniformBuffer();
+        void CreateDrawBuffers();
         void CreateFrameBuffers();
         void CreateDescriptorPool();
         void CreateDescriptorSets();
@@ -52,7 +71,22 @@ namespace ATR
         // Update
         void DrawFrame();
         void RecreateSwapchain();
-        void UpdateImageBuffers();
+        void PublishLoadedMeshes();
+        void UploadPendingTextures();
+        void UpdateTextureDescriptors(UInt frameIndex);
+        void MarkTextureStale(UInt slot);
+        void ReleaseFinishedStagings(Bool waitAll = false);
+        void UpdateTextureResidency();
+        void DestroyRetiredResources(UInt frameIndex);
+        void ReloadChangedShaders();
+        void CollectLoadedShaders();
+        void CollectBuiltPipelines();
+        void ReleaseUnusedResources();
+        void CullInstances();
+        void UploadInstances(UInt frameIndex);
+        void UploadDrawCommands(UInt frameIndex);
+        void UpdateDrawDataDescriptor(UInt frameIndex);
+        void UpdateCullDescriptors(UInt frameIndex);
 
         // Clean Up
         void CleanUpSwapchain();
@@ -84,26 +118,62 @@ namespace ATR
         Bool DeviceSuitable(VkPhysicalDevice device);
         void FindQueueFamilies(VkPhysicalDevice device);
         Bool CheckDeviceExtensionSupport(VkPhysicalDevice device);
+        Bool DeviceHasExtension(const char* extensionName) const;
         void QuerySwapChainSupport(VkPhysicalDevice device);
         void ConfigureSwapChain(SwapChainSupportDetails support);
         void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
         void CreateStagingBuffer(VkDeviceSize size, VkBuffer& stagingBuffer, VkDeviceMemory& stagingBufferMemory);
         void CopyBuffer(VkBuffer src, VkBuffer dst, VkDeviceSize size);
-
-        void CreateImage(UInt width, UInt height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
-        VkImageView CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
+        Bool ReserveMappedBuffer(MappedBuffer& buffer, UInt count, VkDeviceSize elementSize, VkBufferUsageFlags usage, UInt frameIndex);
+        Bool ReserveDeviceBuffer(DeviceBuffer& buffer, UInt count, VkDeviceSize elementSize, VkBufferUsageFlags usage, UInt frameIndex);
+        VkCommandBuffer BeginSingleTimeCommands(VkCommandPool pool);
+        void SubmitSingleTimeCommands(VkCommandBuffer commandBuffer, VkCommandPool pool, VkQueue queue, std::vector<BufferMemory> stagingBuffers);
+        MeshHandle CreateMeshHandle(LUInt cacheKey);
+        UInt PlaceInstances();
+        void QueueMeshLoad(UInt id, std::function<std::shared_ptr<const Mesh>()> produce);
+        void StageMeshLoad(UInt id, UInt version, const std::function<std::shared_ptr<const Mesh>()>& produce);
+        static LUInt SourceKey(const std::vector<String>& paths);
+        std::shared_ptr<const AssetArchive> FindArchive(const String& path) const;
+        std::future<ImageData> DecodeTexture(const String& path);
+        void ReadLooseFile(const String& path, ThreadPool& pool, std::function<void(std::istream&)> parse, std::function<void(std::exception_ptr)> fail);
+        BufferMemory StageMesh(const Mesh& mesh);
+        void GrowGeometryBuffers(VkCommandBuffer commandBuffer, UInt vertexCount, UInt indexCount);
+        void UploadTextures(const std::vector<TextureUpload>& uploads);
+        void DestroyTexture(const Texture& texture);
+
+        void CreateImage(UInt width, UInt height, UInt mipLevels, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
+        VkImageView CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, UInt mipLevels);
         VkFormat FindSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
-        inline VkFormat FindDepthFormat();
+        Bool SupportsLinearBlit(VkFormat format);
+        Bool SupportsSampling(VkFormat format);
+        inline VkFormat FindDepthFormat(VkFormatFeatureFlags features = 0);
         inline bool HasStencilComponent(VkFormat format);
 
-        void CompileShaders();
-        std::vector<char> ReadShaderCode(const char* path);
-        VkShaderModule CreateShaderModule(const std::vector<char>& code);
+        VkShaderModule CreateShaderModule(const UInt* code, size_t codeSize);
+        VkPipeline CreateComputePipeline(const UInt* code, size_t codeSize, VkPipelineLayout layout);
+        VkDescriptorSetLayout GetDescriptorSetLayout(const ShaderLayout& layout, UInt set);
+        VkPipelineLayout GetPipelineLayout(const ShaderLayout& layout);
+        ShaderProgram MakeShaderProgram(std::vector<UInt> vertexCode, std::vector<UInt> fragmentCode, String vertexSource, String fragmentSource, std::vector<String> defines);
+        void ReplaceShaderProgram(UInt id, ShaderProgram program);
+        const PipelineRecord* ResolvePipeline(UInt id) const;
+        void SubmitPipelineBuild(UInt id);
+        void CollectPipelineBuild(UInt id);
+        VkPipeline BuildPipeline(const PipelineState& state, const ShaderProgram& program, VkPipelineLayout layout);
+        void CreatePipelineCache();
+        void SavePipelineCache();
 
         // Update
         void RecordCommandBuffer(VkCommandBuffer commandBuffer, UInt imageIndex);
+        void RecordCullPass(VkCommandBuffer commandBuffer, Bool late);
+        void RecordDepthPyramid(VkCommandBuffer commandBuffer);
+        void RecordDraws(VkCommandBuffer commandBuffer, Bool late, UInt beginCommand, UInt endCommand, const std::vector<const PipelineRecord*>& groupPipelines);
+        void RecordDrawPartition(UInt partition, UInt partitionCount, UInt imageIndex, const std::vector<const PipelineRecord*>& groupPipelines);
+        void BeginMainPass(VkCommandBuffer commandBuffer, UInt imageIndex, Bool resume, Bool secondary);
+        void EndMainPass(VkCommandBuffer commandBuffer, UInt imageIndex, Bool suspend);
+        void SetDynamicState(VkCommandBuffer commandBuffer, const DynamicPipelineState& state, const std::optional<DynamicPipelineState>& current);
         UInt FindMemoryType(UInt typeFilter, VkMemoryPropertyFlags properties);
         void UpdateUniformBuffer(UInt imageIndex);
+        Float EstimateScreenDiameter(const MeshRecord& record) const;
 
         // Getter/Setters
         inline String GetUpdateInfo() { return this->updateInfo; }
@@ -111,18 +181,49 @@ namespace ATR
         // Proxy
         inline void AddTriangle(std::array<Vertex, 3> vertices) { this->mesh.AddTriangle(vertices); this->meshStale = true; }
         inline void UpdateMesh(const Mesh& mesh) { this->mesh.UpdateMesh(mesh); this->meshStale = true; }
+        MeshHandle LoadMesh(const String& path);
+        MeshHandle LoadMesh(Mesh mesh);
+        TextureHandle LoadTexture(const String& path);
+        TextureHandle LoadTexture(const std::vector<String>& candidatePaths);
+        void MountArchive(const String& path);
+        inline void BindTexture(const TextureHandle& texture) { this->boundTexture = texture.slot; this->boundTextureReference = texture.reference; }
+        inline void SetMeshTexture(const MeshHandle& mesh, const TextureHandle& texture) { this->meshes[mesh.id].texture = texture.slot; this->meshes[mesh.id].textureReference = texture.reference; }
+        UInt CreateMaterial(const Vec4& color);
+        UInt CreateMaterial(const Vec4& color, const TextureHandle& texture);
+        void SetMeshMaterial(const MeshHandle& mesh, UInt material);
+        UInt RegisterShaderProgram(std::vector<UInt> vertexCode, std::vector<UInt> fragmentCode, String vertexSource = "", String fragmentSource = "", std::vector<String> defines = {});
+        UInt LoadShaderProgram(const String& vertexPath, const String& fragmentPath, const std::vector<String>& defines = {});
+        PipelineHandle GetPipeline(const PipelineState& state);
+        inline void SetMeshPipeline(const MeshHandle& mesh, const PipelineHandle& pipeline) { this->meshes[mesh.id].pipeline = pipeline.id; }
+        InstanceHandle AddInstance(const MeshHandle& mesh, const Mat4& transform, const Vec4& color);
+        void UpdateInstance(const InstanceHandle& instance, const Mat4& transform, const Vec4& color);
+        void RemoveInstance(const InstanceHandle& instance);
+        void SetCamera(const Camera& camera);
+        inline const Camera& GetCamera() const { return this->camera; }
 
     private:
         // Configs
         UInt width, height;
         Bool enabledValidation;
         String relLocation;
+        VkDeviceSize textureBudget = 0;                                 // In bytes; 0 disables streaming
+        String pipelineCachePath;
+        String shaderDirectory;
+        Bool dynamicRenderingRequested = false;
+        Bool extendedDynamicStateRequested = false;
+        Bool gpuCullingRequested = false;
+        Bool cpuCullingRequested = false;
+        Bool occlusionCullingRequested = false;
+        Bool twoPhaseOcclusionRequested = false;
+        Bool bindlessRequested = false;
         std::vector<const char*> instanceExtensions;
         std::vector<const char*> validationLayers;
 
         const std::vector<const char*> deviceExtensions = {
             VK_KHR_SWAPCHAIN_EXTENSION_NAME
         };
+        std::vector<const char*> enabledDeviceExtensions;               // `deviceExtensions` and the optional ones the device offers
+        std::vector<VkExtensionProperties> availableDeviceExtensions;
 
         /// Vulkan Resources
         // Top-level Vulkan Resources
@@ -131,7 +232,7 @@ namespace ATR
 
         // Vulkan Components
         VkPhysicalDevice physicalDevice;
-        VkDevice device;
+        VkDevice device = VK_NULL_HANDLE;
 
         VkSurfaceKHR surface;
         VkSwapchainKHR swapchain;
@@ -140,15 +241,17 @@ namespace ATR
         std::vector<VkImageView> swapchainImageViews;
         std::vector<VkFramebuffer> swapchainFrameBuffers;
 
-        VkRenderPass renderPass;
-        VkDescriptorSetLayout descriptorSetLayout;
-        VkPipelineLayout pipelineLayout;                                // Specify Uniforms
-        VkPipeline graphicsPipeline;
+        VkRenderPass renderPass = VK_NULL_HANDLE;                       // Null with dynamic rendering
+        VkRenderPass resumeRenderPass = VK_NULL_HANDLE;                 // Loads what `renderPass` stored, for the late draws of two-phase occlusion culling
+        VkFormat colorFormat, depthFormat;                              // Attachment formats of the main pass
+        VkDescriptorSetLayout descriptorSetLayout;                      // Owned by `descriptorSetLayoutCache`
+        VkPipelineCache pipelineCache = VK_NULL_HANDLE;                 // Persisted to `pipelineCachePath`, so warm starts skip backend compilation
+        LUInt loadedPipelineCacheHash = 0;
 
         VkCommandPool graphicsCommandPool, transferCommandPool;
         std::vector<VkCommandBuffer> graphicsCommandBuffers;
 
-        VkBuffer vertexBuffer, indexBuffer;                             // Actual buffer on device
+        VkBuffer vertexBuffer, indexBuffer;                             // Actual buffer on device, shared by all meshes
         VkDeviceMemory vertexBufferMemory, indexBufferMemory;
 
         VkImage depthImage;
@@ -159,6 +262,8 @@ namespace ATR
         std::vector<VkDeviceMemory> uniformBuffersMemory;
         std::vector<void*> uniformBufferMappedMemory;
 
+        VkSampler textureSampler;
+
         VkDescriptorPool descriptorPool;
         std::vector<VkDescriptorSet> descriptorSets;                    // Allocated from descriptorPool, similar to commandBuffers from commandPool
 
@@ -171,6 +276,36 @@ namespace ATR
         QueueFamilyIndices queueIndices;
         SwapChainSupportDetails swapChainSupport;
         SwapChainConfig swapChainConfig;
+        VkPhysicalDeviceFeatures enabledFeatures = {};
+        UInt apiVersion = VK_API_VERSION_1_0;                           // Highest version both the instance and the device speak
+
+        // Dynamic rendering: the main pass begins on the image views directly, with layouts transitioned by explicit barriers
+        //  Core from Vulkan 1.3, VK_KHR_dynamic_rendering on 1.2; anywhere else the render pass and framebuffers remain
+        Bool dynamicRendering = false;
+        PFN_vkCmdBeginRendering cmdBeginRendering = nullptr;
+        PFN_vkCmdEndRendering cmdEndRendering = nullptr;
+
+        // Extended dynamic state: the state in DynamicPipelineState is set per draw, collapsing pipelines that differ only there
+        //  Core from Vulkan 1.3, VK_EXT_extended_dynamic_state on 1.1
+        Bool extendedDynamicState = false;
+        PFN_vkCmdSetPrimitiveTopology cmdSetPrimitiveTopology = nullptr;
+        PFN_vkCmdSetCullMode cmdSetCullMode = nullptr;
+        PFN_vkCmdSetFrontFace cmdSetFrontFace = nullptr;
+        PFN_vkCmdSetDepthTestEnable cmdSetDepthTestEnable = nullptr;
+        PFN_vkCmdSetDepthWriteEnable cmdSetDepthWriteEnable = nullptr;
+        PFN_vkCmdSetDepthCompareOp cmdSetDepthCompareOp = nullptr;
+
+        // Culling: instances are frustum culled by a compute pass ahead of the main pass, which draws what it wrote
+        //  Needs indirect draws and compute on the graphics queue; draw counts (core 1.2, VK_KHR_draw_indirect_count before) let it compact the draws
+        Bool gpuCulling = false;
+        Bool drawIndirectCount = false;
+        PFN_vkCmdDrawIndexedIndirectCount cmdDrawIndexedIndirectCount = nullptr;
+
+        // Bindless textures: the texture array is runtime sized, partially bound and update-after-bind, holding `textureCapacity` slots
+        //  Descriptor indexing is core from Vulkan 1.2, VK_EXT_descriptor_indexing on 1.1; update-after-bind lifts the array to the far larger
+        //  limits devices have for it, and partial binding leaves slots never used unwritten. The embedded program uses bindless.frag instead
+        Bool bindless = false;
+        UInt textureCapacity = VkResourceManager::maxTextures;
         
         /// -----------------
 
@@ -179,6 +314,7 @@ namespace ATR
 
         // Per-update Invariances
         UInt currentFrameIndex = 0;
+        LUInt frameCount = 0;
         Bool frameBufferResized = false;
         String updateInfo = "";
 
@@ -202,6 +338,25 @@ namespace ATR
         static inline constexpr VkClearValue defaultClearValue = { 0.0f, 0.0f, 0.0f, 1.0f };
         static inline constexpr VkClearValue defaultDepthClearValue = {1.f, 0.f};
         static inline constexpr UInt maxFramesInFlight = 2;
+        static inline constexpr UInt maxTextures = 16;                  // Must match the sampler array in shader.frag
+        static inline constexpr UInt maxBindlessTextures = 1 << 14;     // Capacity of the bindless array, lowered to the device's limits
+        static inline constexpr UInt defaultTextureIndex = 0;           // 1x1 white, bound wherever a texture is missing
+        static inline constexpr UInt streamingResidentSize = 64;        // Levels this size and below never leave the GPU
+        static inline constexpr UInt streamingFeedbackInterval = 16;    // Frames between two residency updates
+        static inline constexpr VkDeviceSize streamingUploadLimit = 32ull << 20;    // Stream-in bytes per residency update
+        static inline constexpr UInt immediateMeshId = 0;               // Built through AddTriangle/UpdateMesh
+        static inline constexpr UInt loaderThreadCount = 2;
+        static inline constexpr UInt pipelineThreadCount = 2;
+        static inline constexpr UInt defaultPipelineId = 0;            // Fallback for pipelines still compiling
+        static inline constexpr UInt initialVertexCapacity = 1 << 16;   // In vertices; geometry buffers double when full
+        static inline constexpr UInt initialIndexCapacity = 1 << 18;
+        static inline constexpr UInt initialInstanceCapacity = 1 << 12; // Instance buffers double when full
+        static inline constexpr UInt initialDrawCapacity = 1 << 10;     // Draw data and command buffers likewise
+        static inline constexpr UInt instanceInputLocation = 4;         // Vertex shader inputs from here on are per instance, see InstanceData
+        static inline constexpr UInt cullGroupSize = 64;                // Must match local_size_x in cull.comp
+        static inline constexpr UInt depthPyramidGroupSize = 8;         // Must match local_size_x and local_size_y in pyramid.comp
+        static inline constexpr UInt cullBatchSize = 1 << 14;           // Spheres per CPU culling job, a multiple of SphereSet::laneCount
+        static inline constexpr UInt recordBatchSize = 1 << 10;         // Draw calls per recording job at least; fewer are recorded inline
 
         // Temporary Global Variables
         /*static inline const std::vector<Vertex> vertices = {
@@ -223,6 +378,144 @@ namespace ATR
 
         Mesh mesh;
 
+        // Meshes: parsed and staged on `loaderPool`, handed over through `stagedMeshes` and copied into the shared buffers at frame boundaries
+        //  `meshes` and the allocators belong to the render thread
+        std::vector<MeshRecord> meshes = std::vector<MeshRecord>(VkResourceManager::immediateMeshId + 1);
+        RangeAllocator vertexAllocator, indexAllocator;
+        LockFreeQueue<StagedMesh> stagedMeshes;
+        std::promise<void> deviceCreated;
+        std::shared_future<void> deviceReady = this->deviceCreated.get_future().share();     // Loader threads stage only once the device exists
+        ThreadPool loaderPool{ VkResourceManager::loaderThreadCount };
+
+        // Layouts: reflected from the shaders' SPIR-V, and shared by every pipeline declaring the same interface
+        std::unordered_multimap<LUInt, CachedSetLayout> descriptorSetLayoutCache;
+        std::unordered_multimap<LUInt, CachedPipelineLayout> pipelineLayoutCache;
+
+        // Pipelines: registered by hashed state, ids are indices into `pipelines` and never move
+        //  Program 0 is the embedded shader pair, pipeline 0 the default state over it, built at init and drawn with while others compile
+        //  Handles name variants, which pair a pipeline with the state set per draw; variant 0 is pipeline 0 in default state
+        //  Builds run on `pipelineThreads` through the shared pipeline cache, which Vulkan synchronizes internally; programs are shared with them
+        std::vector<std::shared_ptr<const ShaderProgram>> shaderPrograms;
+        std::unordered_map<LUInt, UInt> shaderSourcePrograms;          // LoadShaderProgram key of sources and defines to its program, kept past compilation
+        std::vector<PipelineRecord> pipelines;
+        std::unordered_map<LUInt, UInt> pipelineIds;
+        std::vector<PipelineVariant> pipelineVariants;
+        std::unordered_map<LUInt, UInt> pipelineVariantIds;
+        std::vector<UInt> buildingPipelines;                            // Ids with a build to collect
+        ThreadPool pipelineThreads{ VkResourceManager::pipelineThreadCount };
+
+        // Hot reload: edited sources in `shaderDirectory` are recompiled on `pipelineThreads`, and only the pipelines of their programs rebuilt
+        //  Everything is swapped at frame boundaries; replaced pipelines are retired with the frame, no device idling involved
+        std::unique_ptr<FileWatcher> shaderWatcher;                     // Null when hot reload is off
+        ShaderCompiler shaderCompiler;                                  // Immutable once configured, shared by the pipeline threads
+        std::vector<ShaderReload> shaderReloads;
+        std::vector<ShaderLoad> shaderLoads;                            // Programs from LoadShaderProgram, swapped in the same way once compiled
+
+        // Archives: searched newest first before loose files; shared with the loader jobs reading from them
+        std::vector<std::shared_ptr<const AssetArchive>> archives;
+
+        // Cache: meshes and textures are keyed by source path and modification time, or by content, and shared through handles
+        //  Dropped handles report their slot through the release queues; slots are recycled once the release is processed
+        std::unordered_map<LUInt, CachedResource> meshCache, textureCache;
+        std::vector<std::optional<LUInt>> textureCacheKeys = std::vector<std::optional<LUInt>>(VkResourceManager::maxTextures);    // Per texture slot
+        std::shared_ptr<ReleaseQueue> releasedMeshes = std::make_shared<ReleaseQueue>();
+        std::shared_ptr<ReleaseQueue> releasedTextures = std::make_shared<ReleaseQueue>();
+        std::vector<UInt> freeMeshIds, freeTextureSlots;
+
+        // Instances: every mesh slot owns a contiguous range of the instance buffer, all of a mesh's instances drawn in one call
+        std::vector<InstanceSlot> instanceSlots;
+        std::vector<UInt> freeInstanceIds;
+        std::array<MappedBuffer, VkResourceManager::maxFramesInFlight> instanceBuffers;
+        std::array<Bool, VkResourceManager::maxFramesInFlight> instancesStale = {};                      // Ranges moved: rewritten whole
+        std::array<std::pair<UInt, UInt>, VkResourceManager::maxFramesInFlight> dirtyInstances = {};    // Otherwise only this span is copied, empty when equal
+
+        // Draws: one indexed indirect command per drawn mesh, rebuilt every frame and submitted per run of equal pipeline variants
+        //  Per-draw data is indexed by mesh slot, which every instance carries; without `indirectDraws` the commands are issued directly
+        Bool indirectDraws = false;                                     // Needs drawIndirectFirstInstance, since instance ranges are selected by it
+        Bool multiDraw = false;                                         // One call per group: needs multiDrawIndirect and bindless textures
+        std::array<MappedBuffer, VkResourceManager::maxFramesInFlight> drawDataBuffers, drawCommandBuffers;
+        std::vector<DrawCommand> drawCommands;
+        std::vector<DrawGroup> drawGroups;
+        UInt instanceCount = 0;                                         // In the instance buffers, the implicit instances of empty slots included
+
+        // Culled draws: written by the culling pass from the buffers above, see shaders/cull.comp
+        //  Visible instances land in their command's range of `culledInstanceBuffers`, which replaces the instance buffer as vertex input
+        //  Counters hold the draw count of every group, then the visible instances of every command; zeroed at the start of each frame's pass
+        //  With two-phase occlusion culling, the late pass's commands and counters follow the early pass's in the same buffers
+        ShaderLayout cullLayout;
+        VkDescriptorSetLayout cullSetLayout = VK_NULL_HANDLE;           // Owned by `descriptorSetLayoutCache`
+        VkPipelineLayout cullPipelineLayout = VK_NULL_HANDLE;           // Owned by `pipelineLayoutCache`
+        VkPipeline cullPipeline = VK_NULL_HANDLE;
+        std::vector<VkDescriptorSet> cullDescriptorSets;
+        std::array<DeviceBuffer, VkResourceManager::maxFramesInFlight> culledInstanceBuffers, culledCommandBuffers, cullCounterBuffers;
+        std::array<DeviceBuffer, VkResourceManager::maxFramesInFlight> occludedInstanceBuffers;     // Per instance, hidden in the early pass
+        std::array<Bool, VkResourceManager::maxFramesInFlight> cullDescriptorsStale = {};
+
+        // Occlusion culling: the culling pass also tests instances against a pyramid of farthest depths, built by a compute pass after the main pass
+        //  The pyramid is built from the previous frame's depth; in two phases, what it hides is tested again against the pyramid of this frame's
+        //  early draws, and what that reveals is drawn by a second main pass loading the first one's attachments
+        //  Without it, the default texture stands in for the pyramid, which the culling pass never reads then
+        Bool occlusionCulling = false;
+        Bool twoPhaseOcclusion = false;
+        ShaderLayout depthPyramidLayout;
+        VkDescriptorSetLayout depthPyramidSetLayout = VK_NULL_HANDLE;   // Owned by `descriptorSetLayoutCache`
+        VkPipelineLayout depthPyramidPipelineLayout = VK_NULL_HANDLE;   // Owned by `pipelineLayoutCache`
+        VkPipeline depthPyramidPipeline = VK_NULL_HANDLE;
+        VkSampler depthPyramidSampler = VK_NULL_HANDLE;
+
+        // Pyramid resources follow the swapchain's size; always in the general layout
+        //  One descriptor set per level reads the level above (the depth buffer for level 0) and writes the level
+        VkImage depthPyramid = VK_NULL_HANDLE;
+        VkDeviceMemory depthPyramidMemory = VK_NULL_HANDLE;
+        VkImageView depthPyramidView = VK_NULL_HANDLE;
+        std::vector<VkImageView> depthPyramidLevelViews;
+        VkExtent2D depthPyramidExtent = {};
+        VkDescriptorPool depthPyramidDescriptorPool = VK_NULL_HANDLE;
+        std::vector<VkDescriptorSet> depthPyramidDescriptorSets;
+
+        // CPU culling: instead of the pass above, world-space spheres of all instances are tested against the camera's frustum at frame boundaries
+        //  Only visible instances are written to the instance buffers, and meshes with none get no command
+        //  Spheres are indexed like the instance buffers and rebuilt only when instances or meshes change; batches of them are tested on `cullThreads`
+        Bool cpuCulling = false;                                        // Off under GPU culling
+        SphereSet instanceBounds;
+        std::vector<uint8_t> instanceVisibility;
+        Bool instanceBoundsStale = true;
+        ThreadPool cullThreads;
+
+        // Parallel recording: frames with enough draws split them into ranges of commands, each recorded into secondary command buffers
+        //  by its own job (the render thread takes the first) and executed by the primary one; a range records the early and the late draws
+        //  Every range has a pool per frame in flight, reset by the job before recording, so no pool is ever used from two threads
+        Bool parallelRecording = false;
+        std::array<std::vector<VkCommandPool>, VkResourceManager::maxFramesInFlight> recordCommandPools;
+        std::array<std::vector<std::array<VkCommandBuffer, 2>>, VkResourceManager::maxFramesInFlight> secondaryCommandBuffers;     // Early and late draws, per range
+        std::unique_ptr<ThreadPool> recordThreads;                      // Null without parallel recording
+
+        // Textures: decoded on `workerPool`, uploaded in batches at frame boundaries
+        ThreadPool workerPool;
+        std::vector<Texture> textures = std::vector<Texture>(VkResourceManager::maxTextures);     // Grown to `textureCapacity` with the device
+        UInt textureSlotCount = VkResourceManager::defaultTextureIndex + 1;
+        std::vector<PendingTexture> pendingTextures;
+        std::vector<StagingSubmission> stagingSubmissions;
+        std::array<std::vector<UInt>, VkResourceManager::maxFramesInFlight> staleTextureSlots;     // Descriptors to rewrite, per frame
+        UInt boundTexture = VkResourceManager::defaultTextureIndex;
+        std::shared_ptr<void> boundTextureReference;                    // Keeps the bound slot alive
+
+        // Materials: indexed through the draw data, and kept for the renderer's lifetime like shader programs
+        //  Every frame's material buffer is rewritten when materials were added since it was last used
+        std::vector<MaterialData> materials = { { .color = Vec4(1.f), .textureIndex = MaterialData::drawTexture } };
+        std::vector<std::shared_ptr<void>> materialTextureReferences = std::vector<std::shared_ptr<void>>(1);     // Parallel to `materials`
+        std::array<MappedBuffer, VkResourceManager::maxFramesInFlight> materialBuffers;
+        std::array<Bool, VkResourceManager::maxFramesInFlight> materialsStale = {};
+
+        // Streaming: levels are paged between `textureResidency` and the GPU
+        std::vector<TextureResidency> textureResidency = std::vector<TextureResidency>(VkResourceManager::maxTextures);
+        std::array<RetiredResources, VkResourceManager::maxFramesInFlight> retiredResources;
+        UniformBufferObject frameTransforms = { Mat4(1.f), Mat4(1.f), Mat4(1.f), Mat4(1.f), Mat4(1.f) };     // Last frame's transforms, input to the residency feedback
+        Camera camera;                                                  // Width and height follow the swapchain
+
+        // File I/O: loose files are read asynchronously and parsed on the pools above; declared after them so that it is destroyed first
+        AsyncFileReader fileReader;
+
         // Update Infos
         bool meshStale = false;
     };
@@ -0,0 +1,115 @@
+#include "atrpch.h"
+
+#include "ArchiveWriter.h"
+#include "Loader/Archive/LZ4.h"
+
+namespace ATR
+{
+    ArchiveWriter::Statistics ArchiveWriter::Write(const String& path, std::vector<ArchiveInput> inputs, ThreadPool& pool)
+    {
+        for (ArchiveInput& input : inputs)
+            input.name = NormalizeArchiveName(input.name);
+
+        // The index is sorted by hash for binary search, colliding hashes by name
+        std::sort(inputs.begin(), inputs.end(), [](const ArchiveInput& a, const ArchiveInput& b) {
+            const LUInt hashA = ArchiveHash(a.name), hashB = ArchiveHash(b.name);
+            return hashA != hashB ? hashA < hashB : a.name < b.name;
+        });
+        for (size_t i = 1; i < inputs.size(); ++i)
+            if (inputs[i].name == inputs[i - 1].name)
+                throw Exception("Duplicate archive entry " + inputs[i].name, ExceptionType::LOAD_ASSET);
+
+        std::vector<std::future<PackedEntry>> jobs;
+        jobs.reserve(inputs.size());
+        for (const ArchiveInput& input : inputs)
+            jobs.push_back(pool.Submit([&input]() { return ArchiveWriter::Pack(input); }));
+
+        std::vector<PackedEntry> packed;
+        packed.reserve(jobs.size());
+        for (auto& job : jobs)
+            packed.push_back(job.get());
+
+        String names;
+        for (size_t i = 0; i != packed.size(); ++i)
+        {
+            packed[i].entry.nameOffset = static_cast<UInt>(names.size());
+            packed[i].entry.nameLength = static_cast<UInt>(inputs[i].name.size());
+            names += inputs[i].name;
+        }
+
+        auto alignUp = [](LUInt value, LUInt alignment) { return (value + alignment - 1) / alignment * alignment; };
+
+        ArchiveHeader header = {};
+        std::copy(std::begin(archiveMagic), std::end(archiveMagic), header.magic);
+        header.version = archiveVersion;
+        header.entryCount = static_cast<UInt>(packed.size());
+        header.indexOffset = sizeof(ArchiveHeader);
+        header.namesOffset = header.indexOffset + packed.size() * sizeof(ArchiveEntry);
+        header.namesSize = names.size();
+
+        Statistics statistics;
+        LUInt offset = alignUp(header.namesOffset + header.namesSize, archivePageSize);
+        for (PackedEntry& entry : packed)
+        {
+            entry.entry.offset = offset;
+            offset = alignUp(offset + entry.entry.storedSize, archivePageSize);
+
+            statistics.sourceBytes += entry.entry.size;
+            statistics.storedBytes += entry.entry.storedSize;
+            statistics.compressedEntries += entry.entry.compression == ArchiveCompression::LZ4;
+        }
+
+        std::ofstream file(path, std::ios::binary);
+        if (!file.is_open())
+            throw Exception("Failed to open " + path + " for writing", ExceptionType::LOAD_ASSET);
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const PackedEntry& entry : packed)
+            file.write(reinterpret_cast<const char*>(&entry.entry), sizeof(ArchiveEntry));
+        file.write(names.data(), static_cast<std::streamsize>(names.size()));
+
+        const std::vector<char> padding(archivePageSize, 0);
+        for (const PackedEntry& entry : packed)
+        {
+            const LUInt position = static_cast<LUInt>(file.tellp());
+            file.write(padding.data(), static_cast<std::streamsize>(entry.entry.offset - position));
+            file.write(reinterpret_cast<const char*>(entry.payload.data()), static_cast<std::streamsize>(entry.payload.size()));
+        }
+
+        if (!file)
+            throw Exception("Failed to write " + path, ExceptionType::LOAD_ASSET);
+        return statistics;
+    }
+
+    ArchiveWriter::PackedEntry ArchiveWriter::Pack(const ArchiveInput& input)
+    {
+        std::ifstream file(input.path, std::ios::binary | std::ios::ate);
+        if (!file.is_open())
+            throw Exception("Failed to open " + input.path, ExceptionType::LOAD_ASSET);
+
+        PackedEntry packed = {};
+        std::vector<uint8_t> contents(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        if (!file.read(reinterpret_cast<char*>(contents.data()), static_cast<std::streamsize>(contents.size())))
+            throw Exception("Failed to read " + input.path, ExceptionType::LOAD_ASSET);
+
+        packed.entry.hash = ArchiveHash(input.name);
+        packed.entry.size = contents.size();
+
+        std::vector<uint8_t> compressed(LZ4::CompressBound(contents.size()));
+        const size_t compressedSize = LZ4::Compress(contents.data(), contents.size(), compressed.data(), compressed.size());
+        if (compressedSize != 0 && compressedSize <= contents.size() - contents.size() / ArchiveWriter::minSavingDivisor && compressedSize < contents.size())
+        {
+            compressed.resize(compressedSize);
+            packed.payload = std::move(compressed);
+            packed.entry.compression = ArchiveCompression::LZ4;
+        }
+        else
+        {
+            packed.payload = std::move(contents);
+            packed.entry.compression = ArchiveCompression::NONE;
+        }
+        packed.entry.storedSize = packed.payload.size();
+        return packed;
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "atrfwd.h"
+
+#include "ATRThreadPool.h"
+#include "Loader/Archive/ArchiveFormat.h"
+
+namespace ATR
+{
+    struct ArchiveInput
+    {
+        String name;                            // Name the runtime looks the asset up by
+        String path;                            // File the contents are read from
+    };
+
+    // Packs files into an .atrpak readable by AssetArchive
+    //  Entries are compressed in parallel, and kept uncompressed where LZ4 does not pay off (e.g. block-compressed textures)
+    class ArchiveWriter
+    {
+    public:
+        struct Statistics
+        {
+            LUInt sourceBytes = 0, storedBytes = 0;
+            UInt compressedEntries = 0;
+        };
+
+        static Statistics Write(const String& path, std::vector<ArchiveInput> inputs, ThreadPool& pool);
+
+    private:
+        struct PackedEntry
+        {
+            ArchiveEntry entry;
+            std::vector<uint8_t> payload;
+        };
+
+        static PackedEntry Pack(const ArchiveInput& input);
+
+        static inline constexpr LUInt minSavingDivisor = 16;       // LZ4 is only kept when it saves at least 1/16 of the entry
+    };
+}
@@ -0,0 +1,134 @@
+#include "atrpch.h"
+
+#include "ATRThreadPool.h"
+
+#include "ArchiveWriter.h"
+
+#include <charconv>
+#include <filesystem>
+
+namespace
+{
+    using namespace ATR;
+
+    struct PackerOptions
+    {
+        String output;
+        std::vector<String> inputs;
+        String root = ".";
+        UInt threads = 0;
+    };
+
+    void PrintUsage()
+    {
+        ATR_PRINT("Usage: AssetPacker <output.atrpak> <file|directory>... [options]");
+        ATR_PRINT("  --root DIR                           Entries are named by their path relative to DIR, the working directory by default");
+        ATR_PRINT("  --threads N                          Number of compression threads, all cores but one by default");
+    }
+
+    // Whole decimal numbers only; anything else is reported through the usage message
+    std::optional<UInt> ParseCount(const String& text)
+    {
+        UInt value = 0;
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (error != std::errc() || end != text.data() + text.size())
+            return std::nullopt;
+        return value;
+    }
+
+    std::optional<PackerOptions> ParseOptions(int argc, char** argv)
+    {
+        PackerOptions options;
+        std::vector<String> positional;
+        for (int i = 1; i < argc; ++i)
+        {
+            String arg = argv[i];
+            if (arg == "--root" && i + 1 < argc)
+                options.root = argv[++i];
+            else if (arg == "--threads" && i + 1 < argc)
+            {
+                const std::optional<UInt> threads = ParseCount(argv[++i]);
+                if (!threads)
+                    return std::nullopt;
+                options.threads = *threads;
+            }
+            else if (arg.starts_with("--"))
+                return std::nullopt;
+            else
+                positional.push_back(std::move(arg));
+        }
+
+        if (positional.size() < 2)
+            return std::nullopt;
+
+        options.output = positional[0];
+        options.inputs.assign(positional.begin() + 1, positional.end());
+        return options;
+    }
+
+    // Directories are packed recursively; names are relative to the root, as the renderer is asked for them
+    std::vector<ArchiveInput> CollectInputs(const PackerOptions& options)
+    {
+        namespace fs = std::filesystem;
+
+        std::vector<ArchiveInput> inputs;
+        auto add = [&](const fs::path& file) {
+            const fs::path name = fs::relative(file, options.root);
+            if (name.empty() || *name.begin() == "..")
+                throw Exception(file.string() + " is outside of the root " + options.root, ExceptionType::LOAD_ASSET);
+            inputs.push_back({ .name = name.generic_string(), .path = file.string() });
+        };
+
+        for (const String& input : options.inputs)
+        {
+            if (fs::is_directory(input))
+            {
+                for (const auto& item : fs::recursive_directory_iterator(input))
+                    if (item.is_regular_file())
+                        add(item.path());
+            }
+            else if (fs::is_regular_file(input))
+                add(input);
+            else
+                throw Exception("No such file or directory: " + input, ExceptionType::LOAD_ASSET);
+        }
+        return inputs;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    using namespace ATR;
+
+    std::optional<PackerOptions> options = ParseOptions(argc, argv);
+    if (!options)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    try
+    {
+        std::vector<ArchiveInput> inputs = CollectInputs(*options);
+        const size_t count = inputs.size();
+
+        ThreadPool pool(options->threads);
+        ATR_LOG("Packing " << count << " files on " << pool.ThreadCount() << " threads");
+
+        ArchiveWriter::Statistics statistics = ArchiveWriter::Write(options->output, std::move(inputs), pool);
+        ATR_LOG("Written " << options->output << ": " << statistics.sourceBytes << " bytes stored as " << statistics.storedBytes
+            << ", " << statistics.compressedEntries << " of " << count << " entries compressed");
+    }
+    catch (const Exception& e)
+    {
+        ATR_ERROR(e.What());
+        return 1;
+    }
+    catch (const std::filesystem::filesystem_error& e)
+    {
+        ATR_ERROR(String(e.what()));
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,499 @@
+#include "atrpch.h"
+
+#include "BlockEncoder.h"
+
+#if defined __SSE2__ || defined _M_X64 || defined _M_AMD64
+    #define ATR_ENCODER_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace ATR
+{
+    namespace
+    {
+        // Texels of one block with one array per channel, so that four texels fill a SIMD register
+        struct BlockSoA
+        {
+            alignas(16) Float channels[4][16];
+        };
+
+        BlockSoA ToSoA(const BlockEncoder::Block& block)
+        {
+            BlockSoA texels;
+            for (UInt i = 0; i != 16; ++i)
+                for (UInt c = 0; c != 4; ++c)
+                    texels.channels[c][i] = block[i][c];
+            return texels;
+        }
+
+        // Closest palette entry of every texel, measured over the first `channelCount` channels
+        void NearestIndices(const BlockSoA& texels, UInt channelCount, const Float (*palette)[4], UInt paletteSize, uint8_t* indices)
+        {
+#if defined ATR_ENCODER_SSE2
+            for (UInt first = 0; first != 16; first += 4)
+            {
+                __m128 channels[4];
+                for (UInt c = 0; c != channelCount; ++c)
+                    channels[c] = _mm_load_ps(&texels.channels[c][first]);
+
+                __m128 bestError = _mm_set1_ps(std::numeric_limits<Float>::max());
+                __m128i bestIndex = _mm_setzero_si128();
+                for (UInt i = 0; i != paletteSize; ++i)
+                {
+                    __m128 error = _mm_setzero_ps();
+                    for (UInt c = 0; c != channelCount; ++c)
+                    {
+                        __m128 diff = _mm_sub_ps(channels[c], _mm_set1_ps(palette[i][c]));
+                        error = _mm_add_ps(error, _mm_mul_ps(diff, diff));
+                    }
+
+                    __m128i closer = _mm_castps_si128(_mm_cmplt_ps(error, bestError));
+                    bestError = _mm_min_ps(error, bestError);
+                    bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(static_cast<Int>(i))), _mm_andnot_si128(closer, bestIndex));
+                }
+
+                alignas(16) Int lanes[4];
+                _mm_store_si128(reinterpret_cast<__m128i*>(lanes), bestIndex);
+                for (UInt lane = 0; lane != 4; ++lane)
+                    indices[first + lane] = static_cast<uint8_t>(lanes[lane]);
+            }
+#else
+            for (UInt t = 0; t != 16; ++t)
+            {
+                Float bestError = std::numeric_limits<Float>::max();
+                for (UInt i = 0; i != paletteSize; ++i)
+                {
+                    Float error = 0.f;
+                    for (UInt c = 0; c != channelCount; ++c)
+                    {
+                        Float diff = texels.channels[c][t] - palette[i][c];
+                        error += diff * diff;
+                    }
+                    if (error < bestError)
+                    {
+                        bestError = error;
+                        indices[t] = static_cast<uint8_t>(i);
+                    }
+                }
+            }
+#endif
+        }
+
+        Float PaletteError(const BlockSoA& texels, UInt channelCount, const Float (*palette)[4], const uint8_t* indices)
+        {
+            Float error = 0.f;
+            for (UInt t = 0; t != 16; ++t)
+                for (UInt c = 0; c != channelCount; ++c)
+                {
+                    Float diff = texels.channels[c][t] - palette[indices[t]][c];
+                    error += diff * diff;
+                }
+            return error;
+        }
+
+        // Endpoints spanning the texels along their principal axis, found by power iteration on the covariance
+        void PrincipalEndpoints(const BlockSoA& texels, UInt channelCount, Float (&e0)[4], Float (&e1)[4])
+        {
+            Float mean[4] = {}, low[4], high[4];
+            for (UInt c = 0; c != channelCount; ++c)
+            {
+                low[c] = *std::min_element(texels.channels[c], texels.channels[c] + 16);
+                high[c] = *std::max_element(texels.channels[c], texels.channels[c] + 16);
+                for (UInt t = 0; t != 16; ++t)
+                    mean[c] += texels.channels[c][t] / 16.f;
+            }
+
+            Float covariance[4][4] = {};
+            for (UInt t = 0; t != 16; ++t)
+                for (UInt i = 0; i != channelCount; ++i)
+                    for (UInt j = 0; j != channelCount; ++j)
+                        covariance[i][j] += (texels.channels[i][t] - mean[i]) * (texels.channels[j][t] - mean[j]);
+
+            // The bounding box diagonal is a good first guess, and converges in a handful of iterations
+            Float axis[4] = {};
+            for (UInt c = 0; c != channelCount; ++c)
+                axis[c] = high[c] - low[c];
+
+            for (UInt iteration = 0; iteration != 8; ++iteration)
+            {
+                Float next[4] = {};
+                for (UInt i = 0; i != channelCount; ++i)
+                    for (UInt j = 0; j != channelCount; ++j)
+                        next[i] += covariance[i][j] * axis[j];
+
+                Float norm = 0.f;
+                for (UInt c = 0; c != channelCount; ++c)
+                    norm = std::max(norm, std::abs(next[c]));
+                if (norm == 0.f)
+                    break;
+                for (UInt c = 0; c != channelCount; ++c)
+                    axis[c] = next[c] / norm;
+            }
+
+            Float length = 0.f;
+            for (UInt c = 0; c != channelCount; ++c)
+                length += axis[c] * axis[c];
+
+            Float tMin = 0.f, tMax = 0.f;
+            if (length > 0.f)
+            {
+                tMin = std::numeric_limits<Float>::max();
+                tMax = std::numeric_limits<Float>::lowest();
+                for (UInt t = 0; t != 16; ++t)
+                {
+                    Float projection = 0.f;
+                    for (UInt c = 0; c != channelCount; ++c)
+                        projection += (texels.channels[c][t] - mean[c]) * axis[c];
+                    tMin = std::min(tMin, projection / length);
+                    tMax = std::max(tMax, projection / length);
+                }
+            }
+
+            for (UInt c = 0; c != 4; ++c)
+            {
+                e0[c] = c < channelCount ? std::clamp(mean[c] + tMax * axis[c], 0.f, 255.f) : 255.f;
+                e1[c] = c < channelCount ? std::clamp(mean[c] + tMin * axis[c], 0.f, 255.f) : 255.f;
+            }
+        }
+
+        // Least-squares endpoints for fixed indices; weights[i] is the share of e1 in palette entry i
+        Bool RefitEndpoints(const BlockSoA& texels, UInt channelCount, const uint8_t* indices, const Float* weights, Float (&e0)[4], Float (&e1)[4])
+        {
+            Float aa = 0.f, ab = 0.f, bb = 0.f;
+            Float ax[4] = {}, bx[4] = {};
+            for (UInt t = 0; t != 16; ++t)
+            {
+                const Float b = weights[indices[t]], a = 1.f - b;
+                aa += a * a;
+                ab += a * b;
+                bb += b * b;
+                for (UInt c = 0; c != channelCount; ++c)
+                {
+                    ax[c] += a * texels.channels[c][t];
+                    bx[c] += b * texels.channels[c][t];
+                }
+            }
+
+            const Float determinant = aa * bb - ab * ab;
+            if (std::abs(determinant) < 1e-6f)
+                return false;
+
+            for (UInt c = 0; c != channelCount; ++c)
+            {
+                e0[c] = std::clamp((bb * ax[c] - ab * bx[c]) / determinant, 0.f, 255.f);
+                e1[c] = std::clamp((aa * bx[c] - ab * ax[c]) / determinant, 0.f, 255.f);
+            }
+            return true;
+        }
+
+        struct BitWriter
+        {
+            uint8_t* out;
+            UInt position = 0;
+
+            void Write(UInt value, UInt bitCount)
+            {
+                for (UInt bit = 0; bit != bitCount; ++bit, ++position)
+                    if ((value >> bit) & 1)
+                        out[position / 8] |= static_cast<uint8_t>(1 << (position % 8));
+            }
+        };
+
+        /// BC1
+        uint16_t To565(const Float (&color)[4])
+        {
+            UInt r = static_cast<UInt>(std::clamp(color[0] * 31.f / 255.f + 0.5f, 0.f, 31.f));
+            UInt g = static_cast<UInt>(std::clamp(color[1] * 63.f / 255.f + 0.5f, 0.f, 63.f));
+            UInt b = static_cast<UInt>(std::clamp(color[2] * 31.f / 255.f + 0.5f, 0.f, 31.f));
+            return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+        }
+
+        void From565(uint16_t packed, Float (&color)[4])
+        {
+            UInt r = packed >> 11, g = (packed >> 5) & 63, b = packed & 31;
+            color[0] = static_cast<Float>((r << 3) | (r >> 2));
+            color[1] = static_cast<Float>((g << 2) | (g >> 4));
+            color[2] = static_cast<Float>((b << 3) | (b >> 2));
+            color[3] = 255.f;
+        }
+
+        struct BC1Fit
+        {
+            uint16_t c0, c1;
+            Float palette[4][4];
+            uint8_t indices[16];
+            Float error;
+        };
+
+        BC1Fit FitBC1(const BlockSoA& texels, const Float (&e0)[4], const Float (&e1)[4])
+        {
+            BC1Fit fit;
+            fit.c0 = To565(e0);
+            fit.c1 = To565(e1);
+            if (fit.c0 < fit.c1)
+                std::swap(fit.c0, fit.c1);              // c0 > c1 selects the four-color mode
+
+            From565(fit.c0, fit.palette[0]);
+            From565(fit.c1, fit.palette[1]);
+            for (UInt c = 0; c != 4; ++c)
+            {
+                fit.palette[2][c] = (2.f * fit.palette[0][c] + fit.palette[1][c]) / 3.f;
+                fit.palette[3][c] = (fit.palette[0][c] + 2.f * fit.palette[1][c]) / 3.f;
+            }
+
+            // Equal endpoints fall into the three-color mode, where index 0 is the only entry shared with four-color mode
+            NearestIndices(texels, 3, fit.palette, fit.c0 == fit.c1 ? 1 : 4, fit.indices);
+            fit.error = PaletteError(texels, 3, fit.palette, fit.indices);
+            return fit;
+        }
+
+        /// BC7
+        static constexpr UInt bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        struct BC7Endpoint
+        {
+            UInt quantized[4];                          // 7 bits per channel
+            UInt pBit;                                  // Shared lowest bit of all channels
+
+            inline Float Value(UInt channel) const { return static_cast<Float>((quantized[channel] << 1) | pBit); }
+        };
+
+        BC7Endpoint QuantizeBC7(const Float (&endpoint)[4])
+        {
+            BC7Endpoint best = {};
+            Float bestError = std::numeric_limits<Float>::max();
+            for (UInt pBit = 0; pBit != 2; ++pBit)
+            {
+                BC7Endpoint candidate = { .pBit = pBit };
+                Float error = 0.f;
+                for (UInt c = 0; c != 4; ++c)
+                {
+                    candidate.quantized[c] = static_cast<UInt>(std::clamp((endpoint[c] - pBit) / 2.f + 0.5f, 0.f, 127.f));
+                    Float diff = candidate.Value(c) - endpoint[c];
+                    error += diff * diff;
+                }
+                if (error < bestError)
+                {
+                    bestError = error;
+                    best = candidate;
+                }
+            }
+            return best;
+        }
+
+        struct BC7Fit
+        {
+            BC7Endpoint endpoints[2];
+            Float palette[16][4];
+            uint8_t indices[16];
+            Float error;
+        };
+
+        BC7Fit FitBC7(const BlockSoA& texels, const Float (&e0)[4], const Float (&e1)[4])
+        {
+            BC7Fit fit;
+            fit.endpoints[0] = QuantizeBC7(e0);
+            fit.endpoints[1] = QuantizeBC7(e1);
+            for (UInt i = 0; i != 16; ++i)
+                for (UInt c = 0; c != 4; ++c)
+                    fit.palette[i][c] = static_cast<Float>(
+                        ((64 - bc7Weights[i]) * static_cast<UInt>(fit.endpoints[0].Value(c)) + bc7Weights[i] * static_cast<UInt>(fit.endpoints[1].Value(c)) + 32) >> 6);
+
+            NearestIndices(texels, 4, fit.palette, 16, fit.indices);
+            fit.error = PaletteError(texels, 4, fit.palette, fit.indices);
+            return fit;
+        }
+    }
+
+    UInt BlockEncoder::BlockBytes(BlockFormat format)
+    {
+        switch (format)
+        {
+        case BlockFormat::BC1:
+        case BlockFormat::BC4:
+            return 8;
+        case BlockFormat::BC3:
+        case BlockFormat::BC5:
+        case BlockFormat::BC7:
+            return 16;
+        case BlockFormat::RGBA8:
+            return 64;                                  // Uncompressed, a 4x4 block of 4-byte texels
+        }
+        return 0;
+    }
+
+    VkFormat BlockEncoder::VulkanFormat(BlockFormat format, Bool srgb)
+    {
+        switch (format)
+        {
+        case BlockFormat::BC1:
+            return srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+        case BlockFormat::BC3:
+            return srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+        case BlockFormat::BC4:
+            return VK_FORMAT_BC4_UNORM_BLOCK;
+        case BlockFormat::BC5:
+            return VK_FORMAT_BC5_UNORM_BLOCK;
+        case BlockFormat::BC7:
+            return srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+        case BlockFormat::RGBA8:
+            return srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+        }
+        return VK_FORMAT_UNDEFINED;
+    }
+
+    void BlockEncoder::Encode(BlockFormat format, const Block& block, uint8_t* out)
+    {
+        switch (format)
+        {
+        case BlockFormat::BC1:
+            EncodeBC1(block, out);
+            break;
+        case BlockFormat::BC3:
+            EncodeBC3(block, out);
+            break;
+        case BlockFormat::BC4:
+            EncodeBC4(block, 0, out);
+            break;
+        case BlockFormat::BC5:
+            EncodeBC5(block, out);
+            break;
+        case BlockFormat::BC7:
+            EncodeBC7(block, out);
+            break;
+        case BlockFormat::RGBA8:
+            for (UInt i = 0; i != 16; ++i)
+                std::copy(block[i].begin(), block[i].end(), out + i * 4);
+            break;
+        }
+    }
+
+    void BlockEncoder::EncodeBC1(const Block& block, uint8_t* out)
+    {
+        const BlockSoA texels = ToSoA(block);
+
+        Float e0[4], e1[4];
+        PrincipalEndpoints(texels, 3, e0, e1);
+        BC1Fit best = FitBC1(texels, e0, e1);
+
+        // Endpoints are refit against the chosen indices while that keeps lowering the error
+        static constexpr Float weights[4] = { 0.f, 1.f, 1.f / 3.f, 2.f / 3.f };
+        for (UInt iteration = 0; iteration != 2 && best.c0 != best.c1; ++iteration)
+        {
+            std::copy(best.palette[0], best.palette[0] + 4, e0);
+            std::copy(best.palette[1], best.palette[1] + 4, e1);
+            if (!RefitEndpoints(texels, 3, best.indices, weights, e0, e1))
+                break;
+
+            BC1Fit refit = FitBC1(texels, e0, e1);
+            if (refit.error >= best.error)
+                break;
+            best = refit;
+        }
+
+        UInt indexBits = 0;
+        for (UInt t = 0; t != 16; ++t)
+            indexBits |= static_cast<UInt>(best.indices[t]) << (2 * t);
+
+        out[0] = static_cast<uint8_t>(best.c0);
+        out[1] = static_cast<uint8_t>(best.c0 >> 8);
+        out[2] = static_cast<uint8_t>(best.c1);
+        out[3] = static_cast<uint8_t>(best.c1 >> 8);
+        for (UInt byte = 0; byte != 4; ++byte)
+            out[4 + byte] = static_cast<uint8_t>(indexBits >> (8 * byte));
+    }
+
+    void BlockEncoder::EncodeBC3(const Block& block, uint8_t* out)
+    {
+        EncodeBC4(block, 3, out);
+        EncodeBC1(block, out + 8);
+    }
+
+    void BlockEncoder::EncodeBC4(const Block& block, UInt channel, uint8_t* out)
+    {
+        BlockSoA texels = {};
+        for (UInt t = 0; t != 16; ++t)
+            texels.channels[0][t] = block[t][channel];
+
+        const uint8_t high = static_cast<uint8_t>(*std::max_element(texels.channels[0], texels.channels[0] + 16));
+        const uint8_t low = static_cast<uint8_t>(*std::min_element(texels.channels[0], texels.channels[0] + 16));
+
+        // high > low selects the mode with six interpolated values; a flat block simply uses index 0
+        uint8_t indices[16] = {};
+        if (high > low)
+        {
+            Float palette[8][4] = {};
+            palette[0][0] = high;
+            palette[1][0] = low;
+            for (UInt i = 1; i != 7; ++i)
+                palette[i + 1][0] = ((7 - i) * high + i * low) / 7.f;
+            NearestIndices(texels, 1, palette, 8, indices);
+        }
+
+        LUInt indexBits = 0;
+        for (UInt t = 0; t != 16; ++t)
+            indexBits |= static_cast<LUInt>(indices[t]) << (3 * t);
+
+        out[0] = high;
+        out[1] = low;
+        for (UInt byte = 0; byte != 6; ++byte)
+            out[2 + byte] = static_cast<uint8_t>(indexBits >> (8 * byte));
+    }
+
+    void BlockEncoder::EncodeBC5(const Block& block, uint8_t* out)
+    {
+        EncodeBC4(block, 0, out);
+        EncodeBC4(block, 1, out + 8);
+    }
+
+    void BlockEncoder::EncodeBC7(const Block& block, uint8_t* out)
+    {
+        // Mode 6 only: a single subset of RGBA endpoints (7 bits + p-bit) with 4-bit indices
+        const BlockSoA texels = ToSoA(block);
+
+        Float e0[4], e1[4];
+        PrincipalEndpoints(texels, 4, e0, e1);
+        BC7Fit best = FitBC7(texels, e0, e1);
+
+        Float weights[16];
+        for (UInt i = 0; i != 16; ++i)
+            weights[i] = bc7Weights[i] / 64.f;
+
+        for (UInt iteration = 0; iteration != 2; ++iteration)
+        {
+            for (UInt c = 0; c != 4; ++c)
+            {
+                e0[c] = best.endpoints[0].Value(c);
+                e1[c] = best.endpoints[1].Value(c);
+            }
+            if (!RefitEndpoints(texels, 4, best.indices, weights, e0, e1))
+                break;
+
+            BC7Fit refit = FitBC7(texels, e0, e1);
+            if (refit.error >= best.error)
+                break;
+            best = refit;
+        }
+
+        // The most significant index bit of texel 0 is implicit zero; flip the endpoints to make it so
+        if (best.indices[0] & 8)
+        {
+            std::swap(best.endpoints[0], best.endpoints[1]);
+            for (auto& index : best.indices)
+                index = static_cast<uint8_t>(15 - index);
+        }
+
+        std::fill(out, out + 16, 0);
+        BitWriter writer = { .out = out };
+        writer.Write(1 << 6, 7);
+        for (UInt c = 0; c != 4; ++c)
+        {
+            writer.Write(best.endpoints[0].quantized[c], 7);
+            writer.Write(best.endpoints[1].quantized[c], 7);
+        }
+        writer.Write(best.endpoints[0].pBit, 1);
+        writer.Write(best.endpoints[1].pBit, 1);
+        for (UInt t = 0; t != 16; ++t)
+            writer.Write(best.indices[t], t == 0 ? 3 : 4);
+    }
+}
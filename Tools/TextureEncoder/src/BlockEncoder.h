@@ -0,0 +1,29 @@
+#pragma once
+#include "atrfwd.h"
+
+namespace ATR
+{
+    enum class BlockFormat
+    {
+        BC1, BC3, BC4, BC5, BC7, RGBA8
+    };
+
+    // Encodes 4x4 blocks of 8-bit RGBA texels into GPU block-compressed formats
+    //  All functions are stateless and thread-safe; the inner nearest-palette search is vectorized with SSE2 where available
+    class BlockEncoder
+    {
+    public:
+        using Block = std::array<std::array<uint8_t, 4>, 16>;
+
+        static UInt BlockBytes(BlockFormat format);
+        static VkFormat VulkanFormat(BlockFormat format, Bool srgb);
+
+        static void Encode(BlockFormat format, const Block& block, uint8_t* out);
+
+        static void EncodeBC1(const Block& block, uint8_t* out);
+        static void EncodeBC3(const Block& block, uint8_t* out);
+        static void EncodeBC4(const Block& block, UInt channel, uint8_t* out);
+        static void EncodeBC5(const Block& block, uint8_t* out);
+        static void EncodeBC7(const Block& block, uint8_t* out);
+    };
+}
@@ -0,0 +1,134 @@
+#include "atrpch.h"
+
+#include "KTX2Writer.h"
+
+namespace ATR
+{
+    void KTX2Writer::Write(const String& path, BlockFormat format, Bool srgb, UInt width, UInt height, const std::vector<std::vector<uint8_t>>& levels)
+    {
+        static constexpr uint8_t identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+        struct
+        {
+            uint8_t identifier[12];
+            UInt vkFormat, typeSize;
+            UInt pixelWidth, pixelHeight, pixelDepth;
+            UInt layerCount, faceCount, levelCount;
+            UInt supercompressionScheme;
+            UInt dfdByteOffset, dfdByteLength, kvdByteOffset, kvdByteLength;
+            LUInt sgdByteOffset, sgdByteLength;
+        } header = {};
+        static_assert(sizeof(header) == 80, "KTX2 header must not be padded");
+
+        struct LevelIndex
+        {
+            LUInt byteOffset, byteLength, uncompressedByteLength;
+        };
+
+        const std::vector<UInt> dfd = BuildDataFormatDescriptor(format, srgb);
+
+        std::copy(std::begin(identifier), std::end(identifier), header.identifier);
+        header.vkFormat = BlockEncoder::VulkanFormat(format, srgb);
+        header.typeSize = 1;
+        header.pixelWidth = width;
+        header.pixelHeight = height;
+        header.faceCount = 1;
+        header.levelCount = static_cast<UInt>(levels.size());
+        header.dfdByteOffset = static_cast<UInt>(sizeof(header) + levels.size() * sizeof(LevelIndex));
+        header.dfdByteLength = static_cast<UInt>(dfd.size() * sizeof(UInt));
+
+        // Level data starts after the descriptor, smallest level first, each aligned to lcm(texel block size, 4)
+        const LUInt alignment = format == BlockFormat::RGBA8 ? 4 : std::max<LUInt>(BlockEncoder::BlockBytes(format), 4);
+        auto align = [alignment](LUInt offset) { return (offset + alignment - 1) / alignment * alignment; };
+
+        std::vector<LevelIndex> levelIndices(levels.size());
+        LUInt offset = align(header.dfdByteOffset + header.dfdByteLength);
+        for (size_t level = levels.size(); level-- != 0;)
+        {
+            levelIndices[level] = { .byteOffset = offset, .byteLength = levels[level].size(), .uncompressedByteLength = levels[level].size() };
+            offset = align(offset + levels[level].size());
+        }
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            throw Exception("Failed to open output file: " + path, ExceptionType::LOAD_ASSET);
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(levelIndices.data()), levelIndices.size() * sizeof(LevelIndex));
+        file.write(reinterpret_cast<const char*>(dfd.data()), dfd.size() * sizeof(UInt));
+
+        static constexpr char padding[16] = {};
+        for (size_t level = levels.size(); level-- != 0;)
+        {
+            file.write(padding, static_cast<std::streamsize>(levelIndices[level].byteOffset - static_cast<LUInt>(file.tellp())));
+            file.write(reinterpret_cast<const char*>(levels[level].data()), levels[level].size());
+        }
+
+        if (!file)
+            throw Exception("Failed to write KTX2 file: " + path, ExceptionType::LOAD_ASSET);
+    }
+
+    std::vector<UInt> KTX2Writer::BuildDataFormatDescriptor(BlockFormat format, Bool srgb)
+    {
+        // Khronos Data Format basic descriptor block; one sample per channel (or per 64-bit half of a compressed block)
+        struct Sample
+        {
+            UInt bitOffset, bitLength, channel;
+            UInt upper;
+        };
+
+        static constexpr UInt colorModelRGBSDA = 1, colorModelBC1A = 128, colorModelBC3 = 130, colorModelBC4 = 131, colorModelBC5 = 132, colorModelBC7 = 134;
+        static constexpr UInt channelAlpha = 15, qualifierLinear = 0x80;
+
+        UInt colorModel = colorModelRGBSDA;
+        std::vector<Sample> samples;
+        switch (format)
+        {
+        case BlockFormat::BC1:
+            colorModel = colorModelBC1A;
+            samples = { { 0, 64, 0, 0xFFFFFFFF } };
+            break;
+        case BlockFormat::BC3:
+            colorModel = colorModelBC3;
+            samples = { { 0, 64, channelAlpha, 0xFFFFFFFF }, { 64, 64, 0, 0xFFFFFFFF } };
+            break;
+        case BlockFormat::BC4:
+            colorModel = colorModelBC4;
+            samples = { { 0, 64, 0, 0xFFFFFFFF } };
+            break;
+        case BlockFormat::BC5:
+            colorModel = colorModelBC5;
+            samples = { { 0, 64, 0, 0xFFFFFFFF }, { 64, 64, 1, 0xFFFFFFFF } };
+            break;
+        case BlockFormat::BC7:
+            colorModel = colorModelBC7;
+            samples = { { 0, 128, 0, 0xFFFFFFFF } };
+            break;
+        case BlockFormat::RGBA8:
+            samples = { { 0, 8, 0, 255 }, { 8, 8, 1, 255 }, { 16, 8, 2, 255 }, { 24, 8, channelAlpha, 255 } };
+            break;
+        }
+
+        const Bool compressed = format != BlockFormat::RGBA8;
+        const UInt blockSize = 24 + 16 * static_cast<UInt>(samples.size());
+
+        std::vector<UInt> dfd;
+        dfd.push_back(4 + blockSize);                                                   // dfdTotalSize
+        dfd.push_back(0);                                                               // vendorId | descriptorType
+        dfd.push_back(2 | (blockSize << 16));                                           // versionNumber | descriptorBlockSize
+        dfd.push_back(colorModel | (1 << 8) | ((srgb ? 2u : 1u) << 16));                // BT.709 primaries, sRGB or linear transfer
+        dfd.push_back(compressed ? (3 | (3 << 8)) : 0);                                 // Texel block dimensions minus one
+        dfd.push_back(compressed ? BlockEncoder::BlockBytes(format) : 4);               // bytesPlane0
+        dfd.push_back(0);
+        for (const Sample& sample : samples)
+        {
+            // Alpha never goes through the transfer function
+            const UInt qualifiers = (srgb && sample.channel == channelAlpha) ? qualifierLinear : 0;
+            dfd.push_back(sample.bitOffset | ((sample.bitLength - 1) << 16) | ((sample.channel | qualifiers) << 24));
+            dfd.push_back(0);
+            dfd.push_back(0);
+            dfd.push_back(sample.upper);
+        }
+        return dfd;
+    }
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include "atrfwd.h"
+
+#include "BlockEncoder.h"
+
+namespace ATR
+{
+    // Serializes a 2D texture into a KTX2 container readable by ImageLoader
+    //  Levels are passed largest first and written without supercompression
+    class KTX2Writer
+    {
+    public:
+        static void Write(const String& path, BlockFormat format, Bool srgb, UInt width, UInt height, const std::vector<std::vector<uint8_t>>& levels);
+
+    private:
+        static std::vector<UInt> BuildDataFormatDescriptor(BlockFormat format, Bool srgb);
+    };
+}
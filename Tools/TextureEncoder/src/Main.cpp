@@ -0,0 +1,173 @@
+#include "atrpch.h"
+
+#include "ATRThreadPool.h"
+#include "Loader/Image/Image.h"
+
+#include "BlockEncoder.h"
+#include "KTX2Writer.h"
+
+#include <charconv>
+
+namespace
+{
+    using namespace ATR;
+
+    struct EncoderOptions
+    {
+        String input, output;
+        BlockFormat format = BlockFormat::BC7;
+        Bool srgb = true;
+        Bool mips = true;
+        UInt threads = 0;
+    };
+
+    void PrintUsage()
+    {
+        ATR_PRINT("Usage: TextureEncoder <input.tga|ppm|pgm> <output.ktx2> [options]");
+        ATR_PRINT("  --format bc1|bc3|bc4|bc5|bc7|rgba8   Target format, bc7 by default");
+        ATR_PRINT("  --linear                             Treat the texels as linear data (normal maps, masks)");
+        ATR_PRINT("  --no-mips                            Only encode the base level");
+        ATR_PRINT("  --threads N                          Number of encoding threads, all cores but one by default");
+    }
+
+    // Whole decimal numbers only; anything else is reported through the usage message
+    std::optional<UInt> ParseCount(const String& text)
+    {
+        UInt value = 0;
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (error != std::errc() || end != text.data() + text.size())
+            return std::nullopt;
+        return value;
+    }
+
+    std::optional<EncoderOptions> ParseOptions(int argc, char** argv)
+    {
+        EncoderOptions options;
+        std::vector<String> positional;
+        for (int i = 1; i < argc; ++i)
+        {
+            String arg = argv[i];
+            if (arg == "--format" && i + 1 < argc)
+            {
+                String name = argv[++i];
+                if (name == "bc1")        options.format = BlockFormat::BC1;
+                else if (name == "bc3")   options.format = BlockFormat::BC3;
+                else if (name == "bc4")   options.format = BlockFormat::BC4;
+                else if (name == "bc5")   options.format = BlockFormat::BC5;
+                else if (name == "bc7")   options.format = BlockFormat::BC7;
+                else if (name == "rgba8") options.format = BlockFormat::RGBA8;
+                else
+                    return std::nullopt;
+            }
+            else if (arg == "--linear")
+                options.srgb = false;
+            else if (arg == "--no-mips")
+                options.mips = false;
+            else if (arg == "--threads" && i + 1 < argc)
+            {
+                const std::optional<UInt> threads = ParseCount(argv[++i]);
+                if (!threads)
+                    return std::nullopt;
+                options.threads = *threads;
+            }
+            else if (arg.starts_with("--"))
+                return std::nullopt;
+            else
+                positional.push_back(std::move(arg));
+        }
+
+        if (positional.size() != 2)
+            return std::nullopt;
+
+        // Single- and dual-channel formats only carry data, never color
+        if (options.format == BlockFormat::BC4 || options.format == BlockFormat::BC5)
+            options.srgb = false;
+
+        options.input = positional[0];
+        options.output = positional[1];
+        return options;
+    }
+
+    // Encodes one level; block rows are independent and are spread over the pool
+    std::vector<uint8_t> EncodeLevel(ThreadPool& pool, BlockFormat format, const ImageData& image, const ImageLevel& level)
+    {
+        const UInt blocksX = (level.width + 3) / 4, blocksY = (level.height + 3) / 4;
+        const UInt blockBytes = BlockEncoder::BlockBytes(format);
+
+        std::vector<uint8_t> encoded(static_cast<size_t>(blocksX) * blocksY * blockBytes);
+        const uint8_t* texels = image.pixels.data() + level.offset;
+
+        std::vector<std::future<void>> rows;
+        rows.reserve(blocksY);
+        for (UInt by = 0; by != blocksY; ++by)
+        {
+            rows.push_back(pool.Submit([&, by]() {
+                BlockEncoder::Block block;
+                for (UInt bx = 0; bx != blocksX; ++bx)
+                {
+                    // Blocks hanging over the edge repeat the last row and column
+                    for (UInt y = 0; y != 4; ++y)
+                        for (UInt x = 0; x != 4; ++x)
+                        {
+                            const UInt px = std::min(bx * 4 + x, level.width - 1), py = std::min(by * 4 + y, level.height - 1);
+                            const uint8_t* texel = texels + (static_cast<size_t>(py) * level.width + px) * ImageData::channels;
+                            std::copy(texel, texel + ImageData::channels, block[y * 4 + x].begin());
+                        }
+                    BlockEncoder::Encode(format, block, encoded.data() + (static_cast<size_t>(by) * blocksX + bx) * blockBytes);
+                }
+            }));
+        }
+        for (auto& row : rows)
+            row.get();
+
+        return encoded;
+    }
+
+    // RGBA8 is stored as is, without padding levels to whole blocks
+    std::vector<uint8_t> CopyLevel(const ImageData& image, const ImageLevel& level)
+    {
+        const uint8_t* texels = image.pixels.data() + level.offset;
+        return std::vector<uint8_t>(texels, texels + level.size);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    using namespace ATR;
+
+    std::optional<EncoderOptions> options = ParseOptions(argc, argv);
+    if (!options)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    try
+    {
+        ImageData image = ImageLoader::Load(options->input);
+        if (!image.RGBA8())
+            throw Exception("Input must be an uncompressed image: " + options->input, ExceptionType::LOAD_ASSET);
+
+        // The format decides whether mips are filtered in linear or sRGB space
+        image.format = options->srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+        if (options->mips)
+            ImageLoader::GenerateMips(image);
+
+        ThreadPool pool(options->threads);
+        ATR_LOG("Encoding " << options->input << " (" << image.width << "x" << image.height << ", " << image.MipLevels() << " levels) on " << pool.ThreadCount() << " threads");
+
+        std::vector<std::vector<uint8_t>> levels;
+        for (const ImageLevel& level : image.levels)
+            levels.push_back(options->format == BlockFormat::RGBA8 ? CopyLevel(image, level) : EncodeLevel(pool, options->format, image, level));
+
+        KTX2Writer::Write(options->output, options->format, options->srgb, image.width, image.height, levels);
+        ATR_LOG("Written " << options->output);
+    }
+    catch (const Exception& e)
+    {
+        ATR_ERROR(e.What());
+        return 1;
+    }
+
+    return 0;
+}
@@ -9,6 +9,33 @@ workspace "Altrar"
     
 outputdir = "%{cfg.buildcfg}-%{cfg.system}-%{cfg.architecture}"
 
+-- glslc from the Vulkan SDK if one is installed, otherwise the copy expected in vendor/bin
+local vulkanSDK = os.getenv("VULKAN_SDK")
+if vulkanSDK then
+    glslc = path.join(vulkanSDK, os.host() == "windows" and "Bin/glslc.exe" or "bin/glslc")
+elseif os.host() == "windows" then
+    glslc = path.getabsolute("vendor/bin/Windows/glslc.exe")
+else
+    glslc = "glslc"
+end
+
+newoption
+{
+    trigger = "with-shaderc",
+    description = "Compile runtime shaders in process through shaderc from the Vulkan SDK instead of spawning glslc"
+}
+
+newoption
+{
+    trigger = "simd",
+    value = "ISA",
+    description = "Instruction set for SIMD code such as CPU culling (see Geometry/SphereSet.h); SSE2 otherwise",
+    allowed = {
+        { "avx2", "AVX2, 8 floats per register" },
+        { "avx512", "AVX-512, 16 floats per register" }
+    }
+}
+
 project "Altrar"    
     location "Altrar"
     kind "ConsoleApp"
@@ -26,14 +53,18 @@ project "Altrar"
     files
     {
         "%{prj.name}/src/**.h",
-        "%{prj.name}/src/**.cpp"
+        "%{prj.name}/src/**.cpp",
+        "%{prj.name}/shaders/**.vert",
+        "%{prj.name}/shaders/**.frag",
+        "%{prj.name}/shaders/**.comp"
     }
 
     includedirs
     {
         "%{prj.name}/src",
         "%{prj.name}/src/Core",
-        "%{prj.name}/ext"
+        "%{prj.name}/ext",
+        "%{cfg.objdir}/shaders"         -- SPIR-V word lists generated from shaders/
     }
 
     libdirs
@@ -47,6 +78,32 @@ project "Altrar"
         "vulkan-1"
     }
 
+    -- Shaders are compiled once per build instead of on every launch; Shaders/EmbeddedShaders.h includes the results
+    filter "files:**.vert or **.frag or **.comp"
+        buildmessage "Compiling shader %{file.name}"
+        buildcommands
+        {
+            '{MKDIR} "%{cfg.objdir}/shaders"',
+            '"' .. glslc .. '" -mfmt=num -o "%{cfg.objdir}/shaders/%{file.name}.inc" "%{file.relpath}"'
+        }
+        buildoutputs { "%{cfg.objdir}/shaders/%{file.name}.inc" }
+
+    -- Runtime shaders (hot reload, LoadShaderProgram) compile in process; see Shaders/ShaderCompiler.h
+    filter "options:with-shaderc"
+        defines "ATR_WITH_SHADERC"
+        includedirs { path.join(vulkanSDK or "", os.host() == "windows" and "Include" or "include") }
+        libdirs { path.join(vulkanSDK or "", os.host() == "windows" and "Lib" or "lib") }
+        links { "shaderc_combined" }
+
+    filter "options:simd=avx2"
+        vectorextensions "AVX2"
+
+    filter { "options:simd=avx512", "toolset:msc*" }
+        buildoptions "/arch:AVX512"
+
+    filter { "options:simd=avx512", "not toolset:msc*" }
+        buildoptions "-mavx512f"
+
     filter "system:Windows"
         staticruntime "off"
         systemversion "latest"
@@ -61,4 +118,84 @@ project "Altrar"
 
     filter "configurations:Release"
         defines "ATR_RELEASE"
-        optimize "on"
\ No newline at end of file
+        optimize "on"
+
+project "TextureEncoder"
+    location "Tools/TextureEncoder"
+    kind "ConsoleApp"
+    language "c++"
+    cppdialect "c++20"
+
+    targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+    objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+    staticruntime "off"
+
+    -- Shares the image decoders and the thread pool with the renderer
+    files
+    {
+        "Tools/%{prj.name}/src/**.h",
+        "Tools/%{prj.name}/src/**.cpp",
+        "Altrar/src/Loader/Image/Image.cpp",
+        "Altrar/src/Core/ATRThreadPool.cpp",
+        "Altrar/src/Core/ATROSSpec.cpp"
+    }
+
+    includedirs
+    {
+        "Altrar/src",
+        "Altrar/src/Core",
+        "Altrar/ext"
+    }
+
+    filter "system:Windows"
+        staticruntime "off"
+        systemversion "latest"
+
+    filter "configurations:Debug"
+        defines "ATR_DEBUG"
+        symbols "on"
+
+    filter "configurations:Release"
+        defines "ATR_RELEASE"
+        optimize "on"
+
+project "AssetPacker"
+    location "Tools/AssetPacker"
+    kind "ConsoleApp"
+    language "c++"
+    cppdialect "c++20"
+
+    targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+    objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+    staticruntime "off"
+
+    -- Shares the archive format, the LZ4 codec and the thread pool with the renderer
+    files
+    {
+        "Tools/%{prj.name}/src/**.h",
+        "Tools/%{prj.name}/src/**.cpp",
+        "Altrar/src/Loader/Archive/LZ4.cpp",
+        "Altrar/src/Core/ATRThreadPool.cpp",
+        "Altrar/src/Core/ATROSSpec.cpp"
+    }
+
+    includedirs
+    {
+        "Altrar/src",
+        "Altrar/src/Core",
+        "Altrar/ext"
+    }
+
+    filter "system:Windows"
+        staticruntime "off"
+        systemversion "latest"
+
+    filter "configurations:Debug"
+        defines "ATR_DEBUG"
+        symbols "on"
+
+    filter "configurations:Release"
+        defines "ATR_RELEASE"
+        optimize "on"